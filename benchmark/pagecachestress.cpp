@@ -0,0 +1,145 @@
+/**
+ * @brief PageCacheManager 并发压力测试
+ *
+ * 多个线程同时 addPage / getPage / removePage，并不断移动当前页和可见页，
+ * 让淘汰（含 NearCurrent 策略和压缩层）持续发生。结束后输出吞吐量和缓存统计，
+ * 并检查内存用量没有超过高水位。
+ *
+ * 用法：PageCacheStress [线程数] [秒数] [页数]
+ */
+#include "pagecachemanager.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <cstdio>
+#include <iterator>
+
+namespace {
+
+constexpr int DEFAULT_SECONDS = 5;
+constexpr int DEFAULT_PAGE_COUNT = 400;
+constexpr int PAGE_SIZE = 256;                      // 每页 256x256 ARGB32 = 256 KB
+constexpr qint64 HIGH_WATERMARK = 64LL * 1024 * 1024;
+constexpr qint64 LOW_WATERMARK = 48LL * 1024 * 1024;
+constexpr qint64 COMPRESSED_BUDGET = 16LL * 1024 * 1024;
+constexpr int VISIBLE_PAGES = 4;
+
+const double ZOOMS[] = {1.0, 1.5, 2.0};
+
+struct Counters {
+    std::atomic<qint64> adds{0};
+    std::atomic<qint64> hits{0};
+    std::atomic<qint64> misses{0};
+    std::atomic<qint64> removes{0};
+    std::atomic<qint64> budgetViolations{0};
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+
+    const int threadCount = args.size() > 1 ? qMax(1, args[1].toInt())
+                                            : qMax(2, QThread::idealThreadCount());
+    const int seconds = args.size() > 2 ? qMax(1, args[2].toInt()) : DEFAULT_SECONDS;
+    const int pageCount = args.size() > 3 ? qMax(VISIBLE_PAGES, args[3].toInt()) : DEFAULT_PAGE_COUNT;
+
+    PageCacheManager cache(HIGH_WATERMARK, LOW_WATERMARK,
+                           PageCacheManager::CacheStrategy::NearCurrent);
+    cache.setCompressedBudget(COMPRESSED_BUDGET);
+
+    // 每个缩放比例一张模板图像，添加时深拷贝，模拟渲染结果各自独立
+    QVector<QImage> templates;
+    for (double zoom : ZOOMS) {
+        QImage image(qRound(PAGE_SIZE * zoom), qRound(PAGE_SIZE * zoom),
+                     QImage::Format_ARGB32_Premultiplied);
+        image.fill(qRgb(240, 240, 240));
+        templates.append(image);
+    }
+
+    // 并发添加时每个线程最多有一页尚未触发淘汰
+    const qint64 budgetSlack = qint64(threadCount) * templates.last().sizeInBytes();
+
+    Counters counters;
+    std::atomic_bool stop{false};
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount + 1);
+
+    // 模拟界面线程：翻页并更新可见页
+    pool.start([&]() {
+        int current = 0;
+        while (!stop.load()) {
+            current = (current + 1) % pageCount;
+            QSet<int> visible;
+            for (int i = 0; i < VISIBLE_PAGES; ++i) {
+                visible.insert((current + i) % pageCount);
+            }
+            cache.setCurrentPage(current, ZOOMS[0], 0);
+            cache.markVisiblePages(visible);
+            QThread::msleep(2);
+        }
+    });
+
+    for (int t = 0; t < threadCount; ++t) {
+        pool.start([&, t]() {
+            QRandomGenerator random(quint32(t + 1));
+            while (!stop.load()) {
+                const int page = int(random.bounded(pageCount));
+                const int zoomIndex = int(random.bounded(int(std::size(ZOOMS))));
+                const double zoom = ZOOMS[zoomIndex];
+                const int op = int(random.bounded(100));
+
+                if (op < 45) {
+                    cache.addPage(page, zoom, 0, templates[zoomIndex].copy());
+                    counters.adds++;
+                } else if (op < 95) {
+                    if (cache.getPage(page, zoom, 0).isNull()) {
+                        counters.misses++;
+                    } else {
+                        counters.hits++;
+                    }
+                } else {
+                    cache.removePage(page, zoom, 0);
+                    counters.removes++;
+                }
+
+                if (cache.memoryUsage() > HIGH_WATERMARK + budgetSlack) {
+                    counters.budgetViolations++;
+                }
+            }
+        });
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QThread::sleep(seconds);
+    stop.store(true);
+    pool.waitForDone();
+    const double elapsedSec = timer.nsecsElapsed() / 1e9;
+
+    const qint64 gets = counters.hits.load() + counters.misses.load();
+    const qint64 total = counters.adds.load() + gets + counters.removes.load();
+
+    std::printf("PageCacheStress: %d threads, %.1f s, %d pages\n", threadCount, elapsedSec, pageCount);
+    std::printf("  ops:      %lld (%.0f ops/s)\n", total, total / elapsedSec);
+    std::printf("  addPage:  %lld (%.0f/s)\n", counters.adds.load(), counters.adds.load() / elapsedSec);
+    std::printf("  getPage:  %lld (%.0f/s), hit rate %.1f%%\n", gets, gets / elapsedSec,
+                gets > 0 ? counters.hits.load() * 100.0 / gets : 0.0);
+    std::printf("  remove:   %lld\n", counters.removes.load());
+    std::printf("  memory:   %.1f MB (high watermark %.1f MB)\n",
+                cache.memoryUsage() / (1024.0 * 1024.0), HIGH_WATERMARK / (1024.0 * 1024.0));
+    std::printf("  over budget samples: %lld\n", counters.budgetViolations.load());
+    std::printf("%s\n", qPrintable(cache.getStatistics()));
+
+    return cache.memoryUsage() <= HIGH_WATERMARK ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+/**
+ * @brief 搜索内核吞吐量对比
+ *
+ * 在随机生成的文本上分别运行精确查找（TextScanner）、正则（QRegularExpression JIT）
+ * 和模糊查找（FuzzyMatcher），输出每种方式的吞吐量（百万字符/秒）和命中数。
+ *
+ * 模糊查找分两组：64 个字符的模式走位并行算法，65 个字符的模式
+ * （前 64 个字符相同）退化为逐列动态规划，两者的差别即位并行带来的收益。
+ *
+ * 用法：SearchBench [文本百万字符数] [重复次数] [最大编辑距离]
+ */
+#include "fuzzymatcher.h"
+#include "textscanner.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QString>
+#include <cstdio>
+#include <functional>
+
+namespace {
+
+constexpr int DEFAULT_MEGA_CHARS = 4;
+constexpr int DEFAULT_REPEATS = 3;
+constexpr int DEFAULT_MAX_EDITS = 2;
+constexpr int PLANT_INTERVAL = 64 * 1024;           // 每隔多少字符植入一次（带错字的）模式
+constexpr int BIT_PARALLEL_LENGTH = 64;
+
+const char PHRASE[] = "the quick brown fox jumps over the lazy dog while "
+                      "scanned documents need approximate matching";
+
+/**
+ * @brief 随机单词组成的文本，定期植入 phrase，其中一半带一个错字
+ */
+QString generateText(qsizetype length, const QString& phrase)
+{
+    QRandomGenerator random(42);
+    QString text;
+    text.reserve(length);
+
+    qsizetype nextPlant = PLANT_INTERVAL;
+    while (text.size() < length) {
+        if (text.size() >= nextPlant) {
+            QString planted = phrase;
+            if (random.bounded(2) == 0) {
+                planted[int(random.bounded(int(planted.size())))] = QChar('#');
+            }
+            text += planted;
+            text += QChar(' ');
+            nextPlant += PLANT_INTERVAL;
+            continue;
+        }
+
+        const int wordLength = 2 + int(random.bounded(8));
+        for (int i = 0; i < wordLength; ++i) {
+            text += QChar('a' + int(random.bounded(26)));
+        }
+        text += QChar(' ');
+    }
+
+    text.truncate(length);
+    return text;
+}
+
+/**
+ * @brief 运行 repeats 次，返回平均每次的秒数；hits 为最后一次的命中数
+ */
+double measure(int repeats, const std::function<qint64()>& run, qint64* hits)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < repeats; ++i) {
+        *hits = run();
+    }
+    return timer.nsecsElapsed() / 1e9 / repeats;
+}
+
+void report(const char* name, qsizetype textLength, double seconds, qint64 hits)
+{
+    std::printf("  %-26s %8.1f Mchar/s  %8.2f ms  %6lld hits\n",
+                name, textLength / seconds / 1e6, seconds * 1e3, hits);
+}
+
+qint64 countExact(QStringView text, const QString& pattern)
+{
+    qint64 hits = 0;
+    qsizetype pos = 0;
+    while ((pos = TextScanner::indexOf(text, pattern, pos)) >= 0) {
+        hits++;
+        pos += pattern.size();
+    }
+    return hits;
+}
+
+qint64 countRegex(const QString& text, const QRegularExpression& regex)
+{
+    qint64 hits = 0;
+    QRegularExpressionMatchIterator it = regex.globalMatch(text);
+    while (it.hasNext()) {
+        it.next();
+        hits++;
+    }
+    return hits;
+}
+
+qint64 countFuzzy(QStringView text, const FuzzyMatcher& matcher)
+{
+    qint64 hits = 0;
+    qsizetype from = 0;
+    qsizetype start = 0;
+    qsizetype length = 0;
+    while (matcher.findNext(text, from, &start, &length)) {
+        hits++;
+        from = start + length;
+    }
+    return hits;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+
+    const int megaChars = args.size() > 1 ? qMax(1, args[1].toInt()) : DEFAULT_MEGA_CHARS;
+    const int repeats = args.size() > 2 ? qMax(1, args[2].toInt()) : DEFAULT_REPEATS;
+    const int maxEdits = args.size() > 3 ? qMax(0, args[3].toInt()) : DEFAULT_MAX_EDITS;
+
+    const QString phrase = QString::fromLatin1(PHRASE);
+    const QString text = generateText(qsizetype(megaChars) * 1000 * 1000, phrase);
+
+    // 两个模糊模式前 64 个字符相同，只差一个字符就换成了动态规划
+    const QString shortPattern = phrase.left(BIT_PARALLEL_LENGTH);
+    const QString longPattern = phrase.left(BIT_PARALLEL_LENGTH + 1);
+
+    QRegularExpression regex(QRegularExpression::escape(shortPattern),
+                             QRegularExpression::UseUnicodePropertiesOption);
+    regex.optimize();
+
+    const FuzzyMatcher bitParallel(shortPattern, maxEdits);
+    const FuzzyMatcher dynamic(longPattern, maxEdits);
+
+    std::printf("SearchBench: %lld chars, %d repeats, max edits %d, %s\n",
+                qint64(text.size()), repeats, maxEdits, qPrintable(TextScanner::instructionSet()));
+
+    qint64 hits = 0;
+    double seconds = measure(repeats, [&]() { return countExact(text, shortPattern); }, &hits);
+    report("exact (64)", text.size(), seconds, hits);
+
+    seconds = measure(repeats, [&]() { return countRegex(text, regex); }, &hits);
+    report("regex (64)", text.size(), seconds, hits);
+
+    const double bitParallelSeconds = measure(repeats, [&]() { return countFuzzy(text, bitParallel); }, &hits);
+    report("fuzzy bit-parallel (64)", text.size(), bitParallelSeconds, hits);
+
+    const double dynamicSeconds = measure(repeats, [&]() { return countFuzzy(text, dynamic); }, &hits);
+    report("fuzzy dynamic (65)", text.size(), dynamicSeconds, hits);
+
+    std::printf("  bit-parallel speedup: %.1fx\n", dynamicSeconds / bitParallelSeconds);
+    return 0;
+}
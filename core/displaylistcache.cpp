@@ -0,0 +1,143 @@
+#include "displaylistcache.h"
+#include <QMutexLocker>
+#include <QDebug>
+#include <limits>
+
+DisplayListCache::DisplayListCache(qint64 maxBytes)
+    : m_maxBytes(maxBytes)
+    , m_totalBytes(0)
+    , m_useCounter(0)
+    , m_hitCount(0)
+    , m_missCount(0)
+    , m_evictCount(0)
+{
+}
+
+DisplayListCache::~DisplayListCache()
+{
+    if (!m_entries.isEmpty()) {
+        // 没有 context 无法释放，说明拥有者忘记调用 clear()
+        qWarning() << "DisplayListCache: Destroyed with" << m_entries.size()
+                   << "display lists still cached";
+    }
+}
+
+fz_display_list* DisplayListCache::acquire(fz_context* ctx, int pageIndex)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_entries.find(pageIndex);
+    if (it == m_entries.end()) {
+        m_missCount++;
+        return nullptr;
+    }
+
+    m_hitCount++;
+    it->lastUse = ++m_useCounter;
+    return fz_keep_display_list(ctx, it->list);
+}
+
+void DisplayListCache::insert(fz_context* ctx, int pageIndex, fz_display_list* list,
+                              qint64 estimatedBytes)
+{
+    if (!list) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_entries.find(pageIndex);
+    if (it != m_entries.end()) {
+        // 其他线程已先一步生成，保留已有的
+        it->lastUse = ++m_useCounter;
+        return;
+    }
+
+    Entry entry;
+    entry.list = fz_keep_display_list(ctx, list);
+    entry.bytes = estimatedBytes;
+    entry.lastUse = ++m_useCounter;
+
+    m_entries.insert(pageIndex, entry);
+    m_totalBytes += estimatedBytes;
+
+    evictLocked(ctx, pageIndex);
+}
+
+void DisplayListCache::clear(fz_context* ctx)
+{
+    QMutexLocker locker(&m_mutex);
+
+    for (const Entry& entry : m_entries) {
+        fz_drop_display_list(ctx, entry.list);
+    }
+
+    m_entries.clear();
+    m_totalBytes = 0;
+}
+
+void DisplayListCache::setMaxBytes(fz_context* ctx, qint64 maxBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxBytes = maxBytes;
+    evictLocked(ctx, -1);
+}
+
+qint64 DisplayListCache::maxBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxBytes;
+}
+
+qint64 DisplayListCache::totalBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_totalBytes;
+}
+
+int DisplayListCache::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+QString DisplayListCache::getStatistics() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    qint64 totalAccess = m_hitCount + m_missCount;
+    double hitRate = (totalAccess > 0) ? (m_hitCount * 100.0 / totalAccess) : 0;
+
+    return QString("Display Lists: %1 pages, ~%2/%3 MB, Hit Rate: %4%, Evicted: %5")
+        .arg(m_entries.size())
+        .arg(m_totalBytes / 1024.0 / 1024.0, 0, 'f', 2)
+        .arg(m_maxBytes / 1024.0 / 1024.0, 0, 'f', 0)
+        .arg(hitRate, 0, 'f', 1)
+        .arg(m_evictCount);
+}
+
+void DisplayListCache::evictLocked(fz_context* ctx, int keepPage)
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    while (m_totalBytes > m_maxBytes && m_entries.size() > 1) {
+        int oldestPage = -1;
+        qint64 oldestUse = std::numeric_limits<qint64>::max();
+
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            if (it.key() != keepPage && it->lastUse < oldestUse) {
+                oldestUse = it->lastUse;
+                oldestPage = it.key();
+            }
+        }
+
+        if (oldestPage < 0) {
+            break;
+        }
+
+        Entry entry = m_entries.take(oldestPage);
+        m_totalBytes -= entry.bytes;
+        fz_drop_display_list(ctx, entry.list);
+        m_evictCount++;
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef DISPLAYLISTCACHE_H
+#define DISPLAYLISTCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+extern "C" {
+#include <mupdf/fitz.h>
+}
+
+/**
+ * @brief 页面显示列表缓存
+ *
+ * 每页的内容流只解释一次，生成 fz_display_list 后按字节预算做 LRU 保留。
+ * 缩放/旋转变化、缩略图、文本提取都直接回放显示列表，只付出光栅化的代价。
+ *
+ * 显示列表的真实大小 MuPDF 不对外暴露，这里按页面内容流和图像资源的
+ * 编码长度估算（见 PerThreadMuPDFRenderer::estimateDisplayListBytes）。
+ *
+ * 所有接口都需要传入 fz_context，用于 keep/drop 引用计数；
+ * 拥有者必须在销毁 context 之前调用 clear()。
+ */
+class DisplayListCache
+{
+public:
+    explicit DisplayListCache(qint64 maxBytes);
+    ~DisplayListCache();
+
+    DisplayListCache(const DisplayListCache&) = delete;
+    DisplayListCache& operator=(const DisplayListCache&) = delete;
+
+    /**
+     * @brief 获取页面的显示列表
+     * @return 新增一个引用的显示列表（调用方负责 fz_drop_display_list），未缓存返回 nullptr
+     */
+    fz_display_list* acquire(fz_context* ctx, int pageIndex);
+
+    /**
+     * @brief 缓存显示列表（缓存自己持有一个引用，调用方的引用不变）
+     * @param estimatedBytes 估算的内存占用
+     */
+    void insert(fz_context* ctx, int pageIndex, fz_display_list* list, qint64 estimatedBytes);
+
+    /**
+     * @brief 释放所有显示列表
+     */
+    void clear(fz_context* ctx);
+
+    /**
+     * @brief 设置字节预算
+     */
+    void setMaxBytes(fz_context* ctx, qint64 maxBytes);
+
+    qint64 maxBytes() const;
+    qint64 totalBytes() const;
+    int count() const;
+
+    /**
+     * @brief 获取统计信息（调试用）
+     */
+    QString getStatistics() const;
+
+private:
+    struct Entry {
+        fz_display_list* list = nullptr;
+        qint64 bytes = 0;
+        qint64 lastUse = 0;
+    };
+
+    /**
+     * @brief 淘汰直到满足预算（调用前必须已持有锁）
+     * @param keepPage 本次插入的页面，不参与淘汰
+     */
+    void evictLocked(fz_context* ctx, int keepPage);
+
+private:
+    mutable QMutex m_mutex;
+    QHash<int, Entry> m_entries;    ///< 页码 -> 显示列表
+    qint64 m_maxBytes;              ///< 字节预算
+    qint64 m_totalBytes;            ///< 当前估算占用
+    qint64 m_useCounter;            ///< LRU 计数器
+
+    // 统计信息
+    qint64 m_hitCount;
+    qint64 m_missCount;
+    qint64 m_evictCount;
+};
+
+#endif // DISPLAYLISTCACHE_H
@@ -0,0 +1,134 @@
+#include "mupdfdocumentcore.h"
+#include "appconfig.h"
+#include <QDebug>
+#include <QHash>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+
+namespace {
+// 路径 -> 共享核心（弱引用，最后一个持有者释放后自动关闭）
+QMutex s_registryMutex;
+QHash<QString, std::weak_ptr<MuPDFDocumentCore>> s_registry;
+}
+
+MuPDFDocumentCore::MuPDFDocumentCore(const QString& filePath)
+    : m_documentPath(filePath)
+    , m_context(nullptr)
+    , m_document(nullptr)
+    , m_pageCount(0)
+    , m_displayListCache(AppConfig::DISPLAY_LIST_CACHE_BYTES)
+{
+    m_locksContext.user = m_fzLocks;
+    m_locksContext.lock = &MuPDFDocumentCore::lockCallback;
+    m_locksContext.unlock = &MuPDFDocumentCore::unlockCallback;
+}
+
+MuPDFDocumentCore::~MuPDFDocumentCore()
+{
+    if (m_context) {
+        m_displayListCache.clear(m_context);
+    }
+
+    if (m_document && m_context) {
+        fz_drop_document(m_context, m_document);
+        m_document = nullptr;
+    }
+
+    if (m_context) {
+        fz_drop_context(m_context);
+        m_context = nullptr;
+    }
+
+    qInfo() << "MuPDFDocumentCore: Closed" << m_documentPath;
+}
+
+std::shared_ptr<MuPDFDocumentCore> MuPDFDocumentCore::acquire(const QString& filePath,
+                                                              QString* errorMsg)
+{
+    if (filePath.isEmpty()) {
+        if (errorMsg) *errorMsg = "Empty document path";
+        return nullptr;
+    }
+
+    {
+        QMutexLocker locker(&s_registryMutex);
+        std::shared_ptr<MuPDFDocumentCore> existing = s_registry.value(filePath).lock();
+        if (existing) {
+            return existing;
+        }
+    }
+
+    // 在锁外打开和解析文档，避免大文件阻塞其他文档的查找
+    std::shared_ptr<MuPDFDocumentCore> core(new MuPDFDocumentCore(filePath));
+    if (!core->open(errorMsg)) {
+        return nullptr;
+    }
+
+    QMutexLocker locker(&s_registryMutex);
+
+    // 打开期间其他线程可能已经登记了同一文档，以先登记的为准
+    std::shared_ptr<MuPDFDocumentCore> existing = s_registry.value(filePath).lock();
+    if (existing) {
+        locker.unlock();
+        core.reset();
+        return existing;
+    }
+
+    s_registry.insert(filePath, core);
+    return core;
+}
+
+bool MuPDFDocumentCore::open(QString* errorMsg)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    m_context = fz_new_context(nullptr, &m_locksContext, FZ_STORE_DEFAULT);
+    if (!m_context) {
+        if (errorMsg) *errorMsg = "Failed to create MuPDF context";
+        qCritical() << "MuPDFDocumentCore: Failed to create context";
+        return false;
+    }
+
+    QByteArray pathUtf8 = m_documentPath.toUtf8();
+
+    fz_try(m_context) {
+        fz_register_document_handlers(m_context);
+        m_document = fz_open_document(m_context, pathUtf8.constData());
+        m_pageCount = fz_count_pages(m_context, m_document);
+    }
+    fz_catch(m_context) {
+        QString err = QString("Failed to open document: %1")
+        .arg(fz_caught_message(m_context));
+        if (errorMsg) *errorMsg = err;
+        qCritical() << "MuPDFDocumentCore:" << err;
+
+        if (m_document) {
+            fz_drop_document(m_context, m_document);
+            m_document = nullptr;
+        }
+        fz_drop_context(m_context);
+        m_context = nullptr;
+        m_pageCount = 0;
+        return false;
+    }
+
+    qInfo() << "MuPDFDocumentCore: Opened" << m_documentPath
+            << "-" << m_pageCount << "pages in" << timer.elapsed() << "ms";
+    return true;
+}
+
+fz_context* MuPDFDocumentCore::cloneContext() const
+{
+    return m_context ? fz_clone_context(m_context) : nullptr;
+}
+
+void MuPDFDocumentCore::lockCallback(void* user, int lock)
+{
+    static_cast<QMutex*>(user)[lock].lock();
+}
+
+void MuPDFDocumentCore::unlockCallback(void* user, int lock)
+{
+    static_cast<QMutex*>(user)[lock].unlock();
+}
@@ -0,0 +1,87 @@
+#ifndef MUPDFDOCUMENTCORE_H
+#define MUPDFDOCUMENTCORE_H
+
+#include <QString>
+#include <QMutex>
+#include <memory>
+#include "displaylistcache.h"
+
+extern "C" {
+#include <mupdf/fitz.h>
+}
+
+/**
+ * @brief 多线程共享的 MuPDF 文档核心
+ *
+ * 持有一个启用锁（fz_locks_context）的基础 context 和只打开一次的 fz_document。
+ * 工作线程通过 fz_clone_context 得到自己的 context，共享已解析的 xref、页面树
+ * 以及 MuPDF 资源存储（字体、解码后的图像）。
+ *
+ * fz_document 本身不是线程安全的：加载页面、生成显示列表等访问文档的操作
+ * 必须持有 lockDocument()；回放显示列表（光栅化、文本提取）不需要文档锁。
+ *
+ * 同一路径的核心通过 acquire() 复用，最后一个持有者释放时关闭文档。
+ */
+class MuPDFDocumentCore
+{
+public:
+    ~MuPDFDocumentCore();
+
+    MuPDFDocumentCore(const MuPDFDocumentCore&) = delete;
+    MuPDFDocumentCore& operator=(const MuPDFDocumentCore&) = delete;
+
+    /**
+     * @brief 获取指定文档的共享核心（已打开则复用）
+     * @param filePath 文件路径
+     * @param errorMsg 错误信息输出参数
+     * @return 打开失败返回 nullptr
+     */
+    static std::shared_ptr<MuPDFDocumentCore> acquire(const QString& filePath,
+                                                      QString* errorMsg = nullptr);
+
+    /**
+     * @brief 为当前线程克隆一个 context（调用方负责 fz_drop_context）
+     */
+    fz_context* cloneContext() const;
+
+    /**
+     * @brief 文档锁，访问 fz_document 前必须持有
+     *
+     * MuPDF 异常基于 setjmp/longjmp，不能依赖 QMutexLocker 的析构，
+     * 因此提供显式的加锁/解锁，在 fz_always 中解锁
+     */
+    void lockDocument() { m_documentMutex.lock(); }
+    void unlockDocument() { m_documentMutex.unlock(); }
+
+    fz_context* context() const { return m_context; }
+    fz_document* document() const { return m_document; }
+    QString documentPath() const { return m_documentPath; }
+    int pageCount() const { return m_pageCount; }
+
+    /**
+     * @brief 所有克隆 context 共享的显示列表缓存
+     */
+    DisplayListCache& displayListCache() { return m_displayListCache; }
+
+private:
+    explicit MuPDFDocumentCore(const QString& filePath);
+
+    bool open(QString* errorMsg);
+
+    static void lockCallback(void* user, int lock);
+    static void unlockCallback(void* user, int lock);
+
+private:
+    QString m_documentPath;
+    fz_context* m_context;                  ///< 基础 context（启用锁）
+    fz_document* m_document;                ///< 共享文档
+    int m_pageCount;
+
+    QMutex m_fzLocks[FZ_LOCK_MAX];          ///< fz_locks_context 使用的锁
+    fz_locks_context m_locksContext;
+    QMutex m_documentMutex;                 ///< 文档访问锁
+
+    DisplayListCache m_displayListCache;
+};
+
+#endif // MUPDFDOCUMENTCORE_H
@@ -0,0 +1,296 @@
+#include "pagegeometryscanner.h"
+#include "mupdfdocumentcore.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <vector>
+#include <utility>
+
+#include <mupdf/pdf.h>
+
+namespace {
+
+constexpr int PAGES_PER_LOCK = 512;    // 每次持有文档锁处理的页数
+constexpr int MAX_TREE_DEPTH = 64;     // 页面树深度上限（防止循环引用）
+
+/**
+ * @brief 页面树遍历栈帧，记录沿树继承下来的属性
+ */
+struct TreeFrame {
+    pdf_obj* node = nullptr;        ///< 页面树节点（持有引用）
+    int nextKid = 0;                ///< 下一个待访问的子节点
+    fz_rect mediaBox = fz_empty_rect;
+    fz_rect cropBox = fz_empty_rect;
+    int rotate = 0;
+};
+
+bool isCancelled(const std::atomic_bool* cancelled)
+{
+    return cancelled && cancelled->load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 子节点继承父节点属性，自身定义的属性覆盖继承值
+ */
+TreeFrame inheritFrame(fz_context* ctx, const TreeFrame& parent, pdf_obj* node)
+{
+    TreeFrame frame;
+    frame.mediaBox = parent.mediaBox;
+    frame.cropBox = parent.cropBox;
+    frame.rotate = parent.rotate;
+
+    pdf_obj* mediaBox = pdf_dict_get(ctx, node, PDF_NAME(MediaBox));
+    if (pdf_is_array(ctx, mediaBox)) {
+        frame.mediaBox = pdf_to_rect(ctx, mediaBox);
+    }
+
+    pdf_obj* cropBox = pdf_dict_get(ctx, node, PDF_NAME(CropBox));
+    if (pdf_is_array(ctx, cropBox)) {
+        frame.cropBox = pdf_to_rect(ctx, cropBox);
+    }
+
+    pdf_obj* rotate = pdf_dict_get(ctx, node, PDF_NAME(Rotate));
+    if (pdf_is_number(ctx, rotate)) {
+        frame.rotate = pdf_to_int(ctx, rotate);
+    }
+
+    return frame;
+}
+
+/**
+ * @brief 按 MuPDF 的规则计算页面边界（与 fz_bound_page 一致）
+ */
+QSizeF pageSizeFromFrame(fz_context* ctx, const TreeFrame& frame, pdf_obj* page)
+{
+    fz_rect box = frame.mediaBox;
+    if (fz_is_empty_rect(box)) {
+        box = fz_make_rect(0, 0, 612, 792);
+    }
+
+    fz_rect crop = fz_intersect_rect(frame.cropBox, box);
+    if (!fz_is_empty_rect(crop)) {
+        box = crop;
+    }
+
+    // UserUnit 不可继承，只读页面自身
+    float userUnit = 1.0f;
+    pdf_obj* unit = pdf_dict_get(ctx, page, PDF_NAME(UserUnit));
+    if (pdf_is_number(ctx, unit) && pdf_to_real(ctx, unit) > 0) {
+        userUnit = pdf_to_real(ctx, unit);
+    }
+
+    // 旋转角度规整到 90 的倍数
+    int rotate = frame.rotate % 360;
+    if (rotate < 0) {
+        rotate += 360;
+    }
+    rotate = 90 * ((rotate + 45) / 90);
+    if (rotate >= 360) {
+        rotate = 0;
+    }
+
+    QSizeF size((box.x1 - box.x0) * userUnit, (box.y1 - box.y0) * userUnit);
+    if (rotate == 90 || rotate == 270) {
+        size.transpose();
+    }
+    return size;
+}
+
+bool isPageNode(fz_context* ctx, pdf_obj* node)
+{
+    pdf_obj* type = pdf_dict_get(ctx, node, PDF_NAME(Type));
+    if (pdf_name_eq(ctx, type, PDF_NAME(Page))) {
+        return true;
+    }
+    // 缺少 Type 的节点按是否有 Kids 判断
+    return !pdf_name_eq(ctx, type, PDF_NAME(Pages)) &&
+           !pdf_is_array(ctx, pdf_dict_get(ctx, node, PDF_NAME(Kids)));
+}
+
+/**
+ * @brief PDF 快速路径：遍历页面树，不加载页面内容
+ */
+bool scanPageTree(fz_context* ctx, MuPDFDocumentCore* core, pdf_document* pdf,
+                  QVector<QSizeF>& outSizes, const std::atomic_bool* cancelled,
+                  QString* errorMsg)
+{
+    const int pageCount = outSizes.size();
+    std::vector<TreeFrame> stack;
+    int pageIndex = 0;
+    bool rootPushed = false;
+    bool finished = false;
+    bool failed = false;
+
+    fz_var(pageIndex);
+    fz_var(rootPushed);
+    fz_var(finished);
+
+    while (!finished && !failed) {
+        if (isCancelled(cancelled)) {
+            break;
+        }
+
+        core->lockDocument();
+        fz_try(ctx) {
+            if (!rootPushed) {
+                pdf_obj* root = pdf_dict_get(ctx, pdf_trailer(ctx, pdf), PDF_NAME(Root));
+                pdf_obj* pages = pdf_dict_get(ctx, root, PDF_NAME(Pages));
+                if (!pdf_is_dict(ctx, pages)) {
+                    fz_throw(ctx, FZ_ERROR_FORMAT, "missing page tree");
+                }
+
+                TreeFrame frame = inheritFrame(ctx, TreeFrame(), pages);
+                frame.node = pdf_keep_obj(ctx, pages);
+                stack.push_back(frame);
+                rootPushed = true;
+            }
+
+            int processed = 0;
+            while (!stack.empty() && processed < PAGES_PER_LOCK) {
+                TreeFrame& top = stack.back();
+                pdf_obj* kids = pdf_dict_get(ctx, top.node, PDF_NAME(Kids));
+
+                if (top.nextKid >= pdf_array_len(ctx, kids)) {
+                    pdf_drop_obj(ctx, top.node);
+                    stack.pop_back();
+                    continue;
+                }
+
+                pdf_obj* kid = pdf_array_get(ctx, kids, top.nextKid++);
+                if (!pdf_is_dict(ctx, kid)) {
+                    // 跳过会让后续页面错位，交给逐页加载处理
+                    fz_throw(ctx, FZ_ERROR_FORMAT, "malformed page tree node");
+                }
+
+                TreeFrame child = inheritFrame(ctx, top, kid);
+
+                if (isPageNode(ctx, kid)) {
+                    if (pageIndex < pageCount) {
+                        outSizes[pageIndex] = pageSizeFromFrame(ctx, child, kid);
+                    }
+                    pageIndex++;
+                    processed++;
+                } else {
+                    if (static_cast<int>(stack.size()) >= MAX_TREE_DEPTH) {
+                        fz_throw(ctx, FZ_ERROR_FORMAT, "page tree too deep");
+                    }
+                    child.node = pdf_keep_obj(ctx, kid);
+                    stack.push_back(child);
+                }
+            }
+
+            finished = stack.empty();
+        }
+        fz_always(ctx) {
+            core->unlockDocument();
+        }
+        fz_catch(ctx) {
+            QString err = QString("Failed to scan page tree: %1").arg(fz_caught_message(ctx));
+            if (errorMsg) *errorMsg = err;
+            qWarning() << "PageGeometryScanner:" << err;
+            failed = true;
+        }
+    }
+
+    for (const TreeFrame& frame : stack) {
+        pdf_drop_obj(ctx, frame.node);
+    }
+
+    if (finished && pageIndex != pageCount) {
+        // 页面树与页数不一致（损坏的文件），不返回残缺或错位的结果
+        QString err = QString("Page tree has %1 pages, document reports %2")
+                          .arg(pageIndex).arg(pageCount);
+        if (errorMsg) *errorMsg = err;
+        qWarning() << "PageGeometryScanner:" << err;
+        return false;
+    }
+
+    return finished;
+}
+
+/**
+ * @brief 通用路径：逐页加载并取边界（每页单独持锁）
+ */
+bool scanByLoading(fz_context* ctx, MuPDFDocumentCore* core,
+                   QVector<QSizeF>& outSizes, const std::atomic_bool* cancelled,
+                   QString* errorMsg)
+{
+    fz_page* page = nullptr;
+    fz_var(page);
+
+    for (int i = 0; i < outSizes.size(); ++i) {
+        if (isCancelled(cancelled)) {
+            return false;
+        }
+
+        core->lockDocument();
+        fz_try(ctx) {
+            page = fz_load_page(ctx, core->document(), i);
+            fz_rect bounds = fz_bound_page(ctx, page);
+            outSizes[i] = QSizeF(bounds.x1 - bounds.x0, bounds.y1 - bounds.y0);
+        }
+        fz_always(ctx) {
+            fz_drop_page(ctx, page);
+            page = nullptr;
+            core->unlockDocument();
+        }
+        fz_catch(ctx) {
+            // 单页失败不影响其他页面
+            if (errorMsg) {
+                *errorMsg = QString("Failed to get page size for page %1: %2")
+                .arg(i)
+                    .arg(fz_caught_message(ctx));
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+bool PageGeometryScanner::scan(const std::shared_ptr<MuPDFDocumentCore>& core,
+                               QVector<QSizeF>& outSizes,
+                               const std::atomic_bool* cancelled,
+                               QString* errorMsg)
+{
+    outSizes.clear();
+
+    if (!core || !core->document()) {
+        if (errorMsg) *errorMsg = "Document core not available";
+        return false;
+    }
+
+    fz_context* ctx = core->cloneContext();
+    if (!ctx) {
+        if (errorMsg) *errorMsg = "Failed to clone MuPDF context";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    outSizes.resize(core->pageCount());
+
+    pdf_document* pdf = pdf_specifics(ctx, core->document());
+    bool usedPageTree = pdf != nullptr;
+    bool success = usedPageTree
+        ? scanPageTree(ctx, core.get(), pdf, outSizes, cancelled, errorMsg)
+        : scanByLoading(ctx, core.get(), outSizes, cancelled, errorMsg);
+
+    if (!success && usedPageTree && !isCancelled(cancelled)) {
+        // 页面树损坏或过深：丢弃部分结果，改为逐页加载
+        qWarning() << "PageGeometryScanner: Page tree scan failed, falling back to page loading";
+        outSizes.fill(QSizeF());
+        usedPageTree = false;
+        success = scanByLoading(ctx, core.get(), outSizes, cancelled, errorMsg);
+    }
+
+    fz_drop_context(ctx);
+
+    if (success) {
+        qInfo() << "PageGeometryScanner: Scanned" << outSizes.size() << "pages in"
+                << timer.elapsed() << "ms" << (usedPageTree ? "(page tree)" : "(page load)");
+    }
+
+    return success && !isCancelled(cancelled);
+}
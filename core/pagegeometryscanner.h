@@ -0,0 +1,41 @@
+#ifndef PAGEGEOMETRYSCANNER_H
+#define PAGEGEOMETRYSCANNER_H
+
+#include <QString>
+#include <QVector>
+#include <QSizeF>
+#include <atomic>
+#include <memory>
+
+class MuPDFDocumentCore;
+
+/**
+ * @brief 页面几何信息批量扫描器
+ *
+ * 逐页 fz_load_page + fz_bound_page 会解析每一页的资源，大文档打开时代价很高。
+ * 对 PDF 文档，扫描器直接遍历页面树，读取 MediaBox / CropBox / Rotate（沿页面树继承）
+ * 和 UserUnit，不加载页面内容即可得到与 fz_bound_page 一致的页面尺寸。
+ * 非 PDF 文档（EPUB、XPS 等）以及页面树损坏（节点异常、层级过深、页数不符）
+ * 的 PDF 退回逐页加载，不会返回残缺或错位的结果。
+ *
+ * 扫描在调用线程上执行（通常是后台线程），从共享文档核心克隆 context，
+ * 分批持有文档锁，避免长时间阻塞渲染线程。
+ */
+class PageGeometryScanner
+{
+public:
+    /**
+     * @brief 扫描全部页面尺寸
+     * @param core 共享文档核心
+     * @param outSizes 输出的页面尺寸（单位：点，已考虑旋转），无法确定的页面为空尺寸
+     * @param cancelled 取消标志，置位后尽快返回
+     * @param errorMsg 错误信息输出参数
+     * @return 成功返回 true（取消时返回 false）
+     */
+    static bool scan(const std::shared_ptr<MuPDFDocumentCore>& core,
+                     QVector<QSizeF>& outSizes,
+                     const std::atomic_bool* cancelled = nullptr,
+                     QString* errorMsg = nullptr);
+};
+
+#endif // PAGEGEOMETRYSCANNER_H
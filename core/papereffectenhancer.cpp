@@ -34,8 +34,8 @@ QImage PaperEffectEnhancer::enhance(const QImage& input)
         applyPaperTexture(img, textMask);
     }
 
-    // 转换回 QImage
-    return cvMatToQImage(img);
+    // 转换回 QImage（尽量保持输入格式，避免绘制时再次转换）
+    return cvMatToQImage(img, input.format());
 }
 
 void PaperEffectEnhancer::setOptions(const AdvancedOptions& opt)
@@ -55,25 +55,27 @@ cv::Mat PaperEffectEnhancer::qImageToCvMat(const QImage& image)
     case QImage::Format_ARGB32_Premultiplied:
     {
         mat = cv::Mat(image.height(), image.width(), CV_8UC4,
-                      const_cast<uchar*>(image.bits()),
+                      const_cast<uchar*>(image.constBits()),
                       static_cast<size_t>(image.bytesPerLine()));
+        // 小端机器上 32 位 QImage 的内存顺序为 B,G,R,A
+        // cvtColor 的输出已经拥有独立内存，无需再 clone
         cv::Mat result;
-        cv::cvtColor(mat, result, cv::COLOR_RGBA2BGR);
-        return result.clone();
+        cv::cvtColor(mat, result, cv::COLOR_BGRA2BGR);
+        return result;
     }
     case QImage::Format_RGB888:
     {
         mat = cv::Mat(image.height(), image.width(), CV_8UC3,
-                      const_cast<uchar*>(image.bits()),
+                      const_cast<uchar*>(image.constBits()),
                       static_cast<size_t>(image.bytesPerLine()));
         cv::Mat result;
         cv::cvtColor(mat, result, cv::COLOR_RGB2BGR);
-        return result.clone();
+        return result;
     }
     case QImage::Format_Grayscale8:
     {
         mat = cv::Mat(image.height(), image.width(), CV_8UC1,
-                      const_cast<uchar*>(image.bits()),
+                      const_cast<uchar*>(image.constBits()),
                       static_cast<size_t>(image.bytesPerLine()));
         return mat.clone();
     }
@@ -85,7 +87,7 @@ cv::Mat PaperEffectEnhancer::qImageToCvMat(const QImage& image)
     }
 }
 
-QImage PaperEffectEnhancer::cvMatToQImage(const cv::Mat& mat)
+QImage PaperEffectEnhancer::cvMatToQImage(const cv::Mat& mat, QImage::Format preferredFormat)
 {
     switch (mat.type()) {
     case CV_8UC1:
@@ -96,19 +98,29 @@ QImage PaperEffectEnhancer::cvMatToQImage(const cv::Mat& mat)
     }
     case CV_8UC3:
     {
-        cv::Mat rgb;
+        // 颜色转换直接写入 QImage 的缓冲区，省去中间 Mat 和 copy()
+        if (preferredFormat == QImage::Format_RGB32
+            || preferredFormat == QImage::Format_ARGB32_Premultiplied) {
+            QImage image(mat.cols, mat.rows, preferredFormat);
+            cv::Mat bgra(mat.rows, mat.cols, CV_8UC4, image.bits(),
+                         static_cast<size_t>(image.bytesPerLine()));
+            cv::cvtColor(mat, bgra, cv::COLOR_BGR2BGRA);
+            return image;
+        }
+
+        QImage image(mat.cols, mat.rows, QImage::Format_RGB888);
+        cv::Mat rgb(mat.rows, mat.cols, CV_8UC3, image.bits(),
+                    static_cast<size_t>(image.bytesPerLine()));
         cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
-        QImage image(rgb.data, rgb.cols, rgb.rows,
-                     static_cast<int>(rgb.step), QImage::Format_RGB888);
-        return image.copy();
+        return image;
     }
     case CV_8UC4:
     {
-        cv::Mat rgba;
-        cv::cvtColor(mat, rgba, cv::COLOR_BGRA2RGBA);
-        QImage image(rgba.data, rgba.cols, rgba.rows,
-                     static_cast<int>(rgba.step), QImage::Format_ARGB32);
-        return image.copy();
+        QImage image(mat.cols, mat.rows, QImage::Format_ARGB32);
+        cv::Mat bgra(mat.rows, mat.cols, CV_8UC4, image.bits(),
+                     static_cast<size_t>(image.bytesPerLine()));
+        mat.copyTo(bgra);
+        return image;
     }
     default:
         return QImage();
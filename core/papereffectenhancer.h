@@ -84,7 +84,7 @@ public:
 private:
     // 格式转换
     cv::Mat qImageToCvMat(const QImage& image);
-    QImage cvMatToQImage(const cv::Mat& mat);
+    QImage cvMatToQImage(const cv::Mat& mat, QImage::Format preferredFormat);
 
     // 核心处理函数
     cv::Mat createTextMask(const cv::Mat& img);
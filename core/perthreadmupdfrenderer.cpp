@@ -1,13 +1,22 @@
 #include "perthreadmupdfrenderer.h"
+#include "mupdfdocumentcore.h"
+#include "appconfig.h"
+#include "rendercanceltoken.h"
 #include <QDebug>
 #include <QThread>
 #include <cstring>
 
+extern "C" {
+#include <mupdf/pdf.h>
+}
+
 
 PerThreadMuPDFRenderer::PerThreadMuPDFRenderer()
     : m_context(nullptr)
     , m_document(nullptr)
     , m_pageCount(0)
+    , m_displayListCache(AppConfig::DISPLAY_LIST_CACHE_BYTES)
+    , m_outputFormat(AppConfig::instance().renderImageFormat())
     , m_paperEffectEnabled(false)
 {
 }
@@ -17,6 +26,8 @@ PerThreadMuPDFRenderer::PerThreadMuPDFRenderer(const QString& documentPath)
     , m_context(nullptr)
     , m_document(nullptr)
     , m_pageCount(0)
+    , m_displayListCache(AppConfig::DISPLAY_LIST_CACHE_BYTES)
+    , m_outputFormat(AppConfig::instance().renderImageFormat())
     , m_paperEffectEnabled(false)
 {
     if (!createContext()) {
@@ -51,8 +62,43 @@ PerThreadMuPDFRenderer::PerThreadMuPDFRenderer(const QString& documentPath)
     }
 }
 
+PerThreadMuPDFRenderer::PerThreadMuPDFRenderer(std::shared_ptr<MuPDFDocumentCore> core)
+    : m_context(nullptr)
+    , m_document(nullptr)
+    , m_pageCount(0)
+    , m_displayListCache(AppConfig::DISPLAY_LIST_CACHE_BYTES)
+    , m_core(std::move(core))
+    , m_outputFormat(AppConfig::instance().renderImageFormat())
+    , m_paperEffectEnabled(false)
+{
+    if (!m_core || !m_core->document()) {
+        setLastError("Invalid document core");
+        qCritical() << "PerThreadMuPDFRenderer: Invalid document core";
+        m_core.reset();
+        return;
+    }
+
+    // 克隆的 context 共享基础 context 的锁、资源存储和文档处理器
+    m_context = m_core->cloneContext();
+    if (!m_context) {
+        setLastError("Failed to clone MuPDF context");
+        qCritical() << "PerThreadMuPDFRenderer: Failed to clone context";
+        m_core.reset();
+        return;
+    }
+
+    m_document = fz_keep_document(m_context, m_core->document());
+    m_documentPath = m_core->documentPath();
+    m_pageCount = m_core->pageCount();
+    m_pageSizeCache.resize(m_pageCount);
+}
+
 PerThreadMuPDFRenderer::~PerThreadMuPDFRenderer()
 {
+    if (m_context) {
+        m_displayListCache.clear(m_context);
+    }
+
     if (isDocumentLoaded()) {
         if (m_document && m_context) {
             fz_drop_document(m_context, m_document);
@@ -122,15 +168,18 @@ void PerThreadMuPDFRenderer::destroyContext()
 bool PerThreadMuPDFRenderer::loadDocument(const QString& filePath, QString* errorMsg)
 {
     if (isDocumentLoaded()) {
+        m_displayListCache.clear(m_context);
         if (m_document && m_context) {
             fz_drop_document(m_context, m_document);
             m_document = nullptr;
         }
         m_pageCount = 0;
         m_pageSizeCache.clear();
+        m_pageSizeEstimated.clear();
         m_documentPath.clear();
 
         destroyContext();
+        m_core.reset();
     }
 
     if (!createContext()) {
@@ -185,6 +234,10 @@ void PerThreadMuPDFRenderer::closeDocument()
 
     qInfo() << "PerThreadMuPDFRenderer: Closing document";
 
+    if (m_context) {
+        m_displayListCache.clear(m_context);
+    }
+
     if (m_document && m_context) {
         qDebug() << "PerThreadMuPDFRenderer: Dropping document";
         fz_drop_document(m_context, m_document);
@@ -193,9 +246,11 @@ void PerThreadMuPDFRenderer::closeDocument()
 
     m_pageCount = 0;
     m_pageSizeCache.clear();
+    m_pageSizeEstimated.clear();
     m_documentPath.clear();
 
     destroyContext();
+    m_core.reset();
 
     qInfo() << "PerThreadMuPDFRenderer: Document closed";
 }
@@ -228,6 +283,7 @@ QSizeF PerThreadMuPDFRenderer::pageSize(int pageIndex) const
 
     QSizeF size;
 
+    lockDocument();
     fz_try(m_context) {
         fz_page* page = fz_load_page(m_context, m_document, pageIndex);
         fz_rect bounds = fz_bound_page(m_context, page);
@@ -237,6 +293,9 @@ QSizeF PerThreadMuPDFRenderer::pageSize(int pageIndex) const
 
         m_pageSizeCache[pageIndex] = size;
     }
+    fz_always(m_context) {
+        unlockDocument();
+    }
     fz_catch(m_context) {
         QString err = QString("Failed to get page size for page %1: %2")
         .arg(pageIndex)
@@ -248,6 +307,76 @@ QSizeF PerThreadMuPDFRenderer::pageSize(int pageIndex) const
     return size;
 }
 
+void PerThreadMuPDFRenderer::estimatePageSizes()
+{
+    if (!isDocumentLoaded() || m_pageCount <= 1) {
+        return;
+    }
+
+    // 第一页精确加载，作为其余页面的估算值
+    QSizeF estimate = pageSize(0);
+    if (estimate.isEmpty()) {
+        return;
+    }
+
+    m_pageSizeEstimated.resize(m_pageCount);
+    m_pageSizeEstimated.fill(false);
+
+    for (int i = 1; i < m_pageCount; ++i) {
+        if (m_pageSizeCache[i].isEmpty()) {
+            m_pageSizeCache[i] = estimate;
+            m_pageSizeEstimated.setBit(i);
+        }
+    }
+}
+
+bool PerThreadMuPDFRenderer::applyPageSizes(const QVector<QSizeF>& sizes)
+{
+    if (!isDocumentLoaded()) {
+        return false;
+    }
+
+    bool changed = false;
+
+    for (int i = 0; i < m_pageCount; ++i) {
+        bool estimated = isPageSizeEstimated(i);
+        QSizeF size = (i < sizes.size()) ? sizes[i] : QSizeF();
+
+        if (size.isEmpty()) {
+            // 扫描未得到结果：丢弃估算值，pageSize() 会按需精确加载
+            if (estimated) {
+                m_pageSizeCache[i] = QSizeF();
+                changed = true;
+            }
+        } else if (m_pageSizeCache[i] != size) {
+            m_pageSizeCache[i] = size;
+            changed = true;
+        }
+
+        if (estimated) {
+            m_pageSizeEstimated.clearBit(i);
+        }
+    }
+
+    return changed;
+}
+
+bool PerThreadMuPDFRenderer::isPageSizeEstimated(int pageIndex) const
+{
+    return pageIndex >= 0 && pageIndex < m_pageSizeEstimated.size() &&
+           m_pageSizeEstimated.testBit(pageIndex);
+}
+
+/**
+ * @brief 回放结束后检查是否被中止（MuPDF 中止时正常返回，结果不完整）
+ */
+static void throwIfAborted(fz_context* ctx, const RenderCancelScope& scope)
+{
+    if (scope.aborted()) {
+        fz_throw(ctx, FZ_ERROR_GENERIC, "Cancelled");
+    }
+}
+
 static fz_matrix calculateMatrixForMuPDF(double zoom, int rotation)
 {
     fz_matrix matrix = fz_scale(zoom, zoom);
@@ -259,26 +388,56 @@ static fz_matrix calculateMatrixForMuPDF(double zoom, int rotation)
     return matrix;
 }
 
-static QImage pixmapToQImage(fz_context* ctx, fz_pixmap* pixmap)
+QSize PerThreadMuPDFRenderer::pixelSize(const QSizeF& pageSize, double zoom, int rotation)
 {
-    if (!pixmap) return QImage();
+    if (pageSize.isEmpty()) {
+        return QSize();
+    }
 
-    int width = fz_pixmap_width(ctx, pixmap);
-    int height = fz_pixmap_height(ctx, pixmap);
-    int stride = fz_pixmap_stride(ctx, pixmap);
-    unsigned char* samples = fz_pixmap_samples(ctx, pixmap);
+    fz_rect bounds = fz_make_rect(0, 0, float(pageSize.width()), float(pageSize.height()));
+    fz_irect box = fz_round_rect(fz_transform_rect(bounds, calculateMatrixForMuPDF(zoom, rotation)));
+    return QSize(box.x1 - box.x0, box.y1 - box.y0);
+}
 
-    QImage image(width, height, QImage::Format_RGB888);
-    for (int y = 0; y < height; ++y) {
-        unsigned char* src = samples + y * stride;
-        unsigned char* dest = image.scanLine(y);
-        memcpy(dest, src, width * 3);
+/**
+ * @brief 分配 QImage 并创建直接写入其缓冲区的 pixmap
+ *
+ * MuPDF 渲染结果直接落在 Qt 持有的帧缓冲中，不再经过中间 pixmap 和逐行拷贝。
+ * 返回的 pixmap 只借用 image 的内存，必须在 image 释放前 drop。
+ *
+ * 32 位格式使用 BGR + alpha：小端机器上内存顺序 B,G,R,A 与 Format_RGB32 /
+ * Format_ARGB32_Premultiplied 一致。背景以 0xff 清空，alpha 始终不透明。
+ */
+static fz_pixmap* newPixmapOverImage(fz_context* ctx, const fz_irect& bbox,
+                                     QImage::Format format, QImage& image)
+{
+    int width = bbox.x1 - bbox.x0;
+    int height = bbox.y1 - bbox.y0;
+
+    bool use32Bit = (format == QImage::Format_RGB32
+                     || format == QImage::Format_ARGB32_Premultiplied)
+                    && Q_BYTE_ORDER == Q_LITTLE_ENDIAN;
+    if (!use32Bit) {
+        format = QImage::Format_RGB888;
+    }
+
+    image = QImage(width, height, format);
+    if (image.isNull()) {
+        fz_throw(ctx, FZ_ERROR_GENERIC, "Failed to allocate %dx%d image", width, height);
     }
 
-    return image;
+    fz_colorspace* colorspace = use32Bit ? fz_device_bgr(ctx) : fz_device_rgb(ctx);
+    fz_pixmap* pixmap = fz_new_pixmap_with_data(ctx, colorspace, width, height,
+                                                nullptr, use32Bit ? 1 : 0,
+                                                static_cast<int>(image.bytesPerLine()),
+                                                image.bits());
+    pixmap->x = bbox.x0;
+    pixmap->y = bbox.y0;
+    return pixmap;
 }
 
-RenderResult PerThreadMuPDFRenderer::renderPage(int pageIndex, double zoom, int rotation)
+RenderResult PerThreadMuPDFRenderer::renderPage(int pageIndex, double zoom, int rotation,
+                                                RenderCancelToken* cancel)
 {
     RenderResult result;
 
@@ -292,56 +451,152 @@ RenderResult PerThreadMuPDFRenderer::renderPage(int pageIndex, double zoom, int
         return result;
     }
 
+    RenderCancelScope scope(cancel);
+
+    fz_display_list* list = nullptr;
+    fz_pixmap* pixmap = nullptr;
+    fz_device* device = nullptr;
+
+    fz_var(list);
+    fz_var(pixmap);
+    fz_var(device);
+
     fz_try(m_context) {
-        fz_page* page = fz_load_page(m_context, m_document, pageIndex);
+        // 回放显示列表，缩放/旋转变化只付出光栅化的代价
+        list = acquireDisplayList(pageIndex, scope.cookie());
         fz_matrix matrix = calculateMatrixForMuPDF(zoom, rotation);
-        fz_rect bounds = fz_bound_page(m_context, page);
-        bounds = fz_transform_rect(bounds, matrix);
-
-        fz_pixmap* pixmap = fz_new_pixmap_with_bbox(
-            m_context,
-            fz_device_rgb(m_context),
-            fz_round_rect(bounds),
-            nullptr,
-            0
-            );
+        fz_rect bounds = fz_transform_rect(fz_bound_display_list(m_context, list), matrix);
+
+        pixmap = newPixmapOverImage(m_context, fz_round_rect(bounds), m_outputFormat, result.image);
         fz_clear_pixmap_with_value(m_context, pixmap, 0xff);
 
-        fz_device* device = fz_new_draw_device(m_context, fz_identity, pixmap);
-        fz_run_page(m_context, page, device, matrix, nullptr);
+        device = fz_new_draw_device(m_context, fz_identity, pixmap);
+        fz_run_display_list(m_context, list, device, matrix, fz_infinite_rect, scope.cookie());
+        fz_close_device(m_context, device);
+        throwIfAborted(m_context, scope);
+
+        result.success = true;
+    }
+    fz_always(m_context) {
+        fz_drop_device(m_context, device);
+        fz_drop_pixmap(m_context, pixmap);
+        fz_drop_display_list(m_context, list);
+    }
+    fz_catch(m_context) {
+        // 立即释放（可能只画了一半的）图像缓冲
+        result.image = QImage();
+        if (scope.aborted()) {
+            result.cancelled = true;
+            result.errorMessage = QString("Render of page %1 cancelled").arg(pageIndex);
+            scope.markCancelled();
+        } else {
+            QString err = QString("Failed to render page %1: %2")
+            .arg(pageIndex)
+                .arg(fz_caught_message(m_context));
+            setLastError(err);
+            result.errorMessage = err;
+            qWarning() << "PerThreadMuPDFRenderer:" << err;
+        }
+    }
+
+    // ============ 添加纸质增强处理 ============
+    if (result.success && m_paperEffectEnabled && !result.image.isNull()) {
+        result.image = m_paperEffectEnhancer.enhance(result.image);
+    }
+    // ========================================
+
+    return result;
+}
+RenderResult PerThreadMuPDFRenderer::renderPageRegion(int pageIndex, double zoom, int rotation,
+                                                      const QRect& region, RenderCancelToken* cancel)
+{
+    RenderResult result;
+
+    if (!isDocumentLoaded()) {
+        result.errorMessage = "No document loaded";
+        return result;
+    }
+
+    if (pageIndex < 0 || pageIndex >= m_pageCount) {
+        result.errorMessage = QString("Invalid page index %1").arg(pageIndex);
+        return result;
+    }
+
+    RenderCancelScope scope(cancel);
 
-        result.image = pixmapToQImage(m_context, pixmap);
+    fz_display_list* list = nullptr;
+    fz_pixmap* pixmap = nullptr;
+    fz_device* device = nullptr;
 
-        // ============ 添加纸质增强处理 ============
-        if (m_paperEffectEnabled && !result.image.isNull()) {
-            result.image = m_paperEffectEnhancer.enhance(result.image);
+    fz_var(list);
+    fz_var(pixmap);
+    fz_var(device);
+
+    fz_try(m_context) {
+        list = acquireDisplayList(pageIndex, scope.cookie());
+        fz_matrix matrix = calculateMatrixForMuPDF(zoom, rotation);
+        fz_rect pageRect = fz_transform_rect(fz_bound_display_list(m_context, list), matrix);
+        fz_irect pageBox = fz_round_rect(pageRect);
+
+        // 区域坐标转换到设备空间，并裁剪到页面范围
+        fz_irect clip;
+        clip.x0 = pageBox.x0 + region.x();
+        clip.y0 = pageBox.y0 + region.y();
+        clip.x1 = clip.x0 + region.width();
+        clip.y1 = clip.y0 + region.height();
+        clip = fz_intersect_irect(clip, pageBox);
+
+        if (fz_is_empty_irect(clip)) {
+            fz_throw(m_context, FZ_ERROR_GENERIC, "Region outside of page");
         }
-        // ========================================
 
-        result.success = true;
+        pixmap = newPixmapOverImage(m_context, clip, m_outputFormat, result.image);
+        fz_clear_pixmap_with_value(m_context, pixmap, 0xff);
 
+        // 只回放与瓦片相交的节点
+        device = fz_new_draw_device_with_bbox(m_context, fz_identity, pixmap, &clip);
+        fz_run_display_list(m_context, list, device, matrix, fz_rect_from_irect(clip), scope.cookie());
         fz_close_device(m_context, device);
+        throwIfAborted(m_context, scope);
+
+        result.success = true;
+    }
+    fz_always(m_context) {
         fz_drop_device(m_context, device);
         fz_drop_pixmap(m_context, pixmap);
-        fz_drop_page(m_context, page);
+        fz_drop_display_list(m_context, list);
     }
     fz_catch(m_context) {
-        QString err = QString("Failed to render page %1: %2")
-        .arg(pageIndex)
-            .arg(fz_caught_message(m_context));
-        setLastError(err);
-        result.errorMessage = err;
-        qWarning() << "PerThreadMuPDFRenderer:" << err;
+        result.image = QImage();
+        if (scope.aborted()) {
+            result.cancelled = true;
+            result.errorMessage = QString("Render of page %1 region cancelled").arg(pageIndex);
+            scope.markCancelled();
+        } else {
+            QString err = QString("Failed to render region of page %1: %2")
+            .arg(pageIndex)
+                .arg(fz_caught_message(m_context));
+            setLastError(err);
+            result.errorMessage = err;
+            qWarning() << "PerThreadMuPDFRenderer:" << err;
+        }
     }
 
     return result;
 }
+
+void PerThreadMuPDFRenderer::setOutputFormat(QImage::Format format)
+{
+    m_outputFormat = format;
+}
+
 void PerThreadMuPDFRenderer::setPaperEffectEnabled(bool enabled)
 {
     m_paperEffectEnabled = enabled;
 }
 
-bool PerThreadMuPDFRenderer::extractText(int pageIndex, PageTextData& outData, QString* errorMsg)
+bool PerThreadMuPDFRenderer::extractText(int pageIndex, PageTextData& outData, QString* errorMsg,
+                                         RenderCancelToken* cancel)
 {
     if (!isDocumentLoaded()) {
         if (errorMsg) *errorMsg = "Document not loaded";
@@ -356,15 +611,22 @@ bool PerThreadMuPDFRenderer::extractText(int pageIndex, PageTextData& outData, Q
     outData = PageTextData();
     outData.pageIndex = pageIndex;
 
+    RenderCancelScope scope(cancel);
+
+    fz_display_list* list = nullptr;
     fz_stext_page* stext = nullptr;
-    fz_page* page = nullptr;
+    fz_device* dev = nullptr;
+
+    fz_var(list);
+    fz_var(stext);
+    fz_var(dev);
 
     fz_try(m_context) {
-        // 加载页面
-        page = fz_load_page(m_context, m_document, pageIndex);
+        // 回放显示列表（与渲染共享，不再重新解释内容流）
+        list = acquireDisplayList(pageIndex, scope.cookie());
 
         // 获取原始边界
-        fz_rect bound = fz_bound_page(m_context, page);
+        fz_rect bound = fz_bound_display_list(m_context, list);
 
         // 创建 stext_page
         stext = fz_new_stext_page(m_context, bound);
@@ -375,61 +637,56 @@ bool PerThreadMuPDFRenderer::extractText(int pageIndex, PageTextData& outData, Q
         opts.flags = 0;
 
         // 创建设备
-        fz_device* dev = fz_new_stext_device(m_context, stext, &opts);
+        dev = fz_new_stext_device(m_context, stext, &opts);
 
         // 使用单位矩阵
-        fz_run_page(m_context, page, dev, fz_identity, nullptr);
+        fz_run_display_list(m_context, list, dev, fz_identity, fz_infinite_rect, scope.cookie());
 
         fz_close_device(m_context, dev);
-        fz_drop_device(m_context, dev);
+        throwIfAborted(m_context, scope);
 
         // 提取文本
         for (fz_stext_block* block = stext->first_block; block; block = block->next) {
             if (block->type != FZ_STEXT_BLOCK_TEXT) continue;
 
-            TextBlock tb;
-            tb.bbox = QRectF(block->bbox.x0, block->bbox.y0,
-                             block->bbox.x1 - block->bbox.x0,
-                             block->bbox.y1 - block->bbox.y0);
+            outData.beginBlock(QRectF(block->bbox.x0, block->bbox.y0,
+                                      block->bbox.x1 - block->bbox.x0,
+                                      block->bbox.y1 - block->bbox.y0));
 
             for (fz_stext_line* line = block->u.t.first_line; line; line = line->next) {
-                TextLine tl;
-                tl.bbox = QRectF(line->bbox.x0, line->bbox.y0,
-                                 line->bbox.x1 - line->bbox.x0,
-                                 line->bbox.y1 - line->bbox.y0);
+                // 行方向以 Y 分量为主时为竖排
+                bool vertical = qAbs(line->dir.y) > qAbs(line->dir.x);
+                outData.beginLine(QRectF(line->bbox.x0, line->bbox.y0,
+                                         line->bbox.x1 - line->bbox.x0,
+                                         line->bbox.y1 - line->bbox.y0),
+                                  vertical);
 
                 for (fz_stext_char* ch = line->first_char; ch; ch = ch->next) {
-                    TextChar tc;
-                    tc.character = QChar(ch->c);
-
                     fz_quad q = ch->quad;
                     qreal minX = qMin(qMin(q.ul.x, q.ur.x), qMin(q.ll.x, q.lr.x));
                     qreal maxX = qMax(qMax(q.ul.x, q.ur.x), qMax(q.ll.x, q.lr.x));
                     qreal minY = qMin(qMin(q.ul.y, q.ur.y), qMin(q.ll.y, q.lr.y));
                     qreal maxY = qMax(qMax(q.ul.y, q.ur.y), qMax(q.ll.y, q.lr.y));
 
-                    tc.bbox = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
-
-                    tl.chars.append(tc);
-                    outData.fullText.append(tc.character);
+                    outData.appendChar(QChar(ch->c), QRectF(QPointF(minX, minY), QPointF(maxX, maxY)));
                 }
-
-                tb.lines.append(tl);
-                outData.fullText.append('\n');
             }
-
-            outData.blocks.append(tb);
-            outData.fullText.append("\n\n");
         }
 
-        if (stext) fz_drop_stext_page(m_context, stext);
-        if (page) fz_drop_page(m_context, page);
+        outData.finish();
+    }
+    fz_always(m_context) {
+        fz_drop_device(m_context, dev);
+        fz_drop_stext_page(m_context, stext);
+        fz_drop_display_list(m_context, list);
     }
     fz_catch(m_context) {
-        if (stext) fz_drop_stext_page(m_context, stext);
-        if (page) fz_drop_page(m_context, page);
-
-        if (errorMsg) {
+        outData = PageTextData();
+        outData.pageIndex = pageIndex;
+        if (scope.aborted()) {
+            scope.markCancelled();
+            if (errorMsg) *errorMsg = QString("Text extraction of page %1 cancelled").arg(pageIndex);
+        } else if (errorMsg) {
             *errorMsg = QString("Failed to extract text on page %1: %2")
             .arg(pageIndex)
                 .arg(fz_caught_message(m_context));
@@ -456,14 +713,21 @@ bool PerThreadMuPDFRenderer::isTextPDF(int samplePages)
     for (int i = 0; i < pagesToCheck; ++i) {
         bool hasText = false;
 
+        fz_display_list* list = nullptr;
+        fz_stext_page* stext = nullptr;
+        fz_device* device = nullptr;
+
+        fz_var(list);
+        fz_var(stext);
+        fz_var(device);
+
         fz_try(m_context) {
-            fz_page* page = fz_load_page(m_context, m_document, i);
-            fz_stext_page* stext = fz_new_stext_page(m_context, fz_bound_page(m_context, page));
+            list = acquireDisplayList(i);
+            stext = fz_new_stext_page(m_context, fz_bound_display_list(m_context, list));
             fz_stext_options options = {0};
-            fz_device* device = fz_new_stext_device(m_context, stext, &options);
-            fz_run_page(m_context, page, device, fz_identity, nullptr);
+            device = fz_new_stext_device(m_context, stext, &options);
+            fz_run_display_list(m_context, list, device, fz_identity, fz_infinite_rect, nullptr);
             fz_close_device(m_context, device);
-            fz_drop_device(m_context, device);
 
             // 检查是否有文本
             for (fz_stext_block* block = stext->first_block; block; block = block->next) {
@@ -480,9 +744,11 @@ bool PerThreadMuPDFRenderer::isTextPDF(int samplePages)
                     if (hasText) break;
                 }
             }
-
+        }
+        fz_always(m_context) {
+            fz_drop_device(m_context, device);
             fz_drop_stext_page(m_context, stext);
-            fz_drop_page(m_context, page);
+            fz_drop_display_list(m_context, list);
         }
         fz_catch(m_context) {
             hasText = false;
@@ -497,6 +763,125 @@ bool PerThreadMuPDFRenderer::isTextPDF(int samplePages)
     return ratio >= 0.3;
 }
 
+QString PerThreadMuPDFRenderer::getDisplayListStatistics() const
+{
+    return m_core ? m_core->displayListCache().getStatistics()
+                  : m_displayListCache.getStatistics();
+}
+
+void PerThreadMuPDFRenderer::lockDocument() const
+{
+    if (m_core) {
+        m_core->lockDocument();
+    }
+}
+
+void PerThreadMuPDFRenderer::unlockDocument() const
+{
+    if (m_core) {
+        m_core->unlockDocument();
+    }
+}
+
+DisplayListCache& PerThreadMuPDFRenderer::displayLists()
+{
+    return m_core ? m_core->displayListCache() : m_displayListCache;
+}
+
+fz_display_list* PerThreadMuPDFRenderer::acquireDisplayList(int pageIndex, fz_cookie* cookie)
+{
+    fz_display_list* list = displayLists().acquire(m_context, pageIndex);
+    if (list) {
+        return list;
+    }
+
+    fz_page* page = nullptr;
+    fz_device* device = nullptr;
+
+    fz_var(page);
+    fz_var(list);
+    fz_var(device);
+
+    // 只有加载页面和生成显示列表需要文档锁，回放在锁外进行
+    lockDocument();
+    fz_try(m_context) {
+        // 等锁期间其他线程可能已经生成
+        list = displayLists().acquire(m_context, pageIndex);
+        if (!list) {
+            page = fz_load_page(m_context, m_document, pageIndex);
+
+            // 等价于 fz_new_display_list_from_page，但解释内容流时可被 cookie 中止
+            list = fz_new_display_list(m_context, fz_bound_page(m_context, page));
+            device = fz_new_list_device(m_context, list);
+            fz_run_page(m_context, page, device, fz_identity, cookie);
+            fz_close_device(m_context, device);
+
+            // 中止后的列表不完整，不能进入缓存
+            if (cookie && cookie->abort) {
+                fz_throw(m_context, FZ_ERROR_GENERIC, "Display list construction aborted");
+            }
+
+            displayLists().insert(m_context, pageIndex, list,
+                                  estimateDisplayListBytes(m_context, page));
+        }
+    }
+    fz_always(m_context) {
+        fz_drop_device(m_context, device);
+        fz_drop_page(m_context, page);
+        unlockDocument();
+    }
+    fz_catch(m_context) {
+        fz_drop_display_list(m_context, list);
+        fz_rethrow(m_context);
+    }
+
+    return list;
+}
+
+qint64 PerThreadMuPDFRenderer::estimateDisplayListBytes(fz_context* ctx, fz_page* page)
+{
+    // 显示列表节点与内容流操作符大致成正比，图像以压缩形式被列表引用。
+    // 内容流长度是压缩后的长度，按经验放大 8 倍；非 PDF 文档使用固定估值。
+    const qint64 minimumBytes = 16 * 1024;
+
+    pdf_page* pdfPage = pdf_page_from_fz_page(ctx, page);
+    if (!pdfPage) {
+        return 256 * 1024;
+    }
+
+    qint64 contentBytes = 0;
+    qint64 imageBytes = 0;
+
+    fz_try(ctx) {
+        pdf_obj* contents = pdf_dict_get(ctx, pdfPage->obj, PDF_NAME(Contents));
+        if (pdf_is_array(ctx, contents)) {
+            int n = pdf_array_len(ctx, contents);
+            for (int i = 0; i < n; ++i) {
+                contentBytes += pdf_dict_get_int(ctx, pdf_array_get(ctx, contents, i), PDF_NAME(Length));
+            }
+        } else if (contents) {
+            contentBytes = pdf_dict_get_int(ctx, contents, PDF_NAME(Length));
+        }
+
+        pdf_obj* resources = pdf_dict_get_inheritable(ctx, pdfPage->obj, PDF_NAME(Resources));
+        pdf_obj* xobjects = pdf_dict_get(ctx, resources, PDF_NAME(XObject));
+        int n = pdf_dict_len(ctx, xobjects);
+        for (int i = 0; i < n; ++i) {
+            pdf_obj* xobj = pdf_dict_get_val(ctx, xobjects, i);
+            if (pdf_name_eq(ctx, pdf_dict_get(ctx, xobj, PDF_NAME(Subtype)), PDF_NAME(Image))) {
+                imageBytes += pdf_dict_get_int(ctx, xobj, PDF_NAME(Length));
+            } else {
+                contentBytes += pdf_dict_get_int(ctx, xobj, PDF_NAME(Length));
+            }
+        }
+    }
+    fz_catch(ctx) {
+        // 估算失败不影响渲染
+    }
+
+    return qMax(minimumBytes, contentBytes * 8 + imageBytes);
+}
+
 QString PerThreadMuPDFRenderer::getLastError() const
 {
     return m_lastError;
@@ -4,26 +4,44 @@
 #include <QString>
 #include <QImage>
 #include <QSizeF>
+#include <QRect>
 #include <QVector>
+#include <QBitArray>
 #include <QMutex>
+#include <memory>
 #include "papereffectenhancer.h"
+#include "displaylistcache.h"
 #include "datastructure.h"
 
 extern "C" {
 #include <mupdf/fitz.h>
 }
 
+class MuPDFDocumentCore;
+class RenderCancelToken;
 
 /**
  * @brief 线程隔离的MuPDF渲染器
  *
- * 每个渲染器有自己 context 和 document，不共享
+ * 两种模式：
+ * 1. 独立模式：渲染器有自己的 context 和 document，不共享
+ * 2. 共享模式：从 MuPDFDocumentCore 克隆 context，共享已打开的文档、
+ *    资源存储和显示列表缓存，访问文档时持有核心的文档锁
+ *
+ * 无论哪种模式，一个渲染器实例同一时刻只能在一个线程中使用
  */
 class PerThreadMuPDFRenderer
 {
 public:
     PerThreadMuPDFRenderer();
     explicit PerThreadMuPDFRenderer(const QString& documentPath);
+
+    /**
+     * @brief 以共享模式创建渲染器（不重新打开、解析文档）
+     * @param core 共享文档核心
+     */
+    explicit PerThreadMuPDFRenderer(std::shared_ptr<MuPDFDocumentCore> core);
+
     ~PerThreadMuPDFRenderer();
 
     // 禁止拷贝
@@ -63,23 +81,67 @@ public:
      */
     QSizeF pageSize(int pageIndex) const;
 
+    /**
+     * @brief 以第一页的尺寸预填所有未知页面（估算值）
+     *
+     * 大文档打开时先用估算值完成布局，精确尺寸由后台扫描后通过 applyPageSizes() 写入
+     */
+    void estimatePageSizes();
+
+    /**
+     * @brief 写入后台扫描得到的精确页面尺寸
+     * @param sizes 页面尺寸，空尺寸表示未知（对应的估算值会被丢弃，改为按需加载）
+     * @return 有页面尺寸发生变化时返回 true
+     */
+    bool applyPageSizes(const QVector<QSizeF>& sizes);
+
+    /**
+     * @brief 页面尺寸是否为估算值
+     */
+    bool isPageSizeEstimated(int pageIndex) const;
+
+    /**
+     * @brief 按给定缩放和旋转渲染整页得到的像素尺寸
+     *
+     * 与 renderPage()/renderPageRegion() 一样按 fz_round_rect 取整（向外取整而非四舍五入），
+     * 布局、瓦片拼接与实际渲染结果的尺寸保持一致
+     * @param pageSize 未旋转的页面尺寸（点），见 pageSize()
+     */
+    static QSize pixelSize(const QSizeF& pageSize, double zoom, int rotation);
+
     /**
      * @brief 渲染指定页面
      * @param pageIndex 页面索引 (0-based)
      * @param zoom 缩放比例
      * @param rotation 旋转角度 (0, 90, 180, 270)
+     * @param cancel 取消令牌，取消后尽快返回并释放已分配的图像（result.cancelled 为 true）
      * @return 渲染结果
      */
-    RenderResult renderPage(int pageIndex, double zoom, int rotation);
+    RenderResult renderPage(int pageIndex, double zoom, int rotation,
+                            RenderCancelToken* cancel = nullptr);
+
+    /**
+     * @brief 渲染页面的局部区域（瓦片）
+     * @param pageIndex 页面索引 (0-based)
+     * @param zoom 缩放比例
+     * @param rotation 旋转角度 (0, 90, 180, 270)
+     * @param region 区域，坐标相对于整页渲染结果的左上角（像素）
+     * @param cancel 取消令牌
+     * @return 渲染结果，图像大小为 region 与页面的交集
+     */
+    RenderResult renderPageRegion(int pageIndex, double zoom, int rotation, const QRect& region,
+                                  RenderCancelToken* cancel = nullptr);
 
     /**
      * @brief 提取页面文本
      * @param pageIndex 页面索引
      * @param outData 输出的文本数据
      * @param errorMsg 错误信息输出参数
+     * @param cancel 取消令牌，取消时返回 false
      * @return 成功返回 true
      */
-    bool extractText(int pageIndex, PageTextData& outData, QString* errorMsg = nullptr);
+    bool extractText(int pageIndex, PageTextData& outData, QString* errorMsg = nullptr,
+                     RenderCancelToken* cancel = nullptr);
 
     /**
      * @brief 检测是否为文本 PDF
@@ -93,9 +155,23 @@ public:
      */
     QString getLastError() const;
 
+    /**
+     * @brief 获取显示列表缓存统计信息（调试用）
+     */
+    QString getDisplayListStatistics() const;
+
     void setPaperEffectEnabled(bool enabled);
     bool paperEffectEnabled() const { return m_paperEffectEnabled; }
 
+    /**
+     * @brief 设置渲染输出格式
+     *
+     * 支持 Format_RGB888、Format_RGB32、Format_ARGB32_Premultiplied，
+     * 其他格式按 Format_RGB888 处理。默认取自 AppConfig::renderImageFormat()
+     */
+    void setOutputFormat(QImage::Format format);
+    QImage::Format outputFormat() const { return m_outputFormat; }
+
     fz_context* context() const { return m_context; }
     fz_document* document() const { return m_document; }
 
@@ -117,13 +193,41 @@ private:
      */
     void setLastError(const QString& error) const;
 
+    /**
+     * @brief 共享模式下加/解文档锁，独立模式下为空操作
+     */
+    void lockDocument() const;
+    void unlockDocument() const;
+
+    /**
+     * @brief 当前使用的显示列表缓存（共享模式下为核心的缓存）
+     */
+    DisplayListCache& displayLists();
+
+    /**
+     * @brief 获取页面显示列表（缓存未命中时加载页面并生成）
+     *
+     * 必须在 fz_try 内调用，失败或被 cookie 中止时抛出 MuPDF 异常（中止的列表不会缓存）
+     * @return 新增一个引用的显示列表，调用方负责释放
+     */
+    fz_display_list* acquireDisplayList(int pageIndex, fz_cookie* cookie = nullptr);
+
+    /**
+     * @brief 估算页面显示列表的内存占用
+     */
+    static qint64 estimateDisplayListBytes(fz_context* ctx, fz_page* page);
+
 private:
     QString m_documentPath;                     // 文档路径
     fz_context* m_context;                      // MuPDF context (独立实例)
     fz_document* m_document;                    // MuPDF document
     int m_pageCount;                            // 文档页数
     mutable QVector<QSizeF> m_pageSizeCache;    // 页面尺寸缓存
+    QBitArray m_pageSizeEstimated;              // 页面尺寸是否为估算值
     mutable QString m_lastError;                // 最后的错误信息
+    DisplayListCache m_displayListCache;        // 页面显示列表缓存（独立模式）
+    std::shared_ptr<MuPDFDocumentCore> m_core;  // 共享文档核心（共享模式）
+    QImage::Format m_outputFormat;              // 渲染输出格式
 
     PaperEffectEnhancer m_paperEffectEnhancer;
     bool m_paperEffectEnabled;
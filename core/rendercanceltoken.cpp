@@ -0,0 +1,88 @@
+#include "rendercanceltoken.h"
+#include <QMutexLocker>
+#include <cstring>
+
+// ========================================
+// RenderCancelToken
+// ========================================
+RenderCancelToken::RenderCancelToken()
+    : m_cancelled(false)
+    , m_cancelledCount(0)
+{
+}
+
+void RenderCancelToken::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_cancelled.store(true, std::memory_order_release);
+
+    // MuPDF 以普通 int 轮询 abort，按 fz_cookie 的约定直接写入
+    for (fz_cookie* cookie : m_cookies) {
+        cookie->abort = 1;
+    }
+}
+
+void RenderCancelToken::progress(int* done, int* total) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    int sumDone = 0;
+    int sumTotal = 0;
+    for (const fz_cookie* cookie : m_cookies) {
+        sumDone += cookie->progress;
+        sumTotal += static_cast<int>(cookie->progress_max);
+    }
+
+    if (done) *done = sumDone;
+    if (total) *total = sumTotal;
+}
+
+void RenderCancelToken::attach(fz_cookie* cookie)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // 挂接前已取消：调用一开始就会中止
+    if (m_cancelled.load(std::memory_order_acquire)) {
+        cookie->abort = 1;
+    }
+    m_cookies.append(cookie);
+}
+
+void RenderCancelToken::detach(fz_cookie* cookie)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cookies.removeOne(cookie);
+}
+
+// ========================================
+// RenderCancelScope
+// ========================================
+RenderCancelScope::RenderCancelScope(RenderCancelToken* token)
+    : m_token(token)
+{
+    memset(&m_cookie, 0, sizeof(m_cookie));
+
+    if (m_token) {
+        m_token->attach(&m_cookie);
+    }
+}
+
+RenderCancelScope::~RenderCancelScope()
+{
+    if (m_token) {
+        m_token->detach(&m_cookie);
+    }
+}
+
+bool RenderCancelScope::aborted() const
+{
+    return m_token && (m_cookie.abort || m_token->isCancelled());
+}
+
+void RenderCancelScope::markCancelled()
+{
+    if (m_token) {
+        m_token->m_cancelledCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef RENDERCANCELTOKEN_H
+#define RENDERCANCELTOKEN_H
+
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+extern "C" {
+#include <mupdf/fitz.h>
+}
+
+/**
+ * @brief 渲染/文本提取的取消令牌（基于 fz_cookie）
+ *
+ * 调度方持有令牌并在任意线程调用 cancel()；渲染方把令牌传给
+ * PerThreadMuPDFRenderer 的渲染/提取接口。每次调用使用自己的 fz_cookie，
+ * 执行期间挂接到令牌上，cancel() 会置位所有已挂接 cookie 的 abort 标志，
+ * MuPDF 在解释/光栅化过程中检查该标志并尽快返回。
+ *
+ * 同一令牌可以被多个线程上的多次调用共享（例如同一批次的所有任务），
+ * 一次 cancel() 即可中止全部。令牌取消后不可恢复，需要时创建新令牌。
+ */
+class RenderCancelToken
+{
+public:
+    RenderCancelToken();
+
+    RenderCancelToken(const RenderCancelToken&) = delete;
+    RenderCancelToken& operator=(const RenderCancelToken&) = delete;
+
+    /**
+     * @brief 请求取消（线程安全）
+     */
+    void cancel();
+
+    /**
+     * @brief 是否已请求取消
+     */
+    bool isCancelled() const { return m_cancelled.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 当前挂接的调用的进度（已完成 / 总量，MuPDF 按显示列表节点计数）
+     *
+     * 总量未知时 progressMax 为 0
+     */
+    void progress(int* done, int* total) const;
+
+    /**
+     * @brief 因本令牌被中止的调用次数
+     */
+    int cancelledCount() const { return m_cancelledCount.load(std::memory_order_relaxed); }
+
+private:
+    friend class RenderCancelScope;
+
+    void attach(fz_cookie* cookie);
+    void detach(fz_cookie* cookie);
+
+    mutable QMutex m_mutex;
+    QVector<fz_cookie*> m_cookies;      ///< 正在执行的调用的 cookie
+    std::atomic_bool m_cancelled;
+    std::atomic_int m_cancelledCount;
+};
+
+/**
+ * @brief 单次调用使用的 fz_cookie，构造时挂接到令牌，析构时解除
+ *
+ * 在 fz_try 之外构造，保证 MuPDF 异常跳转后仍能正常析构
+ */
+class RenderCancelScope
+{
+public:
+    explicit RenderCancelScope(RenderCancelToken* token);
+    ~RenderCancelScope();
+
+    RenderCancelScope(const RenderCancelScope&) = delete;
+    RenderCancelScope& operator=(const RenderCancelScope&) = delete;
+
+    /**
+     * @brief 传给 MuPDF 的 cookie（没有令牌时为 nullptr）
+     */
+    fz_cookie* cookie() { return m_token ? &m_cookie : nullptr; }
+
+    /**
+     * @brief 本次调用是否已被中止（调用方据此丢弃不完整的结果）
+     */
+    bool aborted() const;
+
+    /**
+     * @brief 记录一次被中止的调用（计入令牌统计）
+     */
+    void markCancelled();
+
+private:
+    RenderCancelToken* m_token;
+    fz_cookie m_cookie;
+};
+
+using RenderCancelTokenPtr = std::shared_ptr<RenderCancelToken>;
+
+#endif // RENDERCANCELTOKEN_H
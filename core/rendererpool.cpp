@@ -0,0 +1,328 @@
+#include "rendererpool.h"
+#include "perthreadmupdfrenderer.h"
+#include "mupdfdocumentcore.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QThreadStorage>
+#include <atomic>
+#include <vector>
+
+namespace {
+
+// 所有线程合计保留的空闲渲染器上限（每个都持有克隆的 context 和字形缓存）
+constexpr int MAX_IDLE_RENDERERS = 16;
+
+std::atomic<quint64> s_nextThreadId{1};
+
+} // namespace
+
+/**
+ * @brief 线程标识，线程结束时由 QThreadStorage 销毁，顺带释放该线程的渲染器
+ */
+struct RendererPoolThreadToken
+{
+    explicit RendererPoolThreadToken(quint64 threadId) : id(threadId) {}
+    ~RendererPoolThreadToken() { RendererPool::instance().dropThread(id); }
+
+    quint64 id;
+};
+
+namespace {
+QThreadStorage<RendererPoolThreadToken*> s_threadTokens;
+}
+
+// ========================================
+// RendererPool::Lease
+// ========================================
+RendererPool::Lease::~Lease()
+{
+    release();
+}
+
+RendererPool::Lease::Lease(Lease&& other) noexcept
+    : m_pool(other.m_pool)
+    , m_entry(std::move(other.m_entry))
+{
+    other.m_pool = nullptr;
+}
+
+RendererPool::Lease& RendererPool::Lease::operator=(Lease&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_pool = other.m_pool;
+        m_entry = std::move(other.m_entry);
+        other.m_pool = nullptr;
+    }
+    return *this;
+}
+
+PerThreadMuPDFRenderer* RendererPool::Lease::get() const
+{
+    return m_entry ? m_entry->renderer.get() : nullptr;
+}
+
+void RendererPool::Lease::release()
+{
+    if (m_pool && m_entry) {
+        m_pool->release(m_entry);
+    }
+    m_pool = nullptr;
+    m_entry.reset();
+}
+
+// ========================================
+// RendererPool
+// ========================================
+RendererPool& RendererPool::instance()
+{
+    static RendererPool pool;
+    return pool;
+}
+
+RendererPool::RendererPool()
+    : m_useSequence(0)
+    , m_hitCount(0)
+    , m_missCount(0)
+    , m_openCostSavedUs(0)
+    , m_invalidatedCount(0)
+    , m_threadDropCount(0)
+    , m_trimmedCount(0)
+{
+}
+
+RendererPool::~RendererPool()
+{
+    m_entries.clear();
+}
+
+RendererPool::Lease RendererPool::acquire(const QString& documentPath)
+{
+    Lease lease;
+    if (documentPath.isEmpty()) {
+        return lease;
+    }
+
+    Key key(currentThreadId(), documentPath);
+    bool reentrant = false;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            std::shared_ptr<Entry> entry = it.value();
+            if (!entry->inUse) {
+                entry->inUse = true;
+                m_hitCount++;
+                m_openCostSavedUs += entry->openCostUs;
+
+                lease.m_pool = this;
+                lease.m_entry = entry;
+                return lease;
+            }
+            reentrant = true;
+        }
+
+        m_missCount++;
+    }
+
+    // 未命中：在锁外创建，避免阻塞其他线程
+    QElapsedTimer timer;
+    timer.start();
+
+    std::shared_ptr<MuPDFDocumentCore> core = MuPDFDocumentCore::acquire(documentPath);
+    if (!core) {
+        return lease;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->key = key;
+    entry->renderer = std::make_unique<PerThreadMuPDFRenderer>(core);
+    entry->core = core.get();
+    entry->openCostUs = timer.nsecsElapsed() / 1000;
+    entry->inUse = true;
+    entry->pooled = !reentrant;
+
+    if (!entry->renderer->isDocumentLoaded()) {
+        return lease;
+    }
+
+    if (entry->pooled) {
+        QMutexLocker locker(&m_mutex);
+        m_entries.insert(key, entry);
+    }
+
+    lease.m_pool = this;
+    lease.m_entry = entry;
+    return lease;
+}
+
+void RendererPool::release(const std::shared_ptr<Entry>& entry)
+{
+    std::vector<std::unique_ptr<PerThreadMuPDFRenderer>> doomed;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        entry->inUse = false;
+        entry->lastUsed = ++m_useSequence;
+
+        if (entry->stale || !entry->pooled) {
+            auto it = m_entries.find(entry->key);
+            if (it != m_entries.end() && it.value() == entry) {
+                m_entries.erase(it);
+            }
+            doomed.push_back(std::move(entry->renderer));
+        } else {
+            trimIdleLocked(doomed);
+        }
+    }
+
+    // 在锁外释放渲染器（可能触发文档关闭）
+}
+
+quint64 RendererPool::currentThreadId()
+{
+    if (!s_threadTokens.hasLocalData()) {
+        s_threadTokens.setLocalData(new RendererPoolThreadToken(s_nextThreadId.fetch_add(1)));
+    }
+    return s_threadTokens.localData()->id;
+}
+
+void RendererPool::dropThread(quint64 threadId)
+{
+    std::vector<std::unique_ptr<PerThreadMuPDFRenderer>> doomed;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it.key().first != threadId) {
+                ++it;
+                continue;
+            }
+
+            std::shared_ptr<Entry> entry = it.value();
+            if (entry->inUse) {
+                // 不应发生（借出的 Lease 不会比线程活得更久），保险起见归还时释放
+                entry->stale = true;
+                ++it;
+            } else {
+                doomed.push_back(std::move(entry->renderer));
+                it = m_entries.erase(it);
+            }
+        }
+
+        m_threadDropCount += qint64(doomed.size());
+    }
+
+    if (!doomed.empty()) {
+        qDebug() << "RendererPool: Released" << doomed.size() << "renderers of finished thread";
+    }
+}
+
+void RendererPool::trimIdleLocked(std::vector<std::unique_ptr<PerThreadMuPDFRenderer>>& doomed)
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    int idleCount = 0;
+    for (const std::shared_ptr<Entry>& entry : std::as_const(m_entries)) {
+        if (!entry->inUse) {
+            idleCount++;
+        }
+    }
+
+    while (idleCount > MAX_IDLE_RENDERERS) {
+        auto oldest = m_entries.end();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (!it.value()->inUse &&
+                (oldest == m_entries.end() || it.value()->lastUsed < oldest.value()->lastUsed)) {
+                oldest = it;
+            }
+        }
+        if (oldest == m_entries.end()) {
+            break;
+        }
+
+        doomed.push_back(std::move(oldest.value()->renderer));
+        m_entries.erase(oldest);
+        m_trimmedCount++;
+        idleCount--;
+    }
+}
+
+void RendererPool::retainDocument(const std::shared_ptr<MuPDFDocumentCore>& core)
+{
+    if (!core) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_documentOwners[core.get()]++;
+}
+
+void RendererPool::releaseDocument(const std::shared_ptr<MuPDFDocumentCore>& core)
+{
+    if (!core) {
+        return;
+    }
+
+    std::vector<std::unique_ptr<PerThreadMuPDFRenderer>> doomed;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // 同一文件在其他会话中仍然打开（共享同一个核心）时保留渲染器
+        auto owner = m_documentOwners.find(core.get());
+        if (owner != m_documentOwners.end()) {
+            if (--owner.value() > 0) {
+                return;
+            }
+            m_documentOwners.erase(owner);
+        }
+
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            std::shared_ptr<Entry> entry = it.value();
+            if (entry->core != core.get()) {
+                ++it;
+                continue;
+            }
+
+            m_invalidatedCount++;
+
+            if (entry->inUse) {
+                // 正在使用，归还时释放
+                entry->stale = true;
+                ++it;
+            } else {
+                doomed.push_back(std::move(entry->renderer));
+                it = m_entries.erase(it);
+            }
+        }
+    }
+
+    if (!doomed.empty()) {
+        qDebug() << "RendererPool: Released" << doomed.size()
+                 << "idle renderers for" << core->documentPath();
+    }
+}
+
+QString RendererPool::getStatistics() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    qint64 total = m_hitCount + m_missCount;
+    double hitRate = (total > 0) ? (m_hitCount * 100.0 / total) : 0.0;
+
+    return QString("Renderer Pool: %1 renderers, Hit Rate: %2%, Hits: %3, Misses: %4, "
+                   "Open time saved: %5ms, Invalidated: %6, Thread exits: %7, Trimmed: %8")
+        .arg(m_entries.size())
+        .arg(hitRate, 0, 'f', 1)
+        .arg(m_hitCount)
+        .arg(m_missCount)
+        .arg(m_openCostSavedUs / 1000.0, 0, 'f', 1)
+        .arg(m_invalidatedCount)
+        .arg(m_threadDropCount)
+        .arg(m_trimmedCount);
+}
@@ -0,0 +1,147 @@
+#ifndef RENDERERPOOL_H
+#define RENDERERPOOL_H
+
+#include <QString>
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+#include <memory>
+#include <vector>
+
+class PerThreadMuPDFRenderer;
+class MuPDFDocumentCore;
+
+/**
+ * @brief 按线程保留的渲染器池
+ *
+ * 线程池中的任务每次 run() 结束都会丢弃渲染器，下一批次又要重新克隆 context、
+ * 重新预热字形缓存。渲染器池按（工作线程, 文档路径）保留一个已打开的渲染器，
+ * 同一线程上的后续批次直接复用。
+ *
+ * 渲染器通过 Lease 借出，Lease 析构时归还。
+ *
+ * 生命周期：
+ * - 线程结束时（例如线程池回收空闲线程）释放该线程的全部渲染器；
+ *   线程以递增编号标识（存放在 QThreadStorage 中），不会因为新线程
+ *   复用旧线程的地址而接管失效的条目
+ * - 空闲渲染器超过上限时释放最久未使用的
+ * - 文档按会话登记（retainDocument / releaseDocument），最后一个打开该文档
+ *   核心的会话关闭时，空闲的渲染器立即释放，正在使用的在归还时释放；
+ *   同一文件在其他标签页中仍然打开时不受影响
+ *
+ * 条目本身放在共享表中而不是线程局部存储里，这样 UI 线程可以直接释放
+ * 其他线程的空闲渲染器，而不必等待这些线程再次运行。
+ */
+class RendererPool
+{
+private:
+    struct Entry;
+
+public:
+    /**
+     * @brief 借出的渲染器，析构时自动归还
+     */
+    class Lease
+    {
+    public:
+        Lease() = default;
+        ~Lease();
+
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        PerThreadMuPDFRenderer* get() const;
+        PerThreadMuPDFRenderer* operator->() const { return get(); }
+        explicit operator bool() const { return get() != nullptr; }
+
+    private:
+        friend class RendererPool;
+
+        void release();
+
+        RendererPool* m_pool = nullptr;
+        std::shared_ptr<Entry> m_entry;
+    };
+
+    static RendererPool& instance();
+
+    /**
+     * @brief 为当前线程借出指定文档的渲染器
+     *
+     * 命中时直接返回已打开的渲染器；未命中时从共享文档核心创建
+     * @return 文档打开失败时返回空 Lease
+     */
+    Lease acquire(const QString& documentPath);
+
+    /**
+     * @brief 会话打开文档核心时登记
+     */
+    void retainDocument(const std::shared_ptr<MuPDFDocumentCore>& core);
+
+    /**
+     * @brief 会话关闭文档时注销；没有其他会话持有该核心时释放其渲染器
+     */
+    void releaseDocument(const std::shared_ptr<MuPDFDocumentCore>& core);
+
+    /**
+     * @brief 获取统计信息（调试用）
+     */
+    QString getStatistics() const;
+
+private:
+    RendererPool();
+    ~RendererPool();
+
+    RendererPool(const RendererPool&) = delete;
+    RendererPool& operator=(const RendererPool&) = delete;
+
+    void release(const std::shared_ptr<Entry>& entry);
+
+    /**
+     * @brief 当前线程的编号（首次调用时分配，线程结束时释放其渲染器）
+     */
+    quint64 currentThreadId();
+
+    /**
+     * @brief 释放已结束线程的全部渲染器（由线程局部存储在线程退出时调用）
+     */
+    void dropThread(quint64 threadId);
+
+    /**
+     * @brief 空闲渲染器超过上限时移出最久未使用的（调用前必须已持有锁）
+     */
+    void trimIdleLocked(std::vector<std::unique_ptr<PerThreadMuPDFRenderer>>& doomed);
+
+    friend struct RendererPoolThreadToken;
+
+    using Key = QPair<quint64, QString>;    ///< (线程编号, 文档路径)
+
+    struct Entry {
+        Key key;
+        std::unique_ptr<PerThreadMuPDFRenderer> renderer;
+        const MuPDFDocumentCore* core = nullptr;    ///< 渲染器所属的文档核心
+        qint64 openCostUs = 0;      ///< 创建渲染器的耗时
+        quint64 lastUsed = 0;       ///< 最近一次归还的序号
+        bool inUse = false;
+        bool stale = false;         ///< 已失效，归还时释放
+        bool pooled = true;         ///< 是否在池中（同线程重入时临时创建的不入池）
+    };
+
+    mutable QMutex m_mutex;
+    QHash<Key, std::shared_ptr<Entry>> m_entries;
+    QHash<const MuPDFDocumentCore*, int> m_documentOwners;  ///< 核心 -> 打开它的会话数
+    quint64 m_useSequence;
+
+    // 统计信息
+    qint64 m_hitCount;
+    qint64 m_missCount;
+    qint64 m_openCostSavedUs;
+    qint64 m_invalidatedCount;
+    qint64 m_threadDropCount;       ///< 随线程结束释放的渲染器
+    qint64 m_trimmedCount;          ///< 超过空闲上限释放的渲染器
+};
+
+#endif // RENDERERPOOL_H
@@ -36,8 +36,7 @@ PDFInteractionHandler::~PDFInteractionHandler()
 }
 
 void PDFInteractionHandler::startSearch(const QString& query,
-                                        bool caseSensitive,
-                                        bool wholeWords,
+                                        const SearchOptions& options,
                                         int startPage)
 {
     if (!m_searchManager) {
@@ -49,11 +48,6 @@ void PDFInteractionHandler::startSearch(const QString& query,
         return;
     }
 
-    SearchOptions options;
-    options.caseSensitive = caseSensitive;
-    options.wholeWords = wholeWords;
-    options.maxResults = 1000;
-
     m_searchManager->startSearch(query, options, startPage);
 }
 
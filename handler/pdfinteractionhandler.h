@@ -7,12 +7,13 @@
 #include <QString>
 #include <memory>
 
+#include "datastructure.h"
+
 class PerThreadMuPDFRenderer;
 class TextCacheManager;
 class SearchManager;
 class LinkManager;
 class TextSelector;
-struct SearchResult;
 struct PDFLink;
 struct TextSelection;
 
@@ -40,8 +41,7 @@ public:
      * @brief 开始搜索
      */
     void startSearch(const QString& query,
-                     bool caseSensitive = false,
-                     bool wholeWords = false,
+                     const SearchOptions& options = SearchOptions(),
                      int startPage = 0);
 
     /**
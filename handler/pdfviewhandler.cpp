@@ -1,4 +1,5 @@
 #include "pdfviewhandler.h"
+#include "pagelayoutindex.h"
 #include "perthreadmupdfrenderer.h"
 #include "appconfig.h"
 #include <QDebug>
@@ -281,103 +282,122 @@ void PDFViewHandler::requestSetContinuousScroll(bool continuous)
 bool PDFViewHandler::calculatePagePositions(double zoom,
                                             int rotation,
                                             int pageCount,
-                                            QVector<int>& outPositions,
                                             QVector<int>& outHeights)
 {
     if (!m_renderer || !m_renderer->isDocumentLoaded()) {
         return false;
     }
 
-    outPositions.clear();
-    outPositions.reserve(pageCount);
     outHeights.clear();
     outHeights.reserve(pageCount);
 
-    const int pageGap = AppConfig::PAGE_GAP;
-    int currentY = 0;
-
     for (int i = 0; i < pageCount; ++i) {
-        QSizeF pageSize = m_renderer->pageSize(i);
-
-        // 考虑旋转
-        if (rotation == 90 || rotation == 270) {
-            pageSize.transpose();
-        }
-
-        int height = qRound(pageSize.height() * zoom);
-
-        outPositions.append(currentY);
-        outHeights.append(height);
-
-        currentY += height + pageGap;
+        // 与渲染结果的取整方式一致（已考虑旋转）
+        QSize pixelSize = PerThreadMuPDFRenderer::pixelSize(m_renderer->pageSize(i), zoom, rotation);
+        outHeights.append(pixelSize.height());
     }
 
-    emit pagePositionsCalculated(outPositions, outHeights);
+    emit pagePositionsCalculated(outHeights);
     return true;
 }
 
 int PDFViewHandler::calculateCurrentPageFromScroll(int scrollY,
                                                    int margin,
-                                                   const QVector<int>& pageYPositions) const
+                                                   const PageLayoutIndex& layout) const
 {
-    if (pageYPositions.isEmpty()) {
-        return -1;
-    }
-
-    int adjustedY = scrollY - margin;
-
-    // 找到当前显示的页面
-    for (int i = pageYPositions.size() - 1; i >= 0; --i) {
-        if (adjustedY >= pageYPositions[i]) {
-            return i;
-        }
-    }
-
-    return 0;
+    // 找到当前显示的页面（顶部不低于滚动位置的最后一页）
+    return layout.pageAt(scrollY - margin);
 }
 
 int PDFViewHandler::getScrollPositionForPage(int pageIndex,
                                              int margin,
-                                             const QVector<int>& pageYPositions) const
+                                             const PageLayoutIndex& layout) const
 {
-    if (pageYPositions.isEmpty()) {
+    if (layout.isEmpty()) {
         return -1;
     }
 
-    if (pageIndex < 0 || pageIndex >= pageYPositions.size()) {
+    if (pageIndex < 0 || pageIndex >= layout.pageCount()) {
         return -1;
     }
 
-    return pageYPositions[pageIndex] + margin;
+    return layout.pageTop(pageIndex) + margin;
 }
 
 QSet<int> PDFViewHandler::getVisiblePages(const QRect& visibleRect,
                                           int preloadMargin,
                                           int margin,
-                                          const QVector<int>& pageYPositions,
-                                          const QVector<int>& pageHeights) const
+                                          const PageLayoutIndex& layout) const
+{
+    return getVisiblePages(visibleRect, preloadMargin, preloadMargin, margin, layout);
+}
+
+QSet<int> PDFViewHandler::getVisiblePages(const QRect& visibleRect,
+                                          int marginBefore,
+                                          int marginAfter,
+                                          int margin,
+                                          const PageLayoutIndex& layout) const
 {
     QSet<int> visiblePages;
 
-    if (pageYPositions.isEmpty()) {
+    // 扩展可见区域，预加载周围页面（换算为布局坐标）
+    QRect extended = visibleRect.adjusted(0, -marginBefore, 0, marginAfter);
+
+    int first = 0;
+    int last = -1;
+    if (!layout.pagesInRange(extended.top() - margin, extended.bottom() - margin, &first, &last)) {
         return visiblePages;
     }
 
-    // 扩展可见区域，预加载周围页面
-    QRect extended = visibleRect.adjusted(0, -preloadMargin, 0, preloadMargin);
+    for (int i = first; i <= last; ++i) {
+        visiblePages.insert(i);
+    }
+
+    return visiblePages;
+}
+
+QSize PDFViewHandler::getPagePixelSize(int pageIndex, double zoom, int rotation) const
+{
+    if (!m_renderer || !m_renderer->isDocumentLoaded()) {
+        return QSize();
+    }
 
-    // 找出可见的页面
-    for (int i = 0; i < pageYPositions.size(); ++i) {
-        int pageTop = pageYPositions[i] + margin;
-        int pageBottom = pageTop + pageHeights[i];
+    // 与 MuPDF 渲染相同的取整，瓦片拼接和替身缩放不会差出 1 像素
+    return PerThreadMuPDFRenderer::pixelSize(m_renderer->pageSize(pageIndex), zoom, rotation);
+}
 
-        // 判断页面是否在扩展的可见区域内
-        if (pageBottom >= extended.top() && pageTop <= extended.bottom()) {
-            visiblePages.insert(i);
+QVector<QPoint> PDFViewHandler::getTilesInRect(const QRect& rect,
+                                               const QRect& pageRect,
+                                               int tileSize) const
+{
+    QVector<QPoint> tiles;
+
+    QRect area = rect.intersected(pageRect);
+    if (area.isEmpty() || tileSize <= 0) {
+        return tiles;
+    }
+
+    // 转换到页面局部坐标
+    area.translate(-pageRect.topLeft());
+
+    int firstCol = area.left() / tileSize;
+    int lastCol = area.right() / tileSize;
+    int firstRow = area.top() / tileSize;
+    int lastRow = area.bottom() / tileSize;
+
+    tiles.reserve((lastCol - firstCol + 1) * (lastRow - firstRow + 1));
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            tiles.append(QPoint(col, row));
         }
     }
 
-    return visiblePages;
+    return tiles;
+}
+
+bool PDFViewHandler::useTiledRendering(double zoom, bool paperEffectEnabled)
+{
+    return !paperEffectEnabled && zoom >= AppConfig::TILE_ZOOM_THRESHOLD - 0.001;
 }
 
 void PDFViewHandler::requestSetRotation(int rotation)
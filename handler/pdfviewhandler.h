@@ -7,10 +7,12 @@
 #include <QVector>
 #include <QSet>
 #include <QRect>
+#include <QPoint>
 
 #include "datastructure.h"
 
 class PerThreadMuPDFRenderer;
+class PageLayoutIndex;
 
 /**
  * @brief PDF视图处理器 - 处理视图相关的计算和逻辑
@@ -157,37 +159,67 @@ public:
     void requestSetContinuousScroll(bool continuous);
 
     /**
-     * @brief 计算连续滚动模式下的页面位置
+     * @brief 计算连续滚动模式下的页面高度（位置由 PageLayoutIndex 累加得出）
      * @return 成功返回true，失败返回false
      */
     bool calculatePagePositions(double zoom,
                                 int rotation,
                                 int pageCount,
-                                QVector<int>& outPositions,
                                 QVector<int>& outHeights);
 
     /**
-     * @brief 根据滚动位置计算当前页码
+     * @brief 根据滚动位置计算当前页码（O(log n)）
      */
     int calculateCurrentPageFromScroll(int scrollY,
                                        int margin,
-                                       const QVector<int>& pageYPositions) const;
+                                       const PageLayoutIndex& layout) const;
 
     /**
      * @brief 获取指定页码的滚动目标位置
      */
     int getScrollPositionForPage(int pageIndex,
                                  int margin,
-                                 const QVector<int>& pageYPositions) const;
+                                 const PageLayoutIndex& layout) const;
 
     /**
-     * @brief 获取可见页面集合
+     * @brief 获取可见页面集合（O(log n + 可见页数)）
      */
     QSet<int> getVisiblePages(const QRect& visibleRect,
                               int preloadMargin,
                               int margin,
-                              const QVector<int>& pageYPositions,
-                              const QVector<int>& pageHeights) const;
+                              const PageLayoutIndex& layout) const;
+
+    /**
+     * @brief 获取可见页面集合（视口上下使用不同的预加载边距）
+     */
+    QSet<int> getVisiblePages(const QRect& visibleRect,
+                              int marginBefore,
+                              int marginAfter,
+                              int margin,
+                              const PageLayoutIndex& layout) const;
+
+    /**
+     * @brief 获取页面在指定缩放/旋转下的像素尺寸
+     */
+    QSize getPagePixelSize(int pageIndex, double zoom, int rotation) const;
+
+    /**
+     * @brief 获取与区域相交的瓦片坐标
+     * @param rect 区域（控件坐标）
+     * @param pageRect 页面在控件中的矩形
+     * @param tileSize 瓦片边长
+     * @return 瓦片坐标（x为列号，y为行号）
+     */
+    QVector<QPoint> getTilesInRect(const QRect& rect,
+                                   const QRect& pageRect,
+                                   int tileSize) const;
+
+    /**
+     * @brief 该缩放比例下是否使用瓦片渲染
+     *
+     * 纸质效果依赖整页统计（自适应阈值、纹理），逐瓦片处理会出现接缝，因此开启时仍整页渲染
+     */
+    static bool useTiledRendering(double zoom, bool paperEffectEnabled);
 
 
     /**
@@ -244,11 +276,9 @@ signals:
 
     /**
      * @brief 页面位置计算完成
-     * @param positions Y位置列表
      * @param heights 高度列表
      */
-    void pagePositionsCalculated(const QVector<int>& positions,
-                                 const QVector<int>& heights);
+    void pagePositionsCalculated(const QVector<int>& heights);
 
     /**
      * @brief 需要滚动到指定位置
@@ -0,0 +1,225 @@
+#include "cachegovernor.h"
+#include "appconfig.h"
+#include <QDebug>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+
+// 超出预算时释放到预算的 90%，避免每次新增页面都触发释放
+constexpr qint64 TARGET_PERCENT = 90;
+
+// 合并预算检查请求的延迟（毫秒）
+constexpr int ENFORCE_DELAY_MS = 200;
+
+} // namespace
+
+CacheGovernor& CacheGovernor::instance()
+{
+    static CacheGovernor instance;
+    return instance;
+}
+
+CacheGovernor::CacheGovernor()
+    : m_active(nullptr)
+    , m_activationCounter(0)
+    , m_budget(AppConfig::instance().globalCacheBudgetBytes())
+    , m_enforcePending(false)
+    , m_budgetUnreachable(false)
+    , m_enforceCount(0)
+    , m_backgroundReleased(0)
+    , m_activeReleased(0)
+{
+}
+
+void CacheGovernor::registerClient(CacheGovernorClient* client)
+{
+    if (!client) {
+        return;
+    }
+
+    for (const ClientInfo& info : m_clients) {
+        if (info.client == client) {
+            return;
+        }
+    }
+
+    ClientInfo info;
+    info.client = client;
+    m_clients.append(info);
+}
+
+void CacheGovernor::unregisterClient(CacheGovernorClient* client)
+{
+    m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(),
+                                   [client](const ClientInfo& info) {
+                                       return info.client == client;
+                                   }),
+                    m_clients.end());
+
+    if (m_active == client) {
+        m_active = nullptr;
+    }
+}
+
+void CacheGovernor::setActiveClient(CacheGovernorClient* client)
+{
+    m_active = nullptr;
+
+    for (ClientInfo& info : m_clients) {
+        if (info.client == client) {
+            info.lastActive = ++m_activationCounter;
+            m_active = client;
+            break;
+        }
+    }
+
+    // 刚转到后台的标签页可以让出内存给新的当前标签页
+    requestEnforce();
+}
+
+void CacheGovernor::setBudget(qint64 bytes)
+{
+    m_budget = qMax<qint64>(1, bytes);
+    enforce();
+}
+
+void CacheGovernor::requestEnforce()
+{
+    if (m_enforcePending) {
+        return;
+    }
+
+    m_enforcePending = true;
+    QTimer::singleShot(ENFORCE_DELAY_MS, [this]() {
+        m_enforcePending = false;
+        enforce();
+    });
+}
+
+qint64 CacheGovernor::enforce()
+{
+    const qint64 total = totalUsage();
+    if (total <= m_budget) {
+        m_budgetUnreachable = false;
+        return 0;
+    }
+
+    m_enforceCount++;
+
+    const qint64 excess = total - m_budget * TARGET_PERCENT / 100;
+    qint64 freed = 0;
+
+    // 先从后台标签页释放，最久未激活的优先
+    for (const ClientInfo& info : backgroundClients()) {
+        if (freed >= excess) {
+            break;
+        }
+        qint64 released = info.client->releaseCacheMemory(excess - freed, false);
+        m_backgroundReleased += released;
+        freed += released;
+    }
+
+    // 后台标签页不够时才动当前标签页（保留可见页面）
+    if (freed < excess && m_active) {
+        qint64 released = m_active->releaseCacheMemory(excess - freed, true);
+        m_activeReleased += released;
+        freed += released;
+    }
+
+    // 滚动时每次渲染都会触发检查，只在调试模式下逐次输出；
+    // 否则只在释放后仍无法回到预算内时提示一次
+    const bool unreachable = (total - freed > m_budget);
+    if (AppConfig::instance().debugMode()) {
+        qDebug() << "CacheGovernor: Over budget by" << (total - m_budget) / 1024 << "KB,"
+                 << "released" << freed / 1024 << "KB from" << m_clients.size() << "sessions";
+    } else if (unreachable && !m_budgetUnreachable) {
+        qDebug() << "CacheGovernor: Cannot get under budget of" << m_budget / (1024 * 1024) << "MB,"
+                 << "still using" << (total - freed) / (1024 * 1024) << "MB";
+    }
+    m_budgetUnreachable = unreachable;
+
+    return freed;
+}
+
+QVector<CacheGovernor::ClientInfo> CacheGovernor::backgroundClients() const
+{
+    QVector<ClientInfo> clients;
+    for (const ClientInfo& info : m_clients) {
+        if (info.client != m_active) {
+            clients.append(info);
+        }
+    }
+
+    std::stable_sort(clients.begin(), clients.end(),
+                     [](const ClientInfo& a, const ClientInfo& b) {
+                         return a.lastActive < b.lastActive;
+                     });
+    return clients;
+}
+
+QVector<CacheGovernor::ClientReport> CacheGovernor::usageReport() const
+{
+    QVector<ClientReport> reports;
+
+    auto append = [&reports, this](CacheGovernorClient* client) {
+        ClientReport report;
+        report.name = client->cacheClientName();
+        report.usage = client->cacheUsage();
+        report.active = (client == m_active);
+        reports.append(report);
+    };
+
+    if (m_active) {
+        append(m_active);
+    }
+
+    QVector<ClientInfo> background = backgroundClients();
+    for (auto it = background.crbegin(); it != background.crend(); ++it) {
+        append(it->client);
+    }
+
+    return reports;
+}
+
+qint64 CacheGovernor::totalUsage() const
+{
+    qint64 total = 0;
+    for (const ClientInfo& info : m_clients) {
+        total += info.client->cacheUsage().total();
+    }
+    return total;
+}
+
+QString CacheGovernor::getStatistics() const
+{
+    const double mb = 1024.0 * 1024.0;
+    QVector<ClientReport> reports = usageReport();
+
+    qint64 total = 0;
+    for (const ClientReport& report : reports) {
+        total += report.usage.total();
+    }
+
+    QString stats = QString("Global Cache: %1/%2 MB, %3 tabs, Over budget: %4, "
+                            "Released: %5 MB background / %6 MB active")
+        .arg(total / mb, 0, 'f', 1)
+        .arg(m_budget / mb, 0, 'f', 0)
+        .arg(reports.size())
+        .arg(m_enforceCount)
+        .arg(m_backgroundReleased / mb, 0, 'f', 1)
+        .arg(m_activeReleased / mb, 0, 'f', 1);
+
+    for (const ClientReport& report : reports) {
+        stats += QString("\n  %1%2: %3 MB (pages %4, compressed %5, text %6, thumbnails %7)")
+            .arg(report.active ? "* " : "  ")
+            .arg(report.name)
+            .arg(report.usage.total() / mb, 0, 'f', 1)
+            .arg(report.usage.pageBytes / mb, 0, 'f', 1)
+            .arg(report.usage.compressedBytes / mb, 0, 'f', 1)
+            .arg(report.usage.textBytes / mb, 0, 'f', 1)
+            .arg(report.usage.thumbnailBytes / mb, 0, 'f', 1);
+    }
+
+    return stats;
+}
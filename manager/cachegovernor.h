@@ -0,0 +1,137 @@
+#ifndef CACHEGOVERNOR_H
+#define CACHEGOVERNOR_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 一个会话各级缓存的内存占用（字节）
+ */
+struct CacheUsage {
+    qint64 pageBytes = 0;           ///< 页面与瓦片（未压缩）
+    qint64 compressedBytes = 0;     ///< 压缩层
+    qint64 textBytes = 0;           ///< 文本缓存（估算）
+    qint64 thumbnailBytes = 0;      ///< 缩略图
+
+    qint64 total() const { return pageBytes + compressedBytes + textBytes + thumbnailBytes; }
+};
+
+/**
+ * @brief 接受全局调控的缓存持有者（每个文档会话一个）
+ */
+class CacheGovernorClient
+{
+public:
+    virtual ~CacheGovernorClient() = default;
+
+    /**
+     * @brief 显示名称（用于统计）
+     */
+    virtual QString cacheClientName() const = 0;
+
+    /**
+     * @brief 当前各级缓存的占用
+     */
+    virtual CacheUsage cacheUsage() const = 0;
+
+    /**
+     * @brief 释放至少 bytes 字节
+     * @param active 是否为当前标签页，当前标签页应保留可见页面
+     * @return 实际释放的字节数
+     */
+    virtual qint64 releaseCacheMemory(qint64 bytes, bool active) = 0;
+};
+
+/**
+ * @brief 进程级缓存调控器（全局单例）
+ *
+ * 每个会话的页面缓存有各自的水位，打开多个标签页时总占用会成倍增长。
+ * 所有会话在这里登记，调控器把它们的占用加总后与一个全局预算比较，
+ * 超出时释放到预算的 90%：先从后台标签页释放（最久未激活的优先，
+ * 可见页面也可以淘汰），仍不足时才从当前标签页按其淘汰策略释放。
+ *
+ * 只在 UI 线程使用。requestEnforce() 把多次请求合并到下一次事件循环。
+ */
+class CacheGovernor
+{
+public:
+    /**
+     * @brief 一个会话的占用报告
+     */
+    struct ClientReport {
+        QString name;
+        CacheUsage usage;
+        bool active = false;
+    };
+
+    static CacheGovernor& instance();
+
+    void registerClient(CacheGovernorClient* client);
+    void unregisterClient(CacheGovernorClient* client);
+
+    /**
+     * @brief 设置当前标签页的会话（切换标签页时调用，nullptr 表示没有）
+     */
+    void setActiveClient(CacheGovernorClient* client);
+    CacheGovernorClient* activeClient() const { return m_active; }
+
+    /**
+     * @brief 设置全局预算（字节），缩小后立即生效
+     */
+    void setBudget(qint64 bytes);
+    qint64 budget() const { return m_budget; }
+
+    /**
+     * @brief 请求一次预算检查（合并到下一次事件循环执行）
+     */
+    void requestEnforce();
+
+    /**
+     * @brief 立即检查预算，超出时释放
+     * @return 释放的字节数
+     */
+    qint64 enforce();
+
+    /**
+     * @brief 每个会话的占用，当前标签页在前，其余按最近激活排序
+     */
+    QVector<ClientReport> usageReport() const;
+
+    qint64 totalUsage() const;
+
+    /**
+     * @brief 获取统计信息（调试用），包含每个标签页的占用
+     */
+    QString getStatistics() const;
+
+private:
+    CacheGovernor();
+
+    CacheGovernor(const CacheGovernor&) = delete;
+    CacheGovernor& operator=(const CacheGovernor&) = delete;
+
+    struct ClientInfo {
+        CacheGovernorClient* client = nullptr;
+        quint64 lastActive = 0;     ///< 最近一次成为当前标签页的序号
+    };
+
+    /**
+     * @brief 后台会话，最久未激活的在前
+     */
+    QVector<ClientInfo> backgroundClients() const;
+
+private:
+    QVector<ClientInfo> m_clients;
+    CacheGovernorClient* m_active;
+    quint64 m_activationCounter;
+    qint64 m_budget;
+    bool m_enforcePending;
+    bool m_budgetUnreachable;       ///< 上次释放后仍超出预算（避免重复输出日志）
+
+    // 统计信息
+    qint64 m_enforceCount;          ///< 超出预算的次数
+    qint64 m_backgroundReleased;    ///< 从后台标签页释放的字节数
+    qint64 m_activeReleased;        ///< 从当前标签页释放的字节数
+};
+
+#endif // CACHEGOVERNOR_H
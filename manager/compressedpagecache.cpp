@@ -0,0 +1,275 @@
+#include "compressedpagecache.h"
+#include "qoicodec.h"
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+
+CompressedPageCache::CompressedPageCache(qint64 maxBytes)
+    : m_maxBytes(qMax<qint64>(0, maxBytes))
+    , m_totalBytes(0)
+    , m_rawBytes(0)
+    , m_generation(0)
+    , m_hitCount(0)
+    , m_missCount(0)
+    , m_evictCount(0)
+    , m_encodeCount(0)
+    , m_encodeMs(0)
+    , m_decodeMs(0)
+{
+}
+
+quint64 CompressedPageCache::generation() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_generation;
+}
+
+void CompressedPageCache::insert(const PageCacheKey& key, const QImage& image, quint64 generation)
+{
+    if (image.isNull()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (m_maxBytes <= 0 || generation != m_generation) {
+            return;
+        }
+
+        // 之前压缩过的页面（命中后又被淘汰）只更新访问顺序
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            m_order.splice(m_order.begin(), m_order, it->order);
+            return;
+        }
+    }
+
+    // 编码不持锁
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray data = QoiCodec::encode(image);
+    double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+    if (data.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    m_encodeCount++;
+    m_encodeMs += elapsedMs;
+
+    if (generation != m_generation || m_entries.contains(key)) {
+        return;
+    }
+
+    // 压缩效果差的页面（大面积照片）会挤占太多预算，不保留
+    if (data.size() > m_maxBytes / 4) {
+        return;
+    }
+
+    Entry entry;
+    entry.data = data;
+    entry.format = image.format();
+    entry.devicePixelRatio = image.devicePixelRatio();
+    entry.rawBytes = image.sizeInBytes();
+    m_order.push_front(key);
+    entry.order = m_order.begin();
+
+    m_totalBytes += entry.data.size();
+    m_rawBytes += entry.rawBytes;
+    m_entries.insert(key, entry);
+
+    evictLocked();
+}
+
+QImage CompressedPageCache::find(const PageCacheKey& key)
+{
+    QByteArray data;
+    QImage::Format format;
+    qreal devicePixelRatio;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        auto it = m_entries.find(key);
+        if (it == m_entries.end()) {
+            m_missCount++;
+            return QImage();
+        }
+
+        m_order.splice(m_order.begin(), m_order, it->order);
+        data = it->data;    // 隐式共享，解压不持锁
+        format = it->format;
+        devicePixelRatio = it->devicePixelRatio;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QImage image = QoiCodec::decode(data, format);
+    double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+    QMutexLocker locker(&m_mutex);
+
+    if (image.isNull()) {
+        qWarning() << "CompressedPageCache: Failed to decode" << key.toString();
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            removeLocked(it);
+        }
+        m_missCount++;
+        return QImage();
+    }
+
+    image.setDevicePixelRatio(devicePixelRatio);
+    m_hitCount++;
+    m_decodeMs += elapsedMs;
+    return image;
+}
+
+bool CompressedPageCache::contains(const PageCacheKey& key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.contains(key);
+}
+
+void CompressedPageCache::remove(const PageCacheKey& key)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_generation++;
+
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        removeLocked(it);
+    }
+}
+
+void CompressedPageCache::removeByZoomRotation(double zoom, int rotation)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_generation++;
+
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        const PageCacheKey& key = it.key();
+        bool zoomMatch = zoom < 0 || qAbs(key.zoom - zoom) < 0.001;
+        bool rotationMatch = rotation < 0 || key.rotation == rotation;
+
+        if (zoomMatch && rotationMatch) {
+            m_order.erase(it->order);
+            m_totalBytes -= it->data.size();
+            m_rawBytes -= it->rawBytes;
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CompressedPageCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_generation++;
+    m_entries.clear();
+    m_order.clear();
+    m_totalBytes = 0;
+    m_rawBytes = 0;
+}
+
+qint64 CompressedPageCache::release(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const qint64 before = m_totalBytes;
+    while (before - m_totalBytes < bytes && !m_order.empty()) {
+        auto it = m_entries.find(m_order.back());
+        if (it == m_entries.end()) {
+            m_order.pop_back();
+            continue;
+        }
+        removeLocked(it);
+        m_evictCount++;
+    }
+
+    return before - m_totalBytes;
+}
+
+void CompressedPageCache::setMaxBytes(qint64 maxBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    evictLocked();
+}
+
+qint64 CompressedPageCache::maxBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxBytes;
+}
+
+qint64 CompressedPageCache::totalBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_totalBytes;
+}
+
+int CompressedPageCache::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+QString CompressedPageCache::getStatistics() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    qint64 totalAccess = m_hitCount + m_missCount;
+    double hitRate = (totalAccess > 0) ? (m_hitCount * 100.0 / totalAccess) : 0;
+    double ratio = (m_totalBytes > 0) ? (double(m_rawBytes) / m_totalBytes) : 0;
+    double avgEncodeMs = (m_encodeCount > 0) ? (m_encodeMs / m_encodeCount) : 0;
+    double avgDecodeMs = (m_hitCount > 0) ? (m_decodeMs / m_hitCount) : 0;
+    const double mb = 1024.0 * 1024.0;
+
+    return QString("Compressed: %1 pages, %2/%3 MB (%4 MB raw, %5x), "
+                   "Hit Rate: %6%, Hits: %7, Misses: %8, Evicted: %9, "
+                   "Avg encode: %10 ms, Avg decode: %11 ms")
+        .arg(m_entries.size())
+        .arg(m_totalBytes / mb, 0, 'f', 1)
+        .arg(m_maxBytes / mb, 0, 'f', 0)
+        .arg(m_rawBytes / mb, 0, 'f', 1)
+        .arg(ratio, 0, 'f', 1)
+        .arg(hitRate, 0, 'f', 1)
+        .arg(m_hitCount)
+        .arg(m_missCount)
+        .arg(m_evictCount)
+        .arg(avgEncodeMs, 0, 'f', 2)
+        .arg(avgDecodeMs, 0, 'f', 2);
+}
+
+void CompressedPageCache::evictLocked()
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    while (m_totalBytes > m_maxBytes && !m_order.empty()) {
+        auto it = m_entries.find(m_order.back());
+        if (it == m_entries.end()) {
+            m_order.pop_back();
+            continue;
+        }
+        removeLocked(it);
+        m_evictCount++;
+    }
+}
+
+void CompressedPageCache::removeLocked(QHash<PageCacheKey, Entry>::iterator it)
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    m_order.erase(it->order);
+    m_totalBytes -= it->data.size();
+    m_rawBytes -= it->rawBytes;
+    m_entries.erase(it);
+}
@@ -0,0 +1,117 @@
+#ifndef COMPRESSEDPAGECACHE_H
+#define COMPRESSEDPAGECACHE_H
+
+#include "pagecachemanager.h"
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <list>
+
+/**
+ * @brief 压缩页面缓存（页面缓存的第二层）
+ *
+ * PageCacheManager 淘汰的最终渲染以 QOI 无损压缩后保留在这里，按压缩后的
+ * 字节数做 LRU 预算。再次访问时解压并放回内存缓存，代价是一次解压而不是
+ * 一次 MuPDF 渲染。命中后压缩数据继续保留，页面再次被淘汰时无需重新编码。
+ *
+ * 编码通常在后台线程进行，clear()/remove*() 会推进代数，
+ * 代数变化前开始的编码结果在 insert() 时丢弃，保证失效后旧图像不会回流。
+ */
+class CompressedPageCache
+{
+public:
+    explicit CompressedPageCache(qint64 maxBytes);
+
+    CompressedPageCache(const CompressedPageCache&) = delete;
+    CompressedPageCache& operator=(const CompressedPageCache&) = delete;
+
+    /**
+     * @brief 当前代数（开始编码前获取，传给 insert()）
+     */
+    quint64 generation() const;
+
+    /**
+     * @brief 压缩并缓存页面
+     * @param key 规整后的页面缓存键
+     * @param image 最终渲染的图像
+     * @param generation 开始编码前获取的代数，已过期时丢弃
+     */
+    void insert(const PageCacheKey& key, const QImage& image, quint64 generation);
+
+    /**
+     * @brief 解压页面（压缩数据继续保留）
+     * @return 图像，未缓存时返回空QImage
+     */
+    QImage find(const PageCacheKey& key);
+
+    bool contains(const PageCacheKey& key) const;
+
+    void remove(const PageCacheKey& key);
+
+    /**
+     * @brief 移除指定缩放/旋转的页面（参数语义同 PageCacheManager::clearByZoomRotation）
+     */
+    void removeByZoomRotation(double zoom, int rotation);
+
+    void clear();
+
+    /**
+     * @brief 淘汰最久未访问的条目，直到释放至少 bytes 字节
+     * @return 实际释放的字节数
+     */
+    qint64 release(qint64 bytes);
+
+    /**
+     * @brief 设置字节预算（0 表示关闭）
+     */
+    void setMaxBytes(qint64 maxBytes);
+
+    qint64 maxBytes() const;
+    qint64 totalBytes() const;
+    int count() const;
+
+    /**
+     * @brief 获取统计信息（调试用）
+     */
+    QString getStatistics() const;
+
+private:
+    struct Entry {
+        QByteArray data;                            ///< QOI 编码数据
+        QImage::Format format = QImage::Format_Invalid;
+        qreal devicePixelRatio = 1.0;
+        qint64 rawBytes = 0;                        ///< 解压后的大小
+        std::list<PageCacheKey>::iterator order;    ///< 在访问顺序链表中的位置
+    };
+
+    /**
+     * @brief 淘汰直到满足预算（调用前必须已持有锁）
+     */
+    void evictLocked();
+
+    /**
+     * @brief 移除条目（调用前必须已持有锁）
+     */
+    void removeLocked(QHash<PageCacheKey, Entry>::iterator it);
+
+private:
+    mutable QMutex m_mutex;
+    QHash<PageCacheKey, Entry> m_entries;
+    std::list<PageCacheKey> m_order;    ///< 访问顺序，头部为最近访问
+    qint64 m_maxBytes;                  ///< 字节预算（压缩后）
+    qint64 m_totalBytes;                ///< 压缩后总大小
+    qint64 m_rawBytes;                  ///< 解压后总大小（用于统计压缩率）
+    quint64 m_generation;
+
+    // 统计信息
+    qint64 m_hitCount;
+    qint64 m_missCount;
+    qint64 m_evictCount;
+    qint64 m_encodeCount;
+    double m_encodeMs;
+    double m_decodeMs;
+};
+
+#endif // COMPRESSEDPAGECACHE_H
@@ -0,0 +1,610 @@
+#include "diskpagecache.h"
+#include "mupdfdocumentcore.h"
+#include "pagecachemanager.h"
+#include "qoicodec.h"
+#include "appconfig.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QPair>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+#include <mupdf/pdf.h>
+
+namespace {
+
+constexpr quint32 FILE_MAGIC = 0x4D515043;     // "MQPC"
+constexpr quint32 FILE_VERSION = 1;
+constexpr char INDEX_MAGIC[4] = {'M', 'Q', 'D', 'I'};
+constexpr quint32 INDEX_VERSION = 1;
+constexpr int WRITES_PER_INDEX_SAVE = 32;      // 每写入多少个文件保存一次索引
+
+/**
+ * @brief 索引文件头，后面紧跟 count 条 IndexRecord（本机字节序）
+ */
+struct IndexHeader {
+    char magic[4];
+    quint32 version;
+    quint32 count;
+    quint32 reserved;
+};
+
+/**
+ * @brief 定长索引记录，整个文件映射后按数组读取
+ */
+struct IndexRecord {
+    quint64 hash;
+    quint64 lastUse;
+    quint32 bytes;
+    quint32 reserved;
+};
+
+static_assert(sizeof(IndexHeader) == 16, "IndexHeader must be 16 bytes");
+static_assert(sizeof(IndexRecord) == 24, "IndexRecord must be 24 bytes");
+
+} // namespace
+
+// ========================================
+// DiskPageKey
+// ========================================
+DiskPageKey::DiskPageKey(const QString& fp, int page, double zoom, int rot, bool paper)
+    : fingerprint(fp)
+    , pageIndex(page)
+    , zoomBucket(TileCacheKey::zoomBucketFor(zoom))
+    , rotation(rot)
+    , paperEffect(paper)
+{
+}
+
+// ========================================
+// DiskPageCache
+// ========================================
+DiskPageCache& DiskPageCache::instance()
+{
+    static DiskPageCache cache;
+    return cache;
+}
+
+DiskPageCache::DiskPageCache()
+    : m_loaded(false)
+    , m_loadStarted(false)
+    , m_enabled(AppConfig::instance().diskCacheEnabled())
+    , m_indexDirty(false)
+    , m_maxBytes(AppConfig::instance().diskCacheBytes())
+    , m_totalBytes(0)
+    , m_useCounter(0)
+    , m_writesSinceSave(0)
+    , m_hitCount(0)
+    , m_missCount(0)
+    , m_writeCount(0)
+    , m_evictCount(0)
+    , m_loadMs(0)
+{
+    m_directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/render";
+    m_writePool.setMaxThreadCount(1);
+}
+
+DiskPageCache::~DiskPageCache()
+{
+    flush();
+}
+
+QString DiskPageCache::documentFingerprint(MuPDFDocumentCore* core)
+{
+    if (!core || !core->document()) {
+        return QString();
+    }
+
+    QFileInfo info(core->documentPath());
+    if (!info.exists()) {
+        return QString();
+    }
+
+    // PDF 的 /ID 第一项在文档创建时生成，修改后通常保持不变，
+    // 与大小、修改时间组合后足以区分同一文件的不同版本
+    char idBuffer[64];
+    int idLength = 0;
+    fz_var(idLength);
+
+    fz_context* ctx = core->cloneContext();
+    if (ctx) {
+        core->lockDocument();
+        fz_try(ctx) {
+            pdf_document* pdf = pdf_specifics(ctx, core->document());
+            if (pdf) {
+                pdf_obj* id = pdf_dict_get(ctx, pdf_trailer(ctx, pdf), PDF_NAME(ID));
+                pdf_obj* first = pdf_array_get(ctx, id, 0);
+                if (pdf_is_string(ctx, first)) {
+                    idLength = qMin<int>(int(pdf_to_str_len(ctx, first)), int(sizeof(idBuffer)));
+                    memcpy(idBuffer, pdf_to_str_buf(ctx, first), size_t(idLength));
+                }
+            }
+        }
+        fz_always(ctx) {
+            core->unlockDocument();
+        }
+        fz_catch(ctx) {
+            qWarning() << "DiskPageCache: Failed to read document ID:" << fz_caught_message(ctx);
+            idLength = 0;
+        }
+        fz_drop_context(ctx);
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData("|");
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    hash.addData("|");
+    hash.addData(QByteArray(idBuffer, idLength));
+
+    return QString::fromLatin1(hash.result().toHex().left(32));
+}
+
+bool DiskPageCache::isEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+void DiskPageCache::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_enabled = enabled;
+    if (m_enabled) {
+        startLoadLocked();
+    }
+}
+
+void DiskPageCache::setMaxBytes(qint64 maxBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    if (m_loaded) {
+        evictLocked();
+    }
+}
+
+
+QImage DiskPageCache::load(const DiskPageKey& key)
+{
+    if (!key.isValid()) {
+        return QImage();
+    }
+
+    const QString keyString = key.toString();
+    const quint64 hash = keyHash(keyString);
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (!m_enabled) {
+            return QImage();
+        }
+        if (!m_loaded) {
+            // 索引仍在后台加载，按未命中处理
+            startLoadLocked();
+            m_missCount++;
+            return QImage();
+        }
+
+        if (!m_entries.contains(hash)) {
+            m_missCount++;
+            return QImage();
+        }
+    }
+
+    // 读取和解码不持锁
+    QElapsedTimer timer;
+    timer.start();
+
+    QImage image;
+    QFile file(filePath(hash));
+    if (file.open(QIODevice::ReadOnly)) {
+        QByteArray data = file.readAll();
+        QDataStream stream(data);
+
+        quint32 magic = 0;
+        quint32 version = 0;
+        quint32 format = 0;
+        QByteArray storedKey;
+        stream >> magic >> version >> format >> storedKey;
+
+        // 文件头中的完整键用于排除哈希冲突和损坏的文件
+        if (stream.status() == QDataStream::Ok && magic == FILE_MAGIC &&
+            version == FILE_VERSION && storedKey == keyString.toUtf8()) {
+            QByteArray encoded = data.mid(stream.device()->pos());
+            image = QoiCodec::decode(encoded, static_cast<QImage::Format>(format));
+        }
+    }
+
+    double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_entries.find(hash);
+    if (image.isNull()) {
+        qWarning() << "DiskPageCache: Dropping unreadable entry" << keyString;
+        if (it != m_entries.end()) {
+            m_totalBytes -= it->bytes;
+            m_entries.erase(it);
+            m_indexDirty = true;
+        }
+        QFile::remove(filePath(hash));
+        m_missCount++;
+        return QImage();
+    }
+
+    if (it != m_entries.end()) {
+        it->lastUse = ++m_useCounter;
+        m_indexDirty = true;
+    }
+    m_hitCount++;
+    m_loadMs += elapsedMs;
+
+    return image;
+}
+
+void DiskPageCache::store(const DiskPageKey& key, const QImage& image)
+{
+    if (!key.isValid() || image.isNull()) {
+        return;
+    }
+
+    const quint64 hash = keyHash(key.toString());
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (!m_enabled || m_maxBytes <= 0) {
+            return;
+        }
+
+        // 索引未加载完时照常排队：写线程按顺序执行，写入前索引已经就绪
+        startLoadLocked();
+
+        auto it = m_entries.find(hash);
+        if (it != m_entries.end()) {
+            it->lastUse = ++m_useCounter;
+            m_indexDirty = true;
+            return;
+        }
+
+        if (m_pendingWrites.contains(hash)) {
+            return;
+        }
+        m_pendingWrites.insert(hash);
+    }
+
+    m_writePool.start([this, key, image]() {
+        writeFile(key, image);
+    });
+}
+
+void DiskPageCache::flush()
+{
+    m_writePool.waitForDone();
+
+    QMutexLocker locker(&m_mutex);
+    if (m_loaded && m_indexDirty) {
+        saveIndexLocked();
+    }
+}
+
+void DiskPageCache::clear()
+{
+    m_writePool.waitForDone();
+
+    QMutexLocker locker(&m_mutex);
+
+    QDir(m_directory + "/pages").removeRecursively();
+    m_entries.clear();
+    m_totalBytes = 0;
+    m_loaded = true;
+    m_loadStarted = true;
+    saveIndexLocked();
+}
+
+QString DiskPageCache::getStatistics() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    qint64 totalAccess = m_hitCount + m_missCount;
+    double hitRate = (totalAccess > 0) ? (m_hitCount * 100.0 / totalAccess) : 0;
+    double avgLoadMs = (m_hitCount > 0) ? (m_loadMs / m_hitCount) : 0;
+    const double mb = 1024.0 * 1024.0;
+
+    return QString("Disk Cache: %1, %2 pages, %3/%4 MB, Hit Rate: %5%, "
+                   "Hits: %6, Misses: %7, Written: %8, Evicted: %9, Avg load: %10 ms")
+        .arg(m_enabled ? "On" : "Off")
+        .arg(m_entries.size())
+        .arg(m_totalBytes / mb, 0, 'f', 1)
+        .arg(m_maxBytes / mb, 0, 'f', 0)
+        .arg(hitRate, 0, 'f', 1)
+        .arg(m_hitCount)
+        .arg(m_missCount)
+        .arg(m_writeCount)
+        .arg(m_evictCount)
+        .arg(avgLoadMs, 0, 'f', 2);
+}
+
+quint64 DiskPageCache::keyHash(const QString& keyString)
+{
+    // 跨进程稳定的哈希（qHash 带随机种子，不能用于持久化）
+    QByteArray digest = QCryptographicHash::hash(keyString.toUtf8(), QCryptographicHash::Sha1);
+    quint64 hash = 0;
+    memcpy(&hash, digest.constData(), sizeof(hash));
+    return hash;
+}
+
+QString DiskPageCache::filePath(quint64 hash) const
+{
+    QString name = QString("%1").arg(hash, 16, 16, QChar('0'));
+    return QString("%1/pages/%2/%3.qpc").arg(m_directory, name.left(2), name);
+}
+
+void DiskPageCache::startLoadLocked()
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    if (m_loadStarted) {
+        return;
+    }
+    m_loadStarted = true;
+
+    // 写线程只有一个，之后排队的写入都会在索引就绪后执行
+    m_writePool.start([this]() {
+        loadIndex();
+    });
+}
+
+void DiskPageCache::loadIndex()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // 读文件和扫描目录都不持锁
+    QHash<quint64, Entry> entries;
+    bool rebuilt = false;
+    if (!readIndexFile(entries)) {
+        entries.clear();
+        scanDirectory(entries);
+        rebuilt = true;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_loaded) {
+        return;     // 加载期间缓存已被清空
+    }
+
+    m_entries = std::move(entries);
+    m_totalBytes = 0;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        m_totalBytes += it->bytes;
+        m_useCounter = qMax(m_useCounter, it->lastUse);
+    }
+    m_loaded = true;
+    m_indexDirty = m_indexDirty || rebuilt;
+
+    qInfo() << "DiskPageCache: Loaded" << m_entries.size() << "entries,"
+            << m_totalBytes / (1024 * 1024) << "MB in" << timer.elapsed() << "ms"
+            << (rebuilt ? "(rebuilt)" : "");
+
+    evictLocked();
+}
+
+bool DiskPageCache::readIndexFile(QHash<quint64, Entry>& entries) const
+{
+    QFile file(m_directory + "/index.bin");
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(IndexHeader))) {
+        return false;
+    }
+
+    const qint64 size = file.size();
+    QByteArray fallback;
+    const uchar* data = file.map(0, size);
+    if (!data) {
+        fallback = file.readAll();
+        data = reinterpret_cast<const uchar*>(fallback.constData());
+    }
+
+    IndexHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        header.version != INDEX_VERSION ||
+        size != qint64(sizeof(IndexHeader)) + qint64(header.count) * qint64(sizeof(IndexRecord))) {
+        qWarning() << "DiskPageCache: Index is corrupt, rebuilding";
+        return false;
+    }
+
+    const uchar* records = data + sizeof(IndexHeader);
+    entries.reserve(int(header.count));
+
+    for (quint32 i = 0; i < header.count; ++i) {
+        IndexRecord record;
+        memcpy(&record, records + i * sizeof(IndexRecord), sizeof(record));
+
+        Entry entry;
+        entry.bytes = record.bytes;
+        entry.lastUse = record.lastUse;
+        entries.insert(record.hash, entry);
+    }
+
+    return true;
+}
+
+void DiskPageCache::scanDirectory(QHash<quint64, Entry>& entries) const
+{
+    // 没有访问记录时按修改时间排序，保持大致的 LRU 顺序
+    struct FoundFile {
+        quint64 hash;
+        qint64 bytes;
+        qint64 modified;
+    };
+    QVector<FoundFile> found;
+
+    QDirIterator it(m_directory + "/pages", {"*.qpc"}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        QFileInfo info = it.fileInfo();
+
+        bool ok = false;
+        quint64 hash = info.completeBaseName().toULongLong(&ok, 16);
+        if (ok) {
+            found.append({hash, info.size(), info.lastModified().toMSecsSinceEpoch()});
+        }
+    }
+
+    std::sort(found.begin(), found.end(), [](const FoundFile& a, const FoundFile& b) {
+        return a.modified < b.modified;
+    });
+
+    quint64 useCounter = 0;
+    for (const FoundFile& file : found) {
+        Entry entry;
+        entry.bytes = file.bytes;
+        entry.lastUse = ++useCounter;
+        entries.insert(file.hash, entry);
+    }
+}
+
+void DiskPageCache::saveIndexLocked()
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    QDir().mkpath(m_directory);
+
+    QByteArray data;
+    data.resize(qsizetype(sizeof(IndexHeader) + m_entries.size() * sizeof(IndexRecord)));
+
+    IndexHeader header;
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.count = quint32(m_entries.size());
+    header.reserved = 0;
+    memcpy(data.data(), &header, sizeof(header));
+
+    char* records = data.data() + sizeof(IndexHeader);
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        IndexRecord record;
+        record.hash = it.key();
+        record.lastUse = it->lastUse;
+        record.bytes = quint32(it->bytes);
+        record.reserved = 0;
+        memcpy(records, &record, sizeof(record));
+        records += sizeof(record);
+    }
+
+    QSaveFile file(m_directory + "/index.bin");
+    if (file.open(QIODevice::WriteOnly) && file.write(data) == data.size() && file.commit()) {
+        m_indexDirty = false;
+        m_writesSinceSave = 0;
+    } else {
+        qWarning() << "DiskPageCache: Failed to save index:" << file.errorString();
+    }
+}
+
+void DiskPageCache::evictLocked()
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    if (m_totalBytes <= m_maxBytes) {
+        return;
+    }
+
+    // 一次删到容量的 90%，避免每次写入都触发
+    const qint64 target = m_maxBytes - m_maxBytes / 10;
+
+    QVector<QPair<quint64, quint64>> byAge;     // (lastUse, hash)
+    byAge.reserve(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        byAge.append(qMakePair(it->lastUse, it.key()));
+    }
+    std::sort(byAge.begin(), byAge.end());
+
+    for (const auto& item : byAge) {
+        if (m_totalBytes <= target) {
+            break;
+        }
+
+        auto it = m_entries.find(item.second);
+        m_totalBytes -= it->bytes;
+        m_entries.erase(it);
+        QFile::remove(filePath(item.second));
+        m_evictCount++;
+    }
+
+    m_indexDirty = true;
+}
+
+void DiskPageCache::writeFile(const DiskPageKey& key, const QImage& image)
+{
+    const QString keyString = key.toString();
+    const quint64 hash = keyHash(keyString);
+
+    {
+        // 排队时索引可能尚未加载，文件已存在则只更新访问顺序
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(hash);
+        if (it != m_entries.end()) {
+            it->lastUse = ++m_useCounter;
+            m_indexDirty = true;
+            m_pendingWrites.remove(hash);
+            return;
+        }
+    }
+
+    QByteArray encoded = QoiCodec::encode(image);
+
+    QByteArray data;
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream << FILE_MAGIC << FILE_VERSION << quint32(image.format()) << keyString.toUtf8();
+    }
+    data.append(encoded);
+
+    const QString path = filePath(hash);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    bool written = !encoded.isEmpty() && file.open(QIODevice::WriteOnly) &&
+                   file.write(data) == data.size() && file.commit();
+
+    QMutexLocker locker(&m_mutex);
+    m_pendingWrites.remove(hash);
+
+    if (!written) {
+        qWarning() << "DiskPageCache: Failed to write" << keyString << file.errorString();
+        return;
+    }
+
+    auto it = m_entries.find(hash);
+    if (it != m_entries.end()) {
+        m_totalBytes -= it->bytes;
+    }
+
+    Entry entry;
+    entry.bytes = data.size();
+    entry.lastUse = ++m_useCounter;
+    m_entries.insert(hash, entry);
+    m_totalBytes += entry.bytes;
+    m_writeCount++;
+    m_indexDirty = true;
+
+    evictLocked();
+
+    if (++m_writesSinceSave >= WRITES_PER_INDEX_SAVE) {
+        saveIndexLocked();
+    }
+}
@@ -0,0 +1,165 @@
+#ifndef DISKPAGECACHE_H
+#define DISKPAGECACHE_H
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+
+class MuPDFDocumentCore;
+
+/**
+ * @brief 磁盘渲染缓存键
+ *
+ * 文档指纹区分不同文件（及同一文件的不同版本），纸质效果会改变渲染结果，一并计入
+ */
+struct DiskPageKey {
+    QString fingerprint;    ///< 文档指纹（见 DiskPageCache::documentFingerprint）
+    int pageIndex = -1;     ///< 页码
+    int zoomBucket = 0;     ///< 量化后的缩放比例（zoom * 1000）
+    int rotation = 0;       ///< 旋转角度
+    bool paperEffect = false; ///< 是否启用纸质效果
+
+    DiskPageKey() = default;
+    DiskPageKey(const QString& fp, int page, double zoom, int rot, bool paper);
+
+    bool isValid() const { return !fingerprint.isEmpty() && pageIndex >= 0; }
+
+    QString toString() const {
+        return QString("%1/p%2_z%3_r%4_%5")
+            .arg(fingerprint).arg(pageIndex).arg(zoomBucket).arg(rotation).arg(paperEffect ? 1 : 0);
+    }
+};
+
+/**
+ * @brief 跨会话的磁盘渲染缓存（全局单例）
+ *
+ * 最终渲染以 QOI 压缩后写入用户缓存目录，重新打开同一文档时直接读取，
+ * 不必再调用 MuPDF。目录结构：
+ * - pages/xx/<键哈希>.qpc：页面文件，文件头中保存完整键，读取时校验
+ * - index.bin：定长记录的索引（键哈希、大小、访问序号），启动时整体映射读取
+ *
+ * 读取在调用线程同步进行；写入排队到单独的写线程（编码 + 写文件 + 容量淘汰），
+ * 不阻塞渲染线程。索引在写线程中加载（缺失或损坏时从目录重建），加载完成前
+ * 读取一律按未命中处理，不会阻塞调用线程。索引每写入若干个文件及退出前
+ * （flush()）保存。
+ */
+class DiskPageCache
+{
+public:
+    static DiskPageCache& instance();
+
+    /**
+     * @brief 计算文档指纹：文件大小 + 修改时间 + PDF 的 /ID
+     * @return 文档不可用时返回空字符串
+     */
+    static QString documentFingerprint(MuPDFDocumentCore* core);
+
+    /**
+     * @brief 是否启用（由 AppConfig::diskCacheEnabled 控制）
+     *
+     * 启用时在写线程中开始加载索引
+     */
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief 设置容量（字节）
+     */
+    void setMaxBytes(qint64 maxBytes);
+
+    /**
+     * @brief 读取页面（同步）
+     * @return 图像，未缓存、已关闭或文件损坏时返回空QImage
+     */
+    QImage load(const DiskPageKey& key);
+
+    /**
+     * @brief 保存页面（异步写入，已存在时只更新访问顺序）
+     */
+    void store(const DiskPageKey& key, const QImage& image);
+
+    /**
+     * @brief 等待写入完成并保存索引
+     */
+    void flush();
+
+    /**
+     * @brief 删除所有缓存文件
+     */
+    void clear();
+
+    /**
+     * @brief 获取统计信息（调试用）
+     */
+    QString getStatistics() const;
+
+private:
+    DiskPageCache();
+    ~DiskPageCache();
+
+    DiskPageCache(const DiskPageCache&) = delete;
+    DiskPageCache& operator=(const DiskPageCache&) = delete;
+
+    struct Entry {
+        qint64 bytes = 0;       ///< 文件大小
+        quint64 lastUse = 0;    ///< 访问序号（跨会话递增）
+    };
+
+    static quint64 keyHash(const QString& keyString);
+    QString filePath(quint64 hash) const;
+
+    /**
+     * @brief 尚未开始时把索引加载排入写线程（调用前必须已持有锁）
+     */
+    void startLoadLocked();
+
+    /**
+     * @brief 在写线程中读取或重建索引，完成后一次性合并
+     */
+    void loadIndex();
+    bool readIndexFile(QHash<quint64, Entry>& entries) const;
+    void scanDirectory(QHash<quint64, Entry>& entries) const;
+
+    /**
+     * @brief 保存索引（调用前必须已持有锁）
+     */
+    void saveIndexLocked();
+
+    /**
+     * @brief 删除最久未访问的文件直到低于容量的 90%（调用前必须已持有锁）
+     */
+    void evictLocked();
+
+    /**
+     * @brief 在写线程中编码并写入文件
+     */
+    void writeFile(const DiskPageKey& key, const QImage& image);
+
+private:
+    QString m_directory;
+    QThreadPool m_writePool;
+
+    mutable QMutex m_mutex;
+    QHash<quint64, Entry> m_entries;    ///< 键哈希 -> 文件信息
+    QSet<quint64> m_pendingWrites;      ///< 已排队尚未写完的键
+    bool m_loaded;
+    bool m_loadStarted;
+    bool m_enabled;
+    bool m_indexDirty;
+    qint64 m_maxBytes;
+    qint64 m_totalBytes;
+    quint64 m_useCounter;
+    int m_writesSinceSave;
+
+    // 统计信息
+    qint64 m_hitCount;
+    qint64 m_missCount;
+    qint64 m_writeCount;
+    qint64 m_evictCount;
+    double m_loadMs;
+};
+
+#endif // DISKPAGECACHE_H
@@ -1,306 +1,962 @@
 #include "pagecachemanager.h"
+#include "compressedpagecache.h"
+#include "appconfig.h"
 #include <QMutexLocker>
 #include <QDebug>
+#include <QMap>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+// ========================================
+// PageCacheManager::Shard - 访问顺序链表
+// ========================================
+void PageCacheManager::Shard::unlink(CacheNode* node)
+{
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        head = node->next;
+    }
+
+    if (node->next) {
+        node->next->prev = node->prev;
+    } else {
+        tail = node->prev;
+    }
+
+    node->prev = nullptr;
+    node->next = nullptr;
+}
+
+void PageCacheManager::Shard::pushFront(CacheNode* node)
+{
+    node->prev = nullptr;
+    node->next = head;
+
+    if (head) {
+        head->prev = node;
+    }
+    head = node;
+
+    if (!tail) {
+        tail = node;
+    }
+}
+
+void PageCacheManager::Shard::touch(CacheNode* node)
+{
+    if (head != node) {
+        unlink(node);
+        pushFront(node);
+    }
+}
 
-PageCacheManager::PageCacheManager(int maxSize, CacheStrategy strategy)
-    : m_maxSize(maxSize)
+// ========================================
+// PageCacheManager
+// ========================================
+PageCacheManager::PageCacheManager(qint64 highWatermark, qint64 lowWatermark,
+                                   CacheStrategy strategy)
+    : m_highWatermark(qMax<qint64>(1, highWatermark))
+    , m_lowWatermark(qBound<qint64>(0, lowWatermark, qMax<qint64>(1, highWatermark)))
+    , m_totalBytes(0)
+    , m_useCounter(0)
     , m_strategy(strategy)
     , m_currentKey(-1, 1.0, 0)
-    , m_timeCounter(0)
+    , m_maxTiles(AppConfig::MAX_TILE_CACHE_COUNT)
+    , m_tileHitCount(0)
+    , m_tileMissCount(0)
+    , m_compressedTier(std::make_unique<CompressedPageCache>(0))
     , m_hitCount(0)
     , m_missCount(0)
+    , m_restoredCount(0)
+    , m_evictedBytes(0)
+    , m_contendedLocks(0)
 {
+    m_compressPool.setMaxThreadCount(1);
 }
 
-bool PageCacheManager::addPage(int pageIndex, double zoom, int rotation, const QImage& image)
+PageCacheManager::~PageCacheManager()
+{
+    m_compressPool.clear();
+    m_compressPool.waitForDone();
+    clear();
+}
+
+PageCacheKey PageCacheManager::normalizedKey(int pageIndex, double zoom, int rotation)
+{
+    return PageCacheKey(pageIndex, TileCacheKey::zoomBucketFor(zoom) / 1000.0, rotation);
+}
+
+PageCacheManager::Shard& PageCacheManager::shardFor(int pageIndex) const
+{
+    return m_shards[static_cast<unsigned>(pageIndex) & (SHARD_COUNT - 1)];
+}
+
+void PageCacheManager::lockShard(const Shard& shard) const
+{
+    if (!shard.mutex.tryLock()) {
+        m_contendedLocks++;
+        shard.mutex.lock();
+    }
+}
+
+bool PageCacheManager::addPage(int pageIndex, double zoom, int rotation, const QImage& image,
+                               PageQuality quality)
 {
     if (image.isNull()) {
         return false;
     }
 
-    QMutexLocker locker(&m_mutex);
+    PageCacheKey key = normalizedKey(pageIndex, zoom, rotation);
+    Shard& shard = shardFor(pageIndex);
 
-    PageCacheKey key(pageIndex, zoom, rotation);
+    {
+        lockShard(shard);
+        std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
 
-    // 如果已存在，更新
-    if (m_cache.contains(key)) {
-        m_cache[key] = image;
-        updateAccessTime(key);
-        return true;
-    }
+        CacheNode* node = shard.index.value(key, nullptr);
+        if (node) {
+            // 已存在则更新（草稿不能覆盖最终渲染）
+            if (quality == PageQuality::Draft && node->quality == PageQuality::Final) {
+                return false;
+            }
+            qint64 bytes = image.sizeInBytes();
+            m_totalBytes += bytes - node->bytes;
+            node->image = image;
+            node->quality = quality;
+            node->bytes = bytes;
+        } else {
+            node = new CacheNode;
+            node->key = key;
+            node->image = image;
+            node->quality = quality;
+            node->bytes = image.sizeInBytes();
+            shard.index.insert(key, node);
+            shard.pageNodes[pageIndex].append(node);
+            shard.pushFront(node);
+            m_totalBytes += node->bytes;
+        }
 
-    // 如果缓存已满，执行淘汰
-    if (m_cache.size() >= m_maxSize) {
-        evict();
+        node->lastUse = ++m_useCounter;
+        shard.touch(node);
     }
 
-    // 添加新页面
-    m_cache.insert(key, image);
-    updateAccessTime(key);
+    // 超过高水位后淘汰到低水位（不持有分片锁）
+    enforceBudget(key);
 
     return true;
 }
 
 QImage PageCacheManager::getPage(int pageIndex, double zoom, int rotation)
 {
-    QMutexLocker locker(&m_mutex);
-
-    PageCacheKey key(pageIndex, zoom, rotation);
+    QImage image = getResidentPage(pageIndex, zoom, rotation);
+    if (!image.isNull()) {
+        return image;
+    }
 
-    if (!m_cache.contains(key)) {
+    // 内存中没有：从压缩层解压（不持分片锁），放回内存缓存
+    QImage restored = restoreCompressedPage(pageIndex, zoom, rotation);
+    if (restored.isNull()) {
         m_missCount++;
         return QImage();
     }
 
-    // 更新访问时间
-    updateAccessTime(key);
+    addPage(pageIndex, zoom, rotation, restored);
+    return restored;
+}
+
+QImage PageCacheManager::getResidentPage(int pageIndex, double zoom, int rotation)
+{
+    PageCacheKey key = normalizedKey(pageIndex, zoom, rotation);
+    Shard& shard = shardFor(pageIndex);
+
+    lockShard(shard);
+    std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+    CacheNode* node = shard.index.value(key, nullptr);
+    if (!node || node->quality != PageQuality::Final) {
+        return QImage();
+    }
+
+    // 更新访问顺序
+    node->lastUse = ++m_useCounter;
+    shard.touch(node);
     m_hitCount++;
 
-    return m_cache.value(key);
+    return node->image;
+}
+
+QImage PageCacheManager::restoreCompressedPage(int pageIndex, double zoom, int rotation)
+{
+    QImage restored = m_compressedTier->find(normalizedKey(pageIndex, zoom, rotation));
+    if (!restored.isNull()) {
+        m_hitCount++;
+        m_restoredCount++;
+    }
+    return restored;
+}
+
+QImage PageCacheManager::getPageOrDraft(int pageIndex, double zoom, int rotation, bool* isDraft)
+{
+    PageCacheKey key = normalizedKey(pageIndex, zoom, rotation);
+    Shard& shard = shardFor(pageIndex);
+
+    lockShard(shard);
+    std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+    CacheNode* node = shard.index.value(key, nullptr);
+    if (!node) {
+        if (isDraft) *isDraft = false;
+        return QImage();
+    }
+
+    node->lastUse = ++m_useCounter;
+    shard.touch(node);
+
+    if (isDraft) *isDraft = (node->quality == PageQuality::Draft);
+    return node->image;
+}
+
+QImage PageCacheManager::getNearestZoomPage(int pageIndex, double zoom, int rotation,
+                                            double* scale) const
+{
+    if (scale) *scale = 1.0;
+    if (zoom <= 0) {
+        return QImage();
+    }
+
+    const Shard& shard = shardFor(pageIndex);
+
+    lockShard(shard);
+    std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+    const CacheNode* best = nullptr;
+    double bestDistance = 0;
+
+    for (const CacheNode* node : shard.pageNodes.value(pageIndex)) {
+        if (node->quality != PageQuality::Final || node->key.rotation != rotation ||
+            node->key.zoom <= 0) {
+            continue;
+        }
+
+        double distance = qAbs(std::log(zoom / node->key.zoom));
+        bool closer = !best || distance < bestDistance - 1e-9 ||
+                      (qAbs(distance - bestDistance) <= 1e-9 && node->key.zoom > best->key.zoom);
+        if (closer) {
+            best = node;
+            bestDistance = distance;
+        }
+    }
+
+    if (!best) {
+        return QImage();
+    }
+
+    if (scale) *scale = zoom / best->key.zoom;
+    return best->image;
 }
 
 bool PageCacheManager::contains(int pageIndex, double zoom, int rotation) const
 {
-    QMutexLocker locker(&m_mutex);
-    PageCacheKey key(pageIndex, zoom, rotation);
-    return m_cache.contains(key);
+    const Shard& shard = shardFor(pageIndex);
+    PageCacheKey key = normalizedKey(pageIndex, zoom, rotation);
+
+    {
+        lockShard(shard);
+        std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+        CacheNode* node = shard.index.value(key, nullptr);
+        if (node && node->quality == PageQuality::Final) {
+            return true;
+        }
+    }
+
+    return m_compressedTier->contains(key);
+}
+
+bool PageCacheManager::containsAnyQuality(int pageIndex, double zoom, int rotation) const
+{
+    const Shard& shard = shardFor(pageIndex);
+
+    PageCacheKey key = normalizedKey(pageIndex, zoom, rotation);
+
+    {
+        lockShard(shard);
+        std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+        if (shard.index.contains(key)) {
+            return true;
+        }
+    }
+
+    return m_compressedTier->contains(key);
+}
+
+bool PageCacheManager::isResident(int pageIndex, double zoom, int rotation) const
+{
+    const Shard& shard = shardFor(pageIndex);
+    PageCacheKey key = normalizedKey(pageIndex, zoom, rotation);
+
+    lockShard(shard);
+    std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+    CacheNode* node = shard.index.value(key, nullptr);
+    return node && node->quality == PageQuality::Final;
+}
+
+QSize PageCacheManager::residentPageSize(int pageIndex, double zoom, int rotation) const
+{
+    const Shard& shard = shardFor(pageIndex);
+    PageCacheKey key = normalizedKey(pageIndex, zoom, rotation);
+
+    lockShard(shard);
+    std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+    CacheNode* node = shard.index.value(key, nullptr);
+    if (!node || node->quality != PageQuality::Final) {
+        return QSize();
+    }
+    return node->image.size();
 }
 
 void PageCacheManager::removePage(int pageIndex, double zoom, int rotation)
 {
-    QMutexLocker locker(&m_mutex);
-    PageCacheKey key(pageIndex, zoom, rotation);
-    m_cache.remove(key);
-    m_accessTime.remove(key);
+    Shard& shard = shardFor(pageIndex);
+
+    PageCacheKey key = normalizedKey(pageIndex, zoom, rotation);
+
+    {
+        lockShard(shard);
+        std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+        CacheNode* node = shard.index.value(key, nullptr);
+        if (node) {
+            removeNodeLocked(shard, node);
+        }
+    }
+
+    m_compressedTier->remove(key);
 }
 
 void PageCacheManager::clear()
 {
-    QMutexLocker locker(&m_mutex);
-    m_cache.clear();
-    m_accessTime.clear();
-    m_visiblePages.clear();
-    m_timeCounter = 0;
+    QMutexLocker evictLocker(&m_evictMutex);
+
+    for (Shard& shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+
+        for (CacheNode* node : std::as_const(shard.index)) {
+            m_totalBytes -= node->bytes;
+            delete node;
+        }
+        shard.index.clear();
+        shard.pageNodes.clear();
+        shard.head = nullptr;
+        shard.tail = nullptr;
+    }
+
+    {
+        QMutexLocker locker(&m_tileMutex);
+        for (const QImage& tile : std::as_const(m_tiles)) {
+            m_totalBytes -= tile.sizeInBytes();
+        }
+        m_tiles.clear();
+        m_tileAccessTime.clear();
+        m_tileHitCount = 0;
+        m_tileMissCount = 0;
+    }
+
+    {
+        QMutexLocker locker(&m_stateMutex);
+        m_visiblePages.clear();
+    }
+
+    // 推进压缩层代数，尚未完成的压缩任务结果会被丢弃
+    m_compressedTier->clear();
+
     m_hitCount = 0;
     m_missCount = 0;
+    m_restoredCount = 0;
 }
 
 void PageCacheManager::clearByZoomRotation(double zoom, int rotation)
 {
-    QMutexLocker locker(&m_mutex);
+    const double normalizedZoom = TileCacheKey::zoomBucketFor(zoom) / 1000.0;
+
+    for (Shard& shard : m_shards) {
+        lockShard(shard);
+        std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+        QList<CacheNode*> nodesToRemove;
+
+        for (CacheNode* node : std::as_const(shard.index)) {
+            const PageCacheKey& key = node->key;
+
+            bool shouldRemove = false;
+
+            if (zoom >= 0 && rotation >= 0) {
+                // 同时匹配缩放和旋转
+                shouldRemove = (qAbs(key.zoom - normalizedZoom) < 0.001 && key.rotation == rotation);
+            } else if (zoom >= 0) {
+                // 只匹配缩放
+                shouldRemove = (qAbs(key.zoom - normalizedZoom) < 0.001);
+            } else if (rotation >= 0) {
+                // 只匹配旋转
+                shouldRemove = (key.rotation == rotation);
+            } else {
+                // 清空所有
+                shouldRemove = true;
+            }
+
+            if (shouldRemove) {
+                nodesToRemove.append(node);
+            }
+        }
 
-    QList<PageCacheKey> keysToRemove;
+        for (CacheNode* node : nodesToRemove) {
+            removeNodeLocked(shard, node);
+        }
+    }
 
-    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
-        const PageCacheKey& key = it.key();
+    m_compressedTier->removeByZoomRotation(zoom, rotation);
 
-        bool shouldRemove = false;
+    QMutexLocker locker(&m_tileMutex);
 
-        if (zoom >= 0 && rotation >= 0) {
-            // 同时匹配缩放和旋转
-            shouldRemove = (qAbs(key.zoom - zoom) < 0.001 && key.rotation == rotation);
-        } else if (zoom >= 0) {
-            // 只匹配缩放
-            shouldRemove = (qAbs(key.zoom - zoom) < 0.001);
-        } else if (rotation >= 0) {
-            // 只匹配旋转
-            shouldRemove = (key.rotation == rotation);
-        } else {
-            // 清空所有
-            shouldRemove = true;
-        }
+    QList<TileCacheKey> tilesToRemove;
+    const int zoomBucket = TileCacheKey::zoomBucketFor(zoom);
 
-        if (shouldRemove) {
-            keysToRemove.append(key);
+    for (auto it = m_tiles.constBegin(); it != m_tiles.constEnd(); ++it) {
+        const TileCacheKey& key = it.key();
+        bool zoomMatch = zoom < 0 || key.zoomBucket == zoomBucket;
+        bool rotationMatch = rotation < 0 || key.rotation == rotation;
+        if (zoomMatch && rotationMatch) {
+            tilesToRemove.append(key);
         }
     }
 
-    for (const PageCacheKey& key : keysToRemove) {
-        m_cache.remove(key);
-        m_accessTime.remove(key);
+    for (const TileCacheKey& key : tilesToRemove) {
+        removeTileLocked(key);
     }
 }
 
-void PageCacheManager::setMaxSize(int maxSize)
+void PageCacheManager::setMemoryBudget(qint64 highWatermark, qint64 lowWatermark)
 {
-    QMutexLocker locker(&m_mutex);
+    qint64 high = qMax<qint64>(1, highWatermark);
+    m_highWatermark = high;
+    m_lowWatermark = qBound<qint64>(0, lowWatermark, high);
 
-    if (maxSize < 1) {
-        maxSize = 1;
-    }
+    // 预算缩小后立即淘汰
+    enforceBudget();
+}
 
-    m_maxSize = maxSize;
+qint64 PageCacheManager::highWatermark() const
+{
+    return m_highWatermark.load();
+}
 
-    // 如果新大小小于当前缓存，执行淘汰
-    while (m_cache.size() > m_maxSize) {
-        evict();
-    }
+qint64 PageCacheManager::lowWatermark() const
+{
+    return m_lowWatermark.load();
+}
+
+void PageCacheManager::setCompressedBudget(qint64 maxBytes)
+{
+    m_compressedTier->setMaxBytes(maxBytes);
+}
+
+qint64 PageCacheManager::compressedMemoryUsage() const
+{
+    return m_compressedTier->totalBytes();
 }
 
 void PageCacheManager::setStrategy(CacheStrategy strategy)
 {
-    QMutexLocker locker(&m_mutex);
+    QMutexLocker locker(&m_stateMutex);
     m_strategy = strategy;
 }
 
+PageCacheManager::CacheStrategy PageCacheManager::strategy() const
+{
+    QMutexLocker locker(&m_stateMutex);
+    return m_strategy;
+}
+
 int PageCacheManager::cacheSize() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_cache.size();
+    int size = 0;
+
+    for (const Shard& shard : m_shards) {
+        lockShard(shard);
+        std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+        size += shard.index.size();
+    }
+
+    return size;
 }
 
 QList<PageCacheKey> PageCacheManager::cachedKeys() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_cache.keys();
+    QList<PageCacheKey> keys;
+
+    for (const Shard& shard : m_shards) {
+        lockShard(shard);
+        std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+        keys.append(shard.index.keys());
+    }
+
+    return keys;
 }
 
 void PageCacheManager::setCurrentPage(int pageIndex, double zoom, int rotation)
 {
-    QMutexLocker locker(&m_mutex);
-    m_currentKey = PageCacheKey(pageIndex, zoom, rotation);
+    QMutexLocker locker(&m_stateMutex);
+    m_currentKey = normalizedKey(pageIndex, zoom, rotation);
 }
 
-qint64 PageCacheManager::memoryUsage() const
+PageCacheKey PageCacheManager::currentKeySnapshot() const
 {
-    QMutexLocker locker(&m_mutex);
-
-    qint64 totalBytes = 0;
-
-    for (const QImage& image : m_cache) {
-        totalBytes += image.sizeInBytes();
-    }
+    QMutexLocker locker(&m_stateMutex);
+    return m_currentKey;
+}
 
-    return totalBytes;
+qint64 PageCacheManager::memoryUsage() const
+{
+    return m_totalBytes.load();
 }
 
 void PageCacheManager::markVisiblePages(const QSet<int>& visiblePages)
 {
-    QMutexLocker locker(&m_mutex);
+    QMutexLocker locker(&m_stateMutex);
     m_visiblePages = visiblePages;
 }
 
 QString PageCacheManager::getStatistics() const
 {
-    QMutexLocker locker(&m_mutex);
+    // 按缩放比例统计实际占用
+    struct ZoomUsage {
+        int pages = 0;
+        int tiles = 0;
+        qint64 bytes = 0;
+    };
+    QMap<int, ZoomUsage> byZoom;
+    int pageCount = 0;
+    int tileCount = 0;
+    int maxTiles = 0;
+    qint64 tileHits = 0;
+    qint64 tileMisses = 0;
+
+    for (const Shard& shard : m_shards) {
+        lockShard(shard);
+        std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+        for (const CacheNode* node : shard.index) {
+            ZoomUsage& usage = byZoom[TileCacheKey::zoomBucketFor(node->key.zoom)];
+            usage.pages++;
+            usage.bytes += node->bytes;
+        }
+        pageCount += shard.index.size();
+    }
+
+    {
+        QMutexLocker locker(&m_tileMutex);
 
-    qint64 totalAccess = m_hitCount + m_missCount;
-    double hitRate = (totalAccess > 0) ? (m_hitCount * 100.0 / totalAccess) : 0;
+        for (auto it = m_tiles.constBegin(); it != m_tiles.constEnd(); ++it) {
+            ZoomUsage& usage = byZoom[it.key().zoomBucket];
+            usage.tiles++;
+            usage.bytes += it.value().sizeInBytes();
+        }
+        tileCount = m_tiles.size();
+        maxTiles = m_maxTiles;
+        tileHits = m_tileHitCount;
+        tileMisses = m_tileMissCount;
+    }
 
-    return QString("Cache: %1/%2 pages, Memory: %3 MB, Hit Rate: %4%, Hits: %5, Misses: %6")
-        .arg(m_cache.size())
-        .arg(m_maxSize)
-        .arg(memoryUsage() / 1024.0 / 1024.0, 0, 'f', 2)
+    qint64 hits = m_hitCount.load();
+    qint64 misses = m_missCount.load();
+    qint64 totalAccess = hits + misses;
+    double hitRate = (totalAccess > 0) ? (hits * 100.0 / totalAccess) : 0;
+    const double mb = 1024.0 * 1024.0;
+
+    QString stats = QString("Cache: %1 pages, %2/%3 tiles, Memory: %4 MB "
+                            "(low %5 / high %6 MB), Evicted: %7 MB, "
+                            "Hit Rate: %8%, Hits: %9, Misses: %10, Contended locks: %11")
+        .arg(pageCount)
+        .arg(tileCount)
+        .arg(maxTiles)
+        .arg(m_totalBytes.load() / mb, 0, 'f', 2)
+        .arg(m_lowWatermark.load() / mb, 0, 'f', 0)
+        .arg(m_highWatermark.load() / mb, 0, 'f', 0)
+        .arg(m_evictedBytes.load() / mb, 0, 'f', 1)
         .arg(hitRate, 0, 'f', 1)
-        .arg(m_hitCount)
-        .arg(m_missCount);
+        .arg(hits)
+        .arg(misses)
+        .arg(m_contendedLocks.load());
+
+    for (auto it = byZoom.constBegin(); it != byZoom.constEnd(); ++it) {
+        stats += QString("\n  Zoom %1: %2 pages, %3 tiles, %4 bytes (%5 MB)")
+            .arg(it.key() / 1000.0, 0, 'f', 2)
+            .arg(it->pages)
+            .arg(it->tiles)
+            .arg(it->bytes)
+            .arg(it->bytes / mb, 0, 'f', 2);
+    }
+
+    qint64 tileAccess = tileHits + tileMisses;
+    stats += QString("\nTiles: Hit Rate: %1%, Hits: %2, Misses: %3")
+        .arg(tileAccess > 0 ? tileHits * 100.0 / tileAccess : 0.0, 0, 'f', 1)
+        .arg(tileHits)
+        .arg(tileMisses);
+
+    stats += QString("\n%1, Restored: %2")
+        .arg(m_compressedTier->getStatistics())
+        .arg(m_restoredCount.load());
+
+    return stats;
+}
+
+bool PageCacheManager::addTile(const TileCacheKey& key, const QImage& tile)
+{
+    if (tile.isNull()) {
+        return false;
+    }
+
+    PageCacheKey currentKey = currentKeySnapshot();
+
+    {
+        QMutexLocker locker(&m_tileMutex);
+
+        auto it = m_tiles.find(key);
+        if (it != m_tiles.end()) {
+            m_totalBytes += tile.sizeInBytes() - it.value().sizeInBytes();
+            it.value() = tile;
+        } else {
+            while (m_tiles.size() >= m_maxTiles) {
+                evictTileLocked(currentKey);
+            }
+            m_tiles.insert(key, tile);
+            m_totalBytes += tile.sizeInBytes();
+        }
+
+        m_tileAccessTime[key] = ++m_useCounter;
+    }
+
+    enforceBudget();
+    return true;
+}
+
+QImage PageCacheManager::getTile(const TileCacheKey& key)
+{
+    QMutexLocker locker(&m_tileMutex);
+
+    // 瓦片单独统计，不影响页面缓存的命中率
+    auto it = m_tiles.constFind(key);
+    if (it == m_tiles.constEnd()) {
+        m_tileMissCount++;
+        return QImage();
+    }
+
+    m_tileAccessTime[key] = ++m_useCounter;
+    m_tileHitCount++;
+    return it.value();
+}
+
+bool PageCacheManager::containsTile(const TileCacheKey& key) const
+{
+    QMutexLocker locker(&m_tileMutex);
+    return m_tiles.contains(key);
 }
 
-void PageCacheManager::evict()
+void PageCacheManager::setMaxTiles(int maxTiles)
 {
-    // 注意：调用此方法前必须已经获取互斥锁
+    PageCacheKey currentKey = currentKeySnapshot();
 
-    if (m_cache.isEmpty()) {
+    QMutexLocker locker(&m_tileMutex);
+
+    m_maxTiles = qMax(1, maxTiles);
+
+    while (m_tiles.size() > m_maxTiles) {
+        evictTileLocked(currentKey);
+    }
+}
+
+int PageCacheManager::tileCount() const
+{
+    QMutexLocker locker(&m_tileMutex);
+    return m_tiles.size();
+}
+
+void PageCacheManager::evictTileLocked(const PageCacheKey& currentKey)
+{
+    // 注意：调用此方法前必须已经获取瓦片锁
+
+    if (m_tiles.isEmpty()) {
         return;
     }
 
-    PageCacheKey keyToRemove = selectKeyToEvict();
+    // 优先淘汰其他缩放/旋转下的瓦片，其次是最久未访问的
+    // （瓦片数受视口限制，线性扫描的代价可以忽略）
+    const int currentBucket = TileCacheKey::zoomBucketFor(currentKey.zoom);
+    TileCacheKey selectedKey;
+    bool selectedStale = false;
+    quint64 oldestTime = std::numeric_limits<quint64>::max();
+
+    for (auto it = m_tileAccessTime.constBegin(); it != m_tileAccessTime.constEnd(); ++it) {
+        const TileCacheKey& key = it.key();
+        bool stale = key.zoomBucket != currentBucket || key.rotation != currentKey.rotation;
+
+        if ((stale && !selectedStale) ||
+            (stale == selectedStale && it.value() < oldestTime)) {
+            selectedKey = key;
+            selectedStale = stale;
+            oldestTime = it.value();
+        }
+    }
+
+    auto it = m_tiles.constFind(selectedKey);
+    if (it != m_tiles.constEnd()) {
+        m_evictedBytes += it.value().sizeInBytes();
+    }
+    removeTileLocked(selectedKey);
+}
+
+void PageCacheManager::removeTileLocked(const TileCacheKey& key)
+{
+    // 注意：调用此方法前必须已经获取瓦片锁
+
+    auto it = m_tiles.find(key);
+    if (it == m_tiles.end()) {
+        return;
+    }
 
-    m_cache.remove(keyToRemove);
-    m_accessTime.remove(keyToRemove);
+    m_totalBytes -= it.value().sizeInBytes();
+    m_tiles.erase(it);
+    m_tileAccessTime.remove(key);
 }
 
-PageCacheKey PageCacheManager::selectKeyToEvict()
+void PageCacheManager::enforceBudget(const PageCacheKey& keepKey)
 {
-    // 注意：调用此方法前必须已经获取互斥锁
+    // 注意：调用此方法时不能持有分片锁或瓦片锁
 
-    QList<PageCacheKey> cachedKeys = m_cache.keys();
+    if (m_totalBytes.load() <= m_highWatermark.load()) {
+        return;
+    }
 
-    if (cachedKeys.isEmpty()) {
-        return PageCacheKey();
+    // 已有线程在淘汰时直接返回，由它负责淘汰到低水位
+    if (!m_evictMutex.tryLock()) {
+        return;
     }
+    std::unique_lock<QMutex> evictLocker(m_evictMutex, std::adopt_lock);
 
-    PageCacheKey selectedKey = cachedKeys.first();
+    // 一次淘汰到低水位，之后的插入在回到高水位前不再触发淘汰
+    evictDownTo(m_lowWatermark.load(), evictionContextSnapshot(keepKey));
+}
 
-    switch (m_strategy) {
-    case CacheStrategy::LRU: {
-        // 选择访问时间最早的页面
-        qint64 oldestTime = m_accessTime.value(selectedKey, 0);
+void PageCacheManager::evictDownTo(qint64 target, const EvictionContext& context)
+{
+    // 注意：调用此方法前必须已经获取淘汰锁
 
-        for (const PageCacheKey& key : cachedKeys) {
-            qint64 accessTime = m_accessTime.value(key, 0);
-            if (accessTime < oldestTime) {
-                oldestTime = accessTime;
-                selectedKey = key;
-            }
+    while (m_totalBytes.load() > target) {
+        if (evictPage(context)) {
+            continue;
         }
-        break;
+
+        QMutexLocker locker(&m_tileMutex);
+        if (m_tiles.isEmpty()) {
+            break;
+        }
+        evictTileLocked(context.currentKey);
     }
+}
 
-    case CacheStrategy::MRU: {
-        // 选择访问时间最近的页面（不常用）
-        qint64 newestTime = m_accessTime.value(selectedKey, 0);
+PageCacheManager::EvictionContext PageCacheManager::evictionContextSnapshot(
+    const PageCacheKey& keepKey) const
+{
+    EvictionContext context;
+    context.keepKey = keepKey;
+
+    QMutexLocker locker(&m_stateMutex);
+    context.currentKey = m_currentKey;
+    context.visiblePages = m_visiblePages;
+    context.strategy = m_strategy;
+    return context;
+}
 
-        for (const PageCacheKey& key : cachedKeys) {
-            qint64 accessTime = m_accessTime.value(key, 0);
-            if (accessTime > newestTime) {
-                newestTime = accessTime;
-                selectedKey = key;
-            }
+qint64 PageCacheManager::releaseMemory(qint64 bytes, bool includeVisible)
+{
+    if (bytes <= 0) {
+        return 0;
+    }
+
+    const qint64 before = m_totalBytes.load() + m_compressedTier->totalBytes();
+
+    {
+        QMutexLocker evictLocker(&m_evictMutex);
+
+        EvictionContext context = evictionContextSnapshot(PageCacheKey());
+        if (includeVisible) {
+            context.visiblePages.clear();
         }
-        break;
+        evictDownTo(qMax<qint64>(0, m_totalBytes.load() - bytes), context);
     }
 
-    case CacheStrategy::NearCurrent: {
-        // 优先保留当前页附近的页面
+    // 被淘汰页面的压缩在后台进行，这里只按已释放的原始字节判断是否还需要动压缩层
+    qint64 freed = before - m_totalBytes.load() - m_compressedTier->totalBytes();
+    if (freed < bytes) {
+        freed += m_compressedTier->release(bytes - freed);
+    }
 
-        // 首先，不淘汰可见页面且缩放/旋转匹配的
-        QList<PageCacheKey> evictCandidates;
+    return qMax<qint64>(0, freed);
+}
 
-        for (const PageCacheKey& key : cachedKeys) {
-            // 如果不是可见页面，或者缩放/旋转不匹配，加入候选
-            bool isVisibleAndMatch = m_visiblePages.contains(key.pageIndex) &&
-                                     qAbs(key.zoom - m_currentKey.zoom) < 0.001 &&
-                                     key.rotation == m_currentKey.rotation;
+bool PageCacheManager::evictPage(const EvictionContext& context)
+{
+    if (evictPageWithDepth(context, EVICT_PROBE_DEPTH)) {
+        return true;
+    }
 
-            if (!isVisibleAndMatch) {
-                evictCandidates.append(key);
-            }
+    if (context.strategy != CacheStrategy::NearCurrent) {
+        return false;
+    }
+
+    // 链表尾部全是可见页面：先扫描整个分片找不可见的页面，
+    // 仍然没有时退回普通 LRU，保证能降到预算以内
+    if (evictPageWithDepth(context, std::numeric_limits<int>::max())) {
+        return true;
+    }
+
+    EvictionContext plain = context;
+    plain.strategy = CacheStrategy::LRU;
+    return evictPageWithDepth(plain, EVICT_PROBE_DEPTH);
+}
+
+bool PageCacheManager::evictPageWithDepth(const EvictionContext& context, int probeDepth)
+{
+    const CacheStrategy strategy = context.strategy;
+    const bool preferNewest = (strategy == CacheStrategy::MRU);
+
+    // 第一轮：每个分片只看链表一端的 probeDepth 个节点，选出全局最合适的分片
+    int selectedShard = -1;
+    bool selectedStale = false;
+    quint64 selectedUse = 0;
+
+    for (int i = 0; i < SHARD_COUNT; ++i) {
+        Shard& shard = m_shards[i];
+        lockShard(shard);
+        std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
+
+        CacheNode* candidate = selectCandidateLocked(shard, context, probeDepth);
+        if (!candidate) {
+            continue;
         }
 
-        // 如果有候选项，从中选择
-        if (!evictCandidates.isEmpty()) {
-            cachedKeys = evictCandidates;
-            selectedKey = cachedKeys.first();
+        bool stale = strategy == CacheStrategy::NearCurrent &&
+                     (qAbs(candidate->key.zoom - context.currentKey.zoom) >= 0.001 ||
+                      candidate->key.rotation != context.currentKey.rotation);
+
+        bool better = selectedShard < 0 ||
+                      (stale && !selectedStale) ||
+                      (stale == selectedStale &&
+                       (preferNewest ? candidate->lastUse > selectedUse
+                                     : candidate->lastUse < selectedUse));
+        if (better) {
+            selectedShard = i;
+            selectedStale = stale;
+            selectedUse = candidate->lastUse;
         }
+    }
 
-        // 选择距离当前页最远，且缩放/旋转差异最大的
-        double maxScore = 0;
+    if (selectedShard < 0) {
+        return false;
+    }
 
-        for (const PageCacheKey& key : cachedKeys) {
-            // 计算综合距离分数
-            int pageDistance = qAbs(key.pageIndex - m_currentKey.pageIndex);
-            double zoomDistance = qAbs(key.zoom - m_currentKey.zoom);
-            int rotationDistance = (key.rotation != m_currentKey.rotation) ? 1 : 0;
+    // 第二轮：重新加锁后再选一次（期间可能有其他线程访问过）
+    Shard& shard = m_shards[selectedShard];
+    lockShard(shard);
+    std::unique_lock<QMutex> locker(shard.mutex, std::adopt_lock);
 
-            // 综合分数：页面距离权重最高，然后是缩放差异
-            double score = pageDistance * 100.0 + zoomDistance * 50.0 + rotationDistance * 25.0;
+    CacheNode* victim = selectCandidateLocked(shard, context, probeDepth);
+    if (!victim) {
+        // 两轮之间该分片已变化，下一次循环重新选择（第一轮不会再选中它）
+        return true;
+    }
 
-            if (score > maxScore) {
-                maxScore = score;
-                selectedKey = key;
-            }
-        }
-        break;
+    m_evictedBytes += victim->bytes;
+
+    // 最终渲染交给压缩层（图像隐式共享，编码在压缩线程进行）
+    if (victim->quality == PageQuality::Final) {
+        compressEvicted(victim->key, victim->image);
     }
+
+    removeNodeLocked(shard, victim);
+    return true;
+}
+
+void PageCacheManager::compressEvicted(const PageCacheKey& key, const QImage& image)
+{
+    if (m_compressedTier->maxBytes() <= 0) {
+        return;
+    }
+
+    quint64 generation = m_compressedTier->generation();
+    CompressedPageCache* tier = m_compressedTier.get();
+    m_compressPool.start([tier, key, image, generation]() {
+        tier->insert(key, image, generation);
+    });
+}
+
+PageCacheManager::CacheNode* PageCacheManager::selectCandidateLocked(
+    const Shard& shard, const EvictionContext& context, int probeDepth) const
+{
+    // 注意：调用此方法前必须已经获取分片锁
+
+    const CacheStrategy strategy = context.strategy;
+    const bool fromHead = (strategy == CacheStrategy::MRU);
+    CacheNode* fallback = nullptr;
+    CacheNode* node = fromHead ? shard.head : shard.tail;
+
+    for (int depth = 0; node && depth < probeDepth; ++depth) {
+        CacheNode* current = node;
+        node = fromHead ? node->next : node->prev;
+
+        if (current->key == context.keepKey) {
+            continue;
+        }
+
+        if (strategy != CacheStrategy::NearCurrent) {
+            return current;
+        }
+
+        // NearCurrent：不淘汰可见且缩放/旋转匹配的页面，优先淘汰其他缩放/旋转下的页面
+        bool matchesCurrent = qAbs(current->key.zoom - context.currentKey.zoom) < 0.001 &&
+                              current->key.rotation == context.currentKey.rotation;
+        if (!matchesCurrent) {
+            return current;
+        }
+        if (!context.visiblePages.contains(current->key.pageIndex) && !fallback) {
+            fallback = current;
+        }
     }
 
-    return selectedKey;
+    return fallback;
 }
 
-void PageCacheManager::updateAccessTime(const PageCacheKey& key)
+void PageCacheManager::removeNodeLocked(Shard& shard, CacheNode* node)
 {
-    // 注意：调用此方法前必须已经获取互斥锁
-    m_accessTime[key] = ++m_timeCounter;
+    // 注意：调用此方法前必须已经获取分片锁
+
+    shard.unlink(node);
+    shard.index.remove(node->key);
+
+    auto pageIt = shard.pageNodes.find(node->key.pageIndex);
+    if (pageIt != shard.pageNodes.end()) {
+        pageIt->removeOne(node);
+        if (pageIt->isEmpty()) {
+            shard.pageNodes.erase(pageIt);
+        }
+    }
+
+    m_totalBytes -= node->bytes;
+    delete node;
 }
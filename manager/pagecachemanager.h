@@ -6,6 +6,12 @@
 #include <QSet>
 #include <QMutex>
 #include <QHash>
+#include <QVector>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+
+class CompressedPageCache;
 
 /**
  * @brief 页面缓存键
@@ -60,19 +66,68 @@ struct PageCacheKey {
 };
 
 // 为QHash提供哈希函数
-inline uint qHash(const PageCacheKey& key, uint seed = 0) {
+inline size_t qHash(const PageCacheKey& key, size_t seed = 0) {
     return key.hash() ^ seed;
 }
 
+/**
+ * @brief 缓存页面的渲染质量
+ */
+enum class PageQuality {
+    Draft,      ///< 快速预览（低分辨率渲染或放大的缩略图），只用于占位
+    Final       ///< 目标分辨率的最终渲染
+};
+
+/**
+ * @brief 瓦片缓存键
+ *
+ * 高缩放比例下页面按固定大小瓦片渲染，缩放比例量化为千分之一的桶，
+ * 保证同一缩放下的瓦片键完全一致
+ */
+struct TileCacheKey {
+    int pageIndex;      ///< 页码
+    int zoomBucket;     ///< 量化后的缩放比例（zoom * 1000）
+    int rotation;       ///< 旋转角度
+    int tileX;          ///< 瓦片列号
+    int tileY;          ///< 瓦片行号
+
+    TileCacheKey(int page = -1, double zoom = 1.0, int rot = 0, int tx = 0, int ty = 0)
+        : pageIndex(page), zoomBucket(zoomBucketFor(zoom)), rotation(rot), tileX(tx), tileY(ty) {}
+
+    static int zoomBucketFor(double zoom) { return qRound(zoom * 1000); }
+
+    bool operator==(const TileCacheKey& other) const {
+        return pageIndex == other.pageIndex &&
+               zoomBucket == other.zoomBucket &&
+               rotation == other.rotation &&
+               tileX == other.tileX &&
+               tileY == other.tileY;
+    }
+
+    QString toString() const {
+        return QString("Page:%1,Zoom:%2,Rot:%3,Tile:(%4,%5)")
+        .arg(pageIndex).arg(zoomBucket / 1000.0, 0, 'f', 2).arg(rotation).arg(tileX).arg(tileY);
+    }
+};
+
+inline size_t qHash(const TileCacheKey& key, size_t seed = 0) {
+    return qHash(key.pageIndex, seed) ^ qHash(key.zoomBucket) ^ qHash(key.rotation) ^
+           qHash((key.tileX << 16) ^ key.tileY);
+}
+
 /**
  * @brief 页面缓存管理器（修复版）
  *
  * 负责管理PDF页面的渲染缓存，特性：
  * - 缓存键包含页码、缩放、旋转
- * - LRU缓存淘汰策略
+ * - 按字节预算淘汰：页面与瓦片按 QImage::sizeInBytes() 精确计入，
+ *   超过高水位后按策略淘汰到低水位
+ * - 哈希表 + 侵入式访问链表，查找/插入/淘汰均为 O(1)
+ * - 按页码分片加锁，绘制线程的读取不会被后台渲染线程的写入阻塞
+ * - 淘汰的最终渲染在后台压缩进第二层（CompressedPageCache），再次访问时解压恢复
  * - 智能预加载
  * - 线程安全
- * - 内存使用监控
+ * - 内存使用监控（按缩放比例统计）
  */
 class PageCacheManager
 {
@@ -88,33 +143,77 @@ public:
 
     /**
      * @brief 构造函数
-     * @param maxSize 最大缓存页面数
+     * @param highWatermark 内存高水位（字节），超过后开始淘汰
+     * @param lowWatermark 内存低水位（字节），淘汰到此为止
      * @param strategy 缓存策略
      */
-    explicit PageCacheManager(int maxSize = 10,
+    explicit PageCacheManager(qint64 highWatermark = 512LL * 1024 * 1024,
+                              qint64 lowWatermark = 384LL * 1024 * 1024,
                               CacheStrategy strategy = CacheStrategy::NearCurrent);
 
+    ~PageCacheManager();
+
+    PageCacheManager(const PageCacheManager&) = delete;
+    PageCacheManager& operator=(const PageCacheManager&) = delete;
+
     /**
      * @brief 添加页面到缓存
      * @param pageIndex 页码
-     * @param zoom 缩放比例
+     * @param zoom 缩放比例（草稿也按目标缩放比例存放）
      * @param rotation 旋转角度
      * @param image 渲染的图像
+     * @param quality 渲染质量，草稿不会覆盖已有的最终渲染
      * @return 是否成功添加
      */
-    bool addPage(int pageIndex, double zoom, int rotation, const QImage& image);
+    bool addPage(int pageIndex, double zoom, int rotation, const QImage& image,
+                 PageQuality quality = PageQuality::Final);
 
     /**
-     * @brief 获取缓存的页面
+     * @brief 获取缓存的页面（只返回最终渲染）
+     *
+     * 内存中没有时从压缩层解压，并放回内存缓存
      * @param pageIndex 页码
      * @param zoom 缩放比例
      * @param rotation 旋转角度
-     * @return 图像，如果不在缓存中返回空QImage
+     * @return 图像，如果不在缓存中或只有草稿返回空QImage
      */
     QImage getPage(int pageIndex, double zoom, int rotation);
 
     /**
-     * @brief 检查页面是否在缓存中
+     * @brief 获取内存中的最终渲染，不解压压缩层（界面线程的绘制路径使用）
+     * @return 只在压缩层中或未缓存时返回空QImage（不计入未命中）
+     */
+    QImage getResidentPage(int pageIndex, double zoom, int rotation);
+
+    /**
+     * @brief 从压缩层解压页面，不放回内存缓存（由调用方写入）
+     *
+     * 解码代价与页面大小成正比，应在渲染工作线程调用
+     * @return 压缩层中没有时返回空QImage
+     */
+    QImage restoreCompressedPage(int pageIndex, double zoom, int rotation);
+
+    /**
+     * @brief 获取缓存的页面，没有最终渲染时返回草稿
+     *
+     * 草稿尺寸小于目标尺寸，调用方需要缩放绘制
+     * @param isDraft 输出参数，返回的是否为草稿
+     */
+    QImage getPageOrDraft(int pageIndex, double zoom, int rotation, bool* isDraft = nullptr);
+
+    /**
+     * @brief 获取同一旋转下缩放比例最接近的最终渲染（缩放过程中的替身）
+     *
+     * 缩放比例按对数距离比较，距离相同时取较大的缩放（缩小绘制更清晰）。
+     * 精确匹配时等同于 getPage()，scale 为 1。不计入命中统计，也不更新访问顺序，
+     * 避免替身把旧缩放下的页面一直留在缓存里。
+     * @param scale 输出参数，目标缩放 / 缓存缩放，绘制时图像需要放大的倍数
+     * @return 图像，该页在此旋转下没有最终渲染时返回空QImage
+     */
+    QImage getNearestZoomPage(int pageIndex, double zoom, int rotation, double* scale = nullptr) const;
+
+    /**
+     * @brief 检查页面的最终渲染是否在缓存中（包括压缩层）
      * @param pageIndex 页码
      * @param zoom 缩放比例
      * @param rotation 旋转角度
@@ -122,6 +221,22 @@ public:
      */
     bool contains(int pageIndex, double zoom, int rotation) const;
 
+    /**
+     * @brief 检查页面是否有任意质量的缓存（草稿或最终渲染）
+     */
+    bool containsAnyQuality(int pageIndex, double zoom, int rotation) const;
+
+    /**
+     * @brief 内存中是否有最终渲染（不检查压缩层）
+     */
+    bool isResident(int pageIndex, double zoom, int rotation) const;
+
+    /**
+     * @brief 内存中最终渲染的尺寸（不更新访问顺序，不计入命中统计）
+     * @return 不在内存中时返回无效尺寸
+     */
+    QSize residentPageSize(int pageIndex, double zoom, int rotation) const;
+
     /**
      * @brief 移除指定页面
      * @param pageIndex 页码
@@ -143,15 +258,37 @@ public:
     void clearByZoomRotation(double zoom = -1, int rotation = -1);
 
     /**
-     * @brief 设置最大缓存大小
-     * @param maxSize 最大页面数
+     * @brief 设置内存预算
+     * @param highWatermark 高水位（字节）
+     * @param lowWatermark 低水位（字节），大于高水位时按高水位处理
+     */
+    void setMemoryBudget(qint64 highWatermark, qint64 lowWatermark);
+
+    /**
+     * @brief 获取内存高/低水位（字节）
+     */
+    qint64 highWatermark() const;
+    qint64 lowWatermark() const;
+
+    /**
+     * @brief 设置压缩层的字节预算（按压缩后大小计，0 表示关闭）
+     */
+    void setCompressedBudget(qint64 maxBytes);
+
+    /**
+     * @brief 获取压缩层占用的内存（压缩后大小，不计入 memoryUsage()）
      */
-    void setMaxSize(int maxSize);
+    qint64 compressedMemoryUsage() const;
 
     /**
-     * @brief 获取最大缓存大小
+     * @brief 按当前策略释放指定字节数（供全局缓存调控器使用）
+     *
+     * 先淘汰页面与瓦片（最终渲染照常进入压缩层），仍不足时再淘汰压缩层
+     * @param bytes 需要释放的字节数
+     * @param includeVisible 是否允许淘汰可见页面（后台标签页为 true）
+     * @return 实际释放的字节数（内存层与压缩层合计）
      */
-    int maxSize() const { return m_maxSize; }
+    qint64 releaseMemory(qint64 bytes, bool includeVisible);
 
     /**
      * @brief 设置缓存策略
@@ -162,7 +299,7 @@ public:
     /**
      * @brief 获取当前缓存策略
      */
-    CacheStrategy strategy() const { return m_strategy; }
+    CacheStrategy strategy() const;
 
     /**
      * @brief 获取当前缓存的页面数
@@ -183,7 +320,7 @@ public:
     void setCurrentPage(int pageIndex, double zoom, int rotation);
 
     /**
-     * @brief 获取缓存占用的内存大小（估算，字节）
+     * @brief 获取缓存占用的内存大小（页面与瓦片的 QImage::sizeInBytes() 之和）
      */
     qint64 memoryUsage() const;
 
@@ -194,44 +331,182 @@ public:
     void markVisiblePages(const QSet<int>& visiblePages);
 
     /**
-     * @brief 获取缓存统计信息（调试用）
+     * @brief 获取缓存统计信息（调试用），包含每个缩放比例的精确字节数
      */
     QString getStatistics() const;
 
+    // ========== 瓦片缓存（高缩放比例） ==========
+
+    /**
+     * @brief 添加瓦片到缓存
+     */
+    bool addTile(const TileCacheKey& key, const QImage& tile);
+
+    /**
+     * @brief 获取缓存的瓦片，不存在时返回空QImage
+     */
+    QImage getTile(const TileCacheKey& key);
+
+    /**
+     * @brief 检查瓦片是否在缓存中
+     */
+    bool containsTile(const TileCacheKey& key) const;
+
+    /**
+     * @brief 设置最大瓦片数（按视口大小估算）
+     */
+    void setMaxTiles(int maxTiles);
+
+    /**
+     * @brief 获取当前缓存的瓦片数
+     */
+    int tileCount() const;
+
 private:
     /**
-     * @brief 执行缓存淘汰
+     * @brief 页面缓存节点，同时挂在分片的哈希表和访问顺序链表上
+     */
+    struct CacheNode {
+        PageCacheKey key;
+        QImage image;
+        PageQuality quality = PageQuality::Final;
+        qint64 bytes = 0;                       ///< image.sizeInBytes()
+        quint64 lastUse = 0;                    ///< 全局访问序号
+        CacheNode* prev = nullptr;              ///< 更近访问的节点
+        CacheNode* next = nullptr;              ///< 更早访问的节点
+    };
+
+    /**
+     * @brief 缓存分片：独立加锁，页面按页码分布
+     *
+     * 绘制线程读取某一页只锁该页所在的分片，不会被其他页面的写入阻塞
+     */
+    struct Shard {
+        mutable QMutex mutex;
+        QHash<PageCacheKey, CacheNode*> index;
+        QHash<int, QVector<CacheNode*>> pageNodes;  ///< 页码 -> 该页所有缩放/旋转的节点
+        CacheNode* head = nullptr;              ///< 最近访问
+        CacheNode* tail = nullptr;              ///< 最久未访问
+
+        void unlink(CacheNode* node);
+        void pushFront(CacheNode* node);
+        void touch(CacheNode* node);            ///< 移到链表头部
+    };
+
+    /**
+     * @brief 淘汰时使用的状态快照
+     */
+    struct EvictionContext {
+        PageCacheKey keepKey;
+        PageCacheKey currentKey;
+        QSet<int> visiblePages;
+        CacheStrategy strategy = CacheStrategy::LRU;
+    };
+
+    static constexpr int SHARD_COUNT = 16;      ///< 分片数（2 的幂）
+    static constexpr int EVICT_PROBE_DEPTH = 8; ///< 每个分片从链表尾部探查的节点数
+
+    /**
+     * @brief 规整缓存键：缩放比例量化到千分之一，保证相等的键哈希一致
+     */
+    static PageCacheKey normalizedKey(int pageIndex, double zoom, int rotation);
+
+    Shard& shardFor(int pageIndex) const;
+
+    /**
+     * @brief 加锁分片，锁被占用时计入竞争统计
+     */
+    void lockShard(const Shard& shard) const;
+
+    /**
+     * @brief 超过高水位时淘汰到低水位（不能持有任何分片锁或瓦片锁）
+     *
+     * 先按策略淘汰页面，没有可淘汰的页面后再淘汰瓦片
+     * @param keepKey 刚插入的页面，不参与淘汰
      */
-    void evict();
+    void enforceBudget(const PageCacheKey& keepKey = PageCacheKey());
+
+    /**
+     * @brief 按当前策略淘汰直到内存占用不超过 target（调用前必须已持有淘汰锁）
+     */
+    void evictDownTo(qint64 target, const EvictionContext& context);
+
+    EvictionContext evictionContextSnapshot(const PageCacheKey& keepKey) const;
 
     /**
-     * @brief 根据策略选择要淘汰的键
-     * @return 要淘汰的缓存键
+     * @brief 淘汰一个页面
+     *
+     * 每个分片从链表尾部（MRU 策略从头部）探查少量节点，取全局最合适的一个，
+     * 代价与缓存大小无关
+     * @return 是否淘汰了页面
      */
-    PageCacheKey selectKeyToEvict();
+    bool evictPage(const EvictionContext& context);
 
     /**
-     * @brief 更新访问记录
-     * @param key 缓存键
+     * @brief 在一个分片中选择淘汰候选（调用前必须已持有分片锁）
+     * @param probeDepth 从链表一端最多查看的节点数
      */
-    void updateAccessTime(const PageCacheKey& key);
+    CacheNode* selectCandidateLocked(const Shard& shard, const EvictionContext& context,
+                                     int probeDepth) const;
+
+    /**
+     * @brief 按给定探查深度在所有分片中选出一个页面并淘汰
+     * @return 没有任何候选时返回 false
+     */
+    bool evictPageWithDepth(const EvictionContext& context, int probeDepth);
+
+    /**
+     * @brief 移除节点并扣除其内存（调用前必须已持有分片锁）
+     */
+    void removeNodeLocked(Shard& shard, CacheNode* node);
+
+    /**
+     * @brief 淘汰最久未访问的瓦片（调用前必须已持有瓦片锁）
+     */
+    void evictTileLocked(const PageCacheKey& currentKey);
+
+    /**
+     * @brief 移除瓦片并扣除其内存（调用前必须已持有瓦片锁）
+     */
+    void removeTileLocked(const TileCacheKey& key);
+
+    /**
+     * @brief 在后台把淘汰的最终渲染压缩进第二层
+     */
+    void compressEvicted(const PageCacheKey& key, const QImage& image);
+
+    PageCacheKey currentKeySnapshot() const;
 
 private:
-    mutable QMutex m_mutex;                     ///< 线程安全锁
+    mutable Shard m_shards[SHARD_COUNT];        ///< 页面缓存分片
 
-    int m_maxSize;                              ///< 最大缓存大小
-    CacheStrategy m_strategy;                   ///< 缓存策略
+    std::atomic<qint64> m_highWatermark;        ///< 内存高水位（字节）
+    std::atomic<qint64> m_lowWatermark;         ///< 内存低水位（字节）
+    std::atomic<qint64> m_totalBytes;           ///< 页面与瓦片的实际内存占用
+    std::atomic<quint64> m_useCounter;          ///< 全局访问序号
+    QMutex m_evictMutex;                        ///< 同一时刻只有一个线程执行淘汰
 
-    QMap<PageCacheKey, QImage> m_cache;         ///< 页面缓存
-    QMap<PageCacheKey, qint64> m_accessTime;    ///< 访问时间戳
+    mutable QMutex m_stateMutex;                ///< 保护策略、当前页和可见页面
+    CacheStrategy m_strategy;                   ///< 缓存策略
+    PageCacheKey m_currentKey;                  ///< 当前页面键
     QSet<int> m_visiblePages;                   ///< 当前可见的页面集合
 
-    PageCacheKey m_currentKey;                  ///< 当前页面键
-    qint64 m_timeCounter;                       ///< 时间计数器（用于LRU）
+    mutable QMutex m_tileMutex;                 ///< 瓦片缓存锁
+    QHash<TileCacheKey, QImage> m_tiles;        ///< 瓦片缓存
+    QHash<TileCacheKey, quint64> m_tileAccessTime; ///< 瓦片访问序号
+    int m_maxTiles;                             ///< 最大瓦片数
+    qint64 m_tileHitCount;                      ///< 瓦片命中次数（受 m_tileMutex 保护）
+    qint64 m_tileMissCount;                     ///< 瓦片未命中次数（受 m_tileMutex 保护）
+
+    std::unique_ptr<CompressedPageCache> m_compressedTier; ///< 第二层：压缩页面
+    QThreadPool m_compressPool;                 ///< 压缩线程（单线程，按淘汰顺序编码）
 
     // 统计信息
-    qint64 m_hitCount;                          ///< 缓存命中次数
-    qint64 m_missCount;                         ///< 缓存未命中次数
+    mutable std::atomic<qint64> m_hitCount;     ///< 缓存命中次数
+    mutable std::atomic<qint64> m_missCount;    ///< 缓存未命中次数
+    std::atomic<qint64> m_restoredCount;        ///< 从压缩层恢复的次数
+    std::atomic<qint64> m_evictedBytes;         ///< 累计淘汰的字节数
+    mutable std::atomic<qint64> m_contendedLocks; ///< 加锁时需要等待的次数
 };
 
 #endif // PAGECACHEMANAGER_H
@@ -0,0 +1,526 @@
+#include "pagerenderservice.h"
+#include "pagecachemanager.h"
+#include "perthreadmupdfrenderer.h"
+#include "mupdfdocumentcore.h"
+#include "diskpagecache.h"
+#include "appconfig.h"
+#include <QDebug>
+#include <QThread>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <memory>
+
+// ========================================
+// PageRenderWorker - 常驻渲染线程
+// ========================================
+class PageRenderWorker : public QThread
+{
+public:
+    explicit PageRenderWorker(PageRenderService* service)
+        : m_service(service)
+        , m_documentEpoch(-1)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        PageRenderRequest request;
+        QString documentPath;
+        QString fingerprint;
+        int documentEpoch = 0;
+        bool paperEffect = false;
+        RenderCancelTokenPtr cancelToken;
+
+        while (m_service->waitForRequest(request, documentPath, fingerprint, documentEpoch,
+                                         paperEffect, cancelToken)) {
+            // 文档变化后从共享核心重新克隆（渲染器只在本线程内使用）
+            if (documentEpoch != m_documentEpoch) {
+                m_renderer.reset();
+                if (!documentPath.isEmpty()) {
+                    std::shared_ptr<MuPDFDocumentCore> core = MuPDFDocumentCore::acquire(documentPath);
+                    if (core) {
+                        m_renderer = std::make_unique<PerThreadMuPDFRenderer>(core);
+                    }
+                }
+                m_documentEpoch = documentEpoch;
+            }
+
+            if (!m_renderer || !m_renderer->isDocumentLoaded()) {
+                RenderResult failed;
+                failed.errorMessage = QStringLiteral("Document not loaded");
+                m_service->completeRequest(request, failed, 0);
+                continue;
+            }
+
+            m_renderer->setPaperEffectEnabled(paperEffect);
+
+            QElapsedTimer timer;
+            timer.start();
+
+            // 压缩层中已有最终渲染：在本线程解压，不必重新渲染
+            if (!request.draft && !request.isTile()) {
+                RenderResult restored;
+                restored.image = m_service->m_cache->restoreCompressedPage(
+                    request.pageIndex, request.zoom, request.rotation);
+                if (!restored.image.isNull()) {
+                    restored.success = true;
+                    cancelToken.reset();
+                    m_service->completeRequest(request, restored, timer.elapsed(),
+                                               PageRenderService::ResultSource::Compressed);
+                    continue;
+                }
+            }
+
+            // 最终的整页渲染先查磁盘缓存（草稿和瓦片不落盘）
+            DiskPageCache& diskCache = DiskPageCache::instance();
+            DiskPageKey diskKey;
+            if (!request.draft && !request.isTile() && diskCache.isEnabled()) {
+                diskKey = DiskPageKey(fingerprint, request.pageIndex, request.zoom,
+                                      request.rotation, paperEffect);
+                RenderResult cached;
+                cached.image = diskCache.load(diskKey);
+                if (!cached.image.isNull()) {
+                    cached.success = true;
+                    cancelToken.reset();
+                    m_service->completeRequest(request, cached, timer.elapsed(),
+                                               PageRenderService::ResultSource::Disk);
+                    continue;
+                }
+            }
+
+            RenderResult result;
+            if (request.draft) {
+                result = m_renderer->renderPage(request.pageIndex,
+                                                request.zoom * AppConfig::DRAFT_ZOOM_RATIO,
+                                                request.rotation, cancelToken.get());
+            } else if (request.isTile()) {
+                const int tileSize = AppConfig::TILE_SIZE;
+                QRect region(request.tileX * tileSize, request.tileY * tileSize, tileSize, tileSize);
+                result = m_renderer->renderPageRegion(request.pageIndex, request.zoom,
+                                                      request.rotation, region, cancelToken.get());
+            } else {
+                result = m_renderer->renderPage(request.pageIndex, request.zoom, request.rotation,
+                                                cancelToken.get());
+            }
+            cancelToken.reset();
+
+            if (result.success && diskKey.isValid()) {
+                diskCache.store(diskKey, result.image);
+            }
+
+            m_service->completeRequest(request, result, timer.elapsed());
+        }
+
+        m_renderer.reset();
+    }
+
+private:
+    PageRenderService* m_service;
+    std::unique_ptr<PerThreadMuPDFRenderer> m_renderer;
+    int m_documentEpoch;
+};
+
+// ========================================
+// PageRenderService 实现
+// ========================================
+PageRenderService::PageRenderService(PageCacheManager* cache, QObject* parent)
+    : QObject(parent)
+    , m_cache(cache)
+    , m_supersedeCheckPosted(false)
+    , m_documentEpoch(0)
+    , m_paperEffectEnabled(false)
+    , m_stopping(false)
+    , m_generation(1)
+    , m_renderedCount(0)
+    , m_staleDropped(0)
+    , m_failedCount(0)
+    , m_cancelledCount(0)
+    , m_totalRenderMs(0)
+    , m_diskHitCount(0)
+    , m_restoredCount(0)
+{
+    for (int i = 0; i < AppConfig::RENDER_WORKER_COUNT; ++i) {
+        PageRenderWorker* worker = new PageRenderWorker(this);
+        worker->setObjectName(QString("PageRenderWorker-%1").arg(i));
+        m_workers.append(worker);
+        worker->start(QThread::HighPriority);
+    }
+}
+
+PageRenderService::~PageRenderService()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        clearPendingLocked();
+        cancelInFlightLocked();
+        m_condition.wakeAll();
+    }
+
+    for (PageRenderWorker* worker : m_workers) {
+        worker->wait();
+        delete worker;
+    }
+    m_workers.clear();
+
+    qInfo() << "PageRenderService: Destroyed";
+}
+
+void PageRenderService::setDocument(const QString& documentPath, const QString& fingerprint)
+{
+    QMutexLocker locker(&m_mutex);
+    clearPendingLocked();
+    m_documentPath = documentPath;
+    m_documentFingerprint = fingerprint;
+    m_documentEpoch++;
+    m_generation.fetch_add(1);
+    cancelInFlightLocked();
+}
+
+void PageRenderService::closeDocument()
+{
+    setDocument(QString());
+}
+
+void PageRenderService::setPaperEffectEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_paperEffectEnabled == enabled) {
+        return;
+    }
+
+    m_paperEffectEnabled = enabled;
+    clearPendingLocked();
+    m_generation.fetch_add(1);
+    cancelInFlightLocked();
+}
+
+quint64 PageRenderService::invalidate()
+{
+    QMutexLocker locker(&m_mutex);
+    clearPendingLocked();
+    quint64 generation = m_generation.fetch_add(1) + 1;
+    cancelInFlightLocked();
+    return generation;
+}
+
+void PageRenderService::schedule(const QVector<int>& pages, PageRenderPriority priority,
+                                 double zoom, int rotation, bool replacePending)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (replacePending) {
+        clearPendingLocked();
+        markInFlightSupersededLocked();
+    }
+
+    if (m_documentPath.isEmpty()) {
+        return;
+    }
+
+    bool added = false;
+
+    for (int pageIndex : pages) {
+        PageRenderRequest request;
+        request.pageIndex = pageIndex;
+        request.zoom = zoom;
+        request.rotation = rotation;
+        request.priority = priority;
+
+        added |= enqueueLocked(request);
+    }
+
+    if (added) {
+        m_condition.wakeAll();
+    }
+}
+
+void PageRenderService::scheduleDrafts(const QVector<int>& pages, double zoom, int rotation)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_documentPath.isEmpty()) {
+        return;
+    }
+
+    bool added = false;
+
+    for (int pageIndex : pages) {
+        PageRenderRequest request;
+        request.pageIndex = pageIndex;
+        request.zoom = zoom;
+        request.rotation = rotation;
+        request.priority = PageRenderPriority::Draft;
+        request.draft = true;
+
+        added |= enqueueLocked(request);
+    }
+
+    if (added) {
+        m_condition.wakeAll();
+    }
+}
+
+void PageRenderService::scheduleTiles(const QVector<TileCacheKey>& tiles, PageRenderPriority priority,
+                                      double zoom, bool replacePending)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (replacePending) {
+        clearPendingLocked();
+        markInFlightSupersededLocked();
+    }
+
+    if (m_documentPath.isEmpty()) {
+        return;
+    }
+
+    bool added = false;
+
+    for (const TileCacheKey& tile : tiles) {
+        PageRenderRequest request;
+        request.pageIndex = tile.pageIndex;
+        request.zoom = zoom;
+        request.rotation = tile.rotation;
+        request.priority = priority;
+        request.tileX = tile.tileX;
+        request.tileY = tile.tileY;
+
+        added |= enqueueLocked(request);
+    }
+
+    if (added) {
+        m_condition.wakeAll();
+    }
+}
+
+bool PageRenderService::enqueueLocked(const PageRenderRequest& request)
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    const quint64 generation = m_generation.load();
+    quint64 key = requestKey(request);
+
+    auto inFlight = m_inFlight.find(key);
+    if (inFlight != m_inFlight.end() && inFlight->generation == generation) {
+        // 仍然需要，不要中止
+        inFlight->superseded = false;
+        return false;
+    }
+
+    if (m_pendingKeys.contains(key)) {
+        return false;
+    }
+
+    bool cached = false;
+    if (request.draft) {
+        cached = m_cache->containsAnyQuality(request.pageIndex, request.zoom, request.rotation);
+    } else if (request.isTile()) {
+        cached = m_cache->containsTile(TileCacheKey(request.pageIndex, request.zoom, request.rotation,
+                                                    request.tileX, request.tileY));
+    } else {
+        // 只在压缩层中的页面照常入队，由工作线程解压
+        cached = m_cache->isResident(request.pageIndex, request.zoom, request.rotation);
+    }
+    if (cached) {
+        return false;
+    }
+
+    PageRenderRequest queued = request;
+    queued.generation = generation;
+
+    m_queues[static_cast<int>(request.priority)].append(queued);
+    m_pendingKeys.insert(key);
+    return true;
+}
+
+quint64 PageRenderService::generation() const
+{
+    return m_generation.load();
+}
+
+int PageRenderService::pendingCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pendingKeys.size();
+}
+
+QString PageRenderService::getStatistics() const
+{
+    qint64 rendered = m_renderedCount.load();
+    double avgMs = rendered > 0 ? double(m_totalRenderMs.load()) / rendered : 0.0;
+
+    return QString("Render Service: Workers=%1, Pending=%2, Rendered=%3, Disk hits=%4, "
+                   "Restored=%5, Stale dropped=%6, Cancelled=%7, Failed=%8, Avg=%9ms")
+        .arg(m_workers.size())
+        .arg(pendingCount())
+        .arg(rendered)
+        .arg(m_diskHitCount.load())
+        .arg(m_restoredCount.load())
+        .arg(m_staleDropped.load())
+        .arg(m_cancelledCount.load())
+        .arg(m_failedCount.load())
+        .arg(avgMs, 0, 'f', 1);
+}
+
+bool PageRenderService::waitForRequest(PageRenderRequest& request, QString& documentPath,
+                                       QString& fingerprint, int& documentEpoch, bool& paperEffect,
+                                       RenderCancelTokenPtr& cancelToken)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (!m_stopping) {
+        for (QList<PageRenderRequest>& queue : m_queues) {
+            while (!queue.isEmpty()) {
+                PageRenderRequest next = queue.takeFirst();
+                quint64 key = requestKey(next);
+                m_pendingKeys.remove(key);
+
+                if (next.generation != m_generation.load()) {
+                    m_staleDropped++;
+                    continue;
+                }
+
+                InFlightRequest inFlight;
+                inFlight.generation = next.generation;
+                inFlight.cancelToken = std::make_shared<RenderCancelToken>();
+                m_inFlight.insert(key, inFlight);
+
+                cancelToken = inFlight.cancelToken;
+                request = next;
+                documentPath = m_documentPath;
+                fingerprint = m_documentFingerprint;
+                documentEpoch = m_documentEpoch;
+                paperEffect = m_paperEffectEnabled;
+                return true;
+            }
+        }
+
+        m_condition.wait(&m_mutex);
+    }
+
+    return false;
+}
+
+void PageRenderService::completeRequest(const PageRenderRequest& request, const RenderResult& result,
+                                        qint64 elapsedMs, ResultSource source)
+{
+    const bool success = result.success;
+    const QString& error = result.errorMessage;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        quint64 key = requestKey(request);
+        auto inFlight = m_inFlight.find(key);
+        if (inFlight != m_inFlight.end() && inFlight->generation == request.generation) {
+            m_inFlight.erase(inFlight);
+        }
+
+        if (result.cancelled) {
+            m_cancelledCount++;
+            return;
+        }
+
+        // 在锁内比较代数，保证 invalidate() 返回后不会再有旧结果进入缓存
+        if (request.generation != m_generation.load()) {
+            m_staleDropped++;
+            return;
+        }
+
+        if (success) {
+            if (request.isTile()) {
+                m_cache->addTile(TileCacheKey(request.pageIndex, request.zoom, request.rotation,
+                                              request.tileX, request.tileY), result.image);
+            } else {
+                m_cache->addPage(request.pageIndex, request.zoom, request.rotation, result.image,
+                                 request.draft ? PageQuality::Draft : PageQuality::Final);
+            }
+        }
+    }
+
+    if (success) {
+        switch (source) {
+        case ResultSource::Disk:
+            m_diskHitCount++;
+            break;
+        case ResultSource::Compressed:
+            m_restoredCount++;
+            break;
+        case ResultSource::Rendered:
+            m_renderedCount++;
+            m_totalRenderMs += elapsedMs;
+            break;
+        }
+        emit pageRendered(request.pageIndex, request.zoom, request.rotation);
+    } else {
+        m_failedCount++;
+        qWarning() << "PageRenderService: Failed to render page" << request.pageIndex
+                   << "Error:" << error;
+        emit pageRenderFailed(request.pageIndex, error);
+    }
+}
+
+void PageRenderService::clearPendingLocked()
+{
+    for (QList<PageRenderRequest>& queue : m_queues) {
+        queue.clear();
+    }
+    m_pendingKeys.clear();
+}
+
+void PageRenderService::cancelInFlightLocked()
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+    // 令牌保留在表中，由工作线程在 completeRequest() 中移除
+
+    for (const InFlightRequest& inFlight : m_inFlight) {
+        inFlight.cancelToken->cancel();
+    }
+}
+
+void PageRenderService::markInFlightSupersededLocked()
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    if (m_inFlight.isEmpty()) {
+        return;
+    }
+
+    for (InFlightRequest& inFlight : m_inFlight) {
+        inFlight.superseded = true;
+    }
+
+    // 本轮调度的所有 schedule 调用都在同一次事件处理中完成，之后再检查
+    if (!m_supersedeCheckPosted) {
+        m_supersedeCheckPosted = true;
+        QMetaObject::invokeMethod(this, [this]() { cancelSupersededInFlight(); },
+                                  Qt::QueuedConnection);
+    }
+}
+
+void PageRenderService::cancelSupersededInFlight()
+{
+    QMutexLocker locker(&m_mutex);
+    m_supersedeCheckPosted = false;
+
+    for (InFlightRequest& inFlight : m_inFlight) {
+        if (inFlight.superseded) {
+            inFlight.cancelToken->cancel();
+        }
+    }
+}
+
+quint64 PageRenderService::requestKey(const PageRenderRequest& request)
+{
+    // 页码 20 位 | 缩放桶 20 位 | 旋转 2 位 | 瓦片列 11 位 | 瓦片行 11 位
+    // 整页请求的瓦片列/行为 0x7FF/0x7FF，草稿为 0x7FF/0x7FE
+    quint64 page = static_cast<quint64>(request.pageIndex) & 0xFFFFF;
+    quint64 zoomBucket = static_cast<quint64>(TileCacheKey::zoomBucketFor(request.zoom)) & 0xFFFFF;
+    quint64 rot = static_cast<quint64>(((request.rotation % 360) + 360) % 360 / 90) & 0x3;
+    quint64 tx = request.isTile() ? (static_cast<quint64>(request.tileX) & 0x7FF) : 0x7FF;
+    quint64 ty = request.isTile() ? (static_cast<quint64>(request.tileY) & 0x7FF)
+                                  : (request.draft ? 0x7FE : 0x7FF);
+
+    return (page << 44) | (zoomBucket << 24) | (rot << 22) | (tx << 11) | ty;
+}
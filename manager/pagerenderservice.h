@@ -0,0 +1,247 @@
+#ifndef PAGERENDERSERVICE_H
+#define PAGERENDERSERVICE_H
+
+#include <QObject>
+#include <QList>
+#include <QSet>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include <atomic>
+#include <memory>
+
+#include "pagecachemanager.h"
+#include "rendercanceltoken.h"
+#include "datastructure.h"
+
+class QImage;
+class PageRenderWorker;
+
+/**
+ * @brief 主视图渲染优先级
+ *
+ * 数值越小优先级越高，工作线程总是先取高优先级队列中的请求
+ */
+enum class PageRenderPriority {
+    Draft = 0,          ///< 可见页面的快速预览
+    Visible = 1,        ///< 视口内可见页面
+    Preload = 2,        ///< 预加载边距内的页面
+    Speculative = 3     ///< 预加载范围之外的推测页面
+};
+
+/**
+ * @brief 单个页面渲染请求
+ */
+struct PageRenderRequest {
+    int pageIndex = -1;
+    double zoom = 1.0;
+    int rotation = 0;
+    PageRenderPriority priority = PageRenderPriority::Visible;
+    quint64 generation = 0;     ///< 提交时的代数，过期请求直接丢弃
+    int tileX = -1;             ///< 瓦片列号，-1 表示整页
+    int tileY = -1;             ///< 瓦片行号，-1 表示整页
+    bool draft = false;         ///< 草稿：按 zoom * DRAFT_ZOOM_RATIO 渲染，以 zoom 为键写入缓存
+
+    bool isTile() const { return tileX >= 0 && tileY >= 0; }
+};
+
+/**
+ * @brief 主视图异步渲染服务
+ *
+ * 职责：
+ * 1. 持有若干常驻工作线程，每个线程拥有从 MuPDFDocumentCore 克隆的 PerThreadMuPDFRenderer
+ * 2. 按优先级（草稿 > 可见 > 预加载 > 推测）调度渲染请求
+ * 3. 通过代数（generation）丢弃缩放/旋转/纸质效果变化前的过期请求
+ * 4. 每个在途请求持有取消令牌：代数变化时立即中止；视口移动后不再需要的页面
+ *    在本轮调度结束后中止，不再占用工作线程
+ * 5. 渲染结果直接写入 PageCacheManager，随后发出 pageRendered 信号
+ * 6. 只在压缩层中的页面也作为最终渲染请求处理：由工作线程解压后放回内存缓存，
+ *    界面线程从不解码
+ *
+ * UI 线程只负责提交请求和响应信号，不再同步等待 MuPDF
+ */
+class PageRenderService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PageRenderService(PageCacheManager* cache, QObject* parent = nullptr);
+    ~PageRenderService();
+
+    /**
+     * @brief 设置当前文档（工作线程在下一次取任务时重新打开）
+     * @param fingerprint 文档指纹，非空且启用磁盘缓存时最终渲染先查磁盘缓存、渲染后写入
+     */
+    void setDocument(const QString& documentPath, const QString& fingerprint = QString());
+
+    /**
+     * @brief 关闭文档，清空队列并使所有在途请求失效
+     */
+    void closeDocument();
+
+    /**
+     * @brief 设置纸质效果（会使在途请求失效）
+     */
+    void setPaperEffectEnabled(bool enabled);
+
+    /**
+     * @brief 使当前所有请求失效
+     *
+     * 清空待处理队列并递增代数，正在渲染的请求完成后会被丢弃
+     * @return 新的代数
+     */
+    quint64 invalidate();
+
+    /**
+     * @brief 提交一批渲染请求
+     *
+     * 新的一批请求会替换所有尚未开始的请求（视口已经移动，旧请求不再有意义）。
+     * 已在缓存中或正在渲染的页面会被跳过。替换时正在渲染、但本轮调度（同一次
+     * 事件处理中的所有 schedule 调用）不再请求的页面会被中止。
+     * @param pages 页面索引（按期望的渲染顺序排列）
+     * @param priority 这批请求的优先级
+     * @param zoom 缩放比例
+     * @param rotation 旋转角度
+     * @param replacePending 是否先清空所有待处理请求
+     */
+    void schedule(const QVector<int>& pages, PageRenderPriority priority,
+                  double zoom, int rotation, bool replacePending = false);
+
+    /**
+     * @brief 提交一批草稿渲染请求（渐进式渲染的第一阶段）
+     *
+     * 以 AppConfig::DRAFT_ZOOM_RATIO 倍的分辨率快速渲染，结果以 PageQuality::Draft
+     * 写入缓存，最终渲染完成后被替换。已有任意质量缓存的页面会被跳过。
+     */
+    void scheduleDrafts(const QVector<int>& pages, double zoom, int rotation);
+
+    /**
+     * @brief 提交一批瓦片渲染请求（高缩放比例）
+     *
+     * 瓦片大小为 AppConfig::TILE_SIZE，结果写入 PageCacheManager 的瓦片缓存
+     * @param tiles 瓦片键（zoomBucket 必须与 zoom 对应）
+     */
+    void scheduleTiles(const QVector<TileCacheKey>& tiles, PageRenderPriority priority,
+                       double zoom, bool replacePending = false);
+
+    /**
+     * @brief 当前代数
+     */
+    quint64 generation() const;
+
+    /**
+     * @brief 待处理请求数
+     */
+    int pendingCount() const;
+
+    /**
+     * @brief 获取统计信息（调试用）
+     */
+    QString getStatistics() const;
+
+signals:
+    /**
+     * @brief 页面渲染完成并已写入缓存（在工作线程发出，跨线程排队投递）
+     */
+    void pageRendered(int pageIndex, double zoom, int rotation);
+
+    /**
+     * @brief 页面渲染失败
+     */
+    void pageRenderFailed(int pageIndex, const QString& error);
+
+private:
+    friend class PageRenderWorker;
+
+    /**
+     * @brief 工作线程阻塞等待下一个请求
+     * @return false 表示服务正在停止
+     */
+    bool waitForRequest(PageRenderRequest& request, QString& documentPath,
+                        QString& fingerprint, int& documentEpoch, bool& paperEffect,
+                        RenderCancelTokenPtr& cancelToken);
+
+    /**
+     * @brief 渲染结果的来源（磁盘缓存和压缩层单独统计，不计入渲染耗时）
+     */
+    enum class ResultSource {
+        Rendered,       ///< MuPDF 渲染
+        Disk,           ///< 磁盘缓存
+        Compressed      ///< 压缩层解压
+    };
+
+    /**
+     * @brief 工作线程提交渲染结果
+     */
+    void completeRequest(const PageRenderRequest& request, const RenderResult& result,
+                         qint64 elapsedMs, ResultSource source = ResultSource::Rendered);
+
+    void clearPendingLocked();
+
+    /**
+     * @brief 中止所有在途请求（代数变化后调用，调用前必须已持有锁）
+     */
+    void cancelInFlightLocked();
+
+    /**
+     * @brief 替换待处理请求时标记在途请求为“可能不再需要”（调用前必须已持有锁）
+     *
+     * 同一轮调度中再次请求的页面会被取消标记，剩下的在 cancelSupersededInFlight() 中中止
+     */
+    void markInFlightSupersededLocked();
+
+    /**
+     * @brief 中止本轮调度不再请求的在途请求（排队到事件循环执行）
+     */
+    void cancelSupersededInFlight();
+
+    /**
+     * @brief 入队一个请求（调用前必须已持有锁）
+     * @return 是否真正入队（已在缓存/队列/渲染中则跳过）
+     */
+    bool enqueueLocked(const PageRenderRequest& request);
+
+    static quint64 requestKey(const PageRenderRequest& request);
+
+private:
+    PageCacheManager* m_cache;
+    QList<PageRenderWorker*> m_workers;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_condition;
+
+    QList<PageRenderRequest> m_queues[4];       ///< 按优先级分组的待处理请求
+    /**
+     * @brief 正在渲染的请求
+     */
+    struct InFlightRequest {
+        quint64 generation = 0;             ///< 提交时的代数
+        RenderCancelTokenPtr cancelToken;   ///< 中止本次渲染
+        bool superseded = false;            ///< 新一轮调度尚未再次请求
+    };
+
+    QHash<quint64, InFlightRequest> m_inFlight; ///< 请求键 -> 在途请求
+    bool m_supersedeCheckPosted;                ///< 已排队 cancelSupersededInFlight()
+    QSet<quint64> m_pendingKeys;                ///< 待处理请求（去重）
+
+    QString m_documentPath;
+    QString m_documentFingerprint;              ///< 磁盘缓存使用的文档指纹
+    int m_documentEpoch;                        ///< 文档变化计数，工作线程据此重新打开文档
+    bool m_paperEffectEnabled;
+    bool m_stopping;
+
+    std::atomic<quint64> m_generation;
+
+    // 统计信息
+    std::atomic<qint64> m_renderedCount;
+    std::atomic<qint64> m_staleDropped;
+    std::atomic<qint64> m_failedCount;
+    std::atomic<qint64> m_cancelledCount;
+    std::atomic<qint64> m_totalRenderMs;
+    std::atomic<qint64> m_diskHitCount;         ///< 从磁盘缓存读取的页面数
+    std::atomic<qint64> m_restoredCount;        ///< 从压缩层解压的页面数
+};
+
+#endif // PAGERENDERSERVICE_H
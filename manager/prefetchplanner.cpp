@@ -0,0 +1,180 @@
+#include "prefetchplanner.h"
+#include <QtMath>
+
+namespace {
+
+// 速度的指数平滑系数（新样本的权重）
+constexpr double VELOCITY_SMOOTHING = 0.5;
+
+// 两次滚动事件间隔超过该值时视为新的一次滚动，不与旧速度平滑（毫秒）
+constexpr qint64 GESTURE_GAP_MS = 200;
+
+// 预加载覆盖的前瞻时间（秒）：前方预加载约为这段时间内滚过的距离
+constexpr double LOOKAHEAD_SECONDS = 0.6;
+
+// 速度超过每秒该数量的视口高度时视为快速滑动
+constexpr double FLING_VIEWPORTS_PER_SECOND = 6.0;
+
+// 前方预加载边距上限（视口高度的倍数）
+constexpr int MAX_AHEAD_VIEWPORTS = 4;
+
+// 前方推测渲染的页数上限
+constexpr int MAX_PAGES_AHEAD = 6;
+
+// 速度低于该值视为静止（像素/秒）
+constexpr double MIN_DIRECTIONAL_VELOCITY = 50.0;
+
+// 预加载记录的上限，超过后清空（只影响“有效预加载”统计）
+constexpr int MAX_TRACKED_PREFETCHES = 512;
+
+} // namespace
+
+PrefetchPlanner::PrefetchPlanner()
+    : m_lastSampleMs(-1)
+    , m_lastScrollY(0)
+    , m_velocity(0)
+    , m_arrivals(0)
+    , m_hits(0)
+    , m_prefetchCount(0)
+    , m_usefulPrefetches(0)
+    , m_suppressedCount(0)
+{
+    m_clock.start();
+}
+
+void PrefetchPlanner::recordScroll(int scrollY)
+{
+    qint64 now = m_clock.elapsed();
+
+    if (m_lastSampleMs >= 0) {
+        qint64 dt = now - m_lastSampleMs;
+
+        if (dt > GESTURE_GAP_MS) {
+            // 新的一次滚动：旧速度已经没有意义，等下一个样本再估算
+            m_velocity = 0;
+        } else if (dt > 0) {
+            double instant = (scrollY - m_lastScrollY) * 1000.0 / dt;
+            m_velocity = (m_velocity == 0)
+                ? instant
+                : VELOCITY_SMOOTHING * instant + (1.0 - VELOCITY_SMOOTHING) * m_velocity;
+        }
+    }
+
+    m_lastSampleMs = now;
+    m_lastScrollY = scrollY;
+}
+
+void PrefetchPlanner::reset()
+{
+    m_lastSampleMs = -1;
+    m_velocity = 0;
+    m_visible.clear();
+    m_prefetched.clear();
+}
+
+double PrefetchPlanner::velocity() const
+{
+    if (m_lastSampleMs < 0 || m_clock.elapsed() - m_lastSampleMs > IDLE_MS) {
+        return 0;
+    }
+    return m_velocity;
+}
+
+PrefetchPlanner::Plan PrefetchPlanner::plan(int viewportHeight, int baseMargin,
+                                            int basePages, double averagePageHeight)
+{
+    Plan result;
+    const double v = velocity();
+    const double speed = qAbs(v);
+
+    // 静止：上下对称
+    if (speed < MIN_DIRECTIONAL_VELOCITY || viewportHeight <= 0) {
+        result.marginBefore = baseMargin;
+        result.marginAfter = baseMargin;
+        result.pagesBefore = basePages;
+        result.pagesAfter = basePages;
+        return result;
+    }
+
+    // 快速滑动：预加载的页面大多会被跳过，只渲染可见页面
+    if (speed > viewportHeight * FLING_VIEWPORTS_PER_SECOND) {
+        result.suppressed = true;
+        m_suppressedCount++;
+        return result;
+    }
+
+    // 普通滚动：前方按速度预加载，后方只保留少量边距
+    int ahead = qBound(baseMargin,
+                       qRound(speed * LOOKAHEAD_SECONDS),
+                       qMax(baseMargin, viewportHeight * MAX_AHEAD_VIEWPORTS));
+    int behind = baseMargin / 4;
+
+    int pagesAhead = basePages;
+    if (averagePageHeight > 0) {
+        pagesAhead = qBound(basePages,
+                            qCeil(speed * LOOKAHEAD_SECONDS / averagePageHeight),
+                            qMax(basePages, MAX_PAGES_AHEAD));
+    }
+
+    if (v > 0) {
+        result.marginBefore = behind;
+        result.marginAfter = ahead;
+        result.pagesAfter = pagesAhead;
+    } else {
+        result.marginBefore = ahead;
+        result.marginAfter = behind;
+        result.pagesBefore = pagesAhead;
+    }
+
+    return result;
+}
+
+void PrefetchPlanner::recordPrefetch(const QVector<int>& pages)
+{
+    if (m_prefetched.size() > MAX_TRACKED_PREFETCHES) {
+        m_prefetched.clear();
+    }
+
+    for (int pageIndex : pages) {
+        if (!m_prefetched.contains(pageIndex) && !m_visible.contains(pageIndex)) {
+            m_prefetched.insert(pageIndex);
+            m_prefetchCount++;
+        }
+    }
+}
+
+void PrefetchPlanner::recordVisible(const QSet<int>& visiblePages, const QSet<int>& cachedPages)
+{
+    for (int pageIndex : visiblePages) {
+        if (m_visible.contains(pageIndex)) {
+            continue;
+        }
+
+        m_arrivals++;
+        if (cachedPages.contains(pageIndex)) {
+            m_hits++;
+        }
+        if (m_prefetched.remove(pageIndex)) {
+            m_usefulPrefetches++;
+        }
+    }
+
+    m_visible = visiblePages;
+}
+
+QString PrefetchPlanner::getStatistics() const
+{
+    double hitRate = (m_arrivals > 0) ? (m_hits * 100.0 / m_arrivals) : 0;
+    double usefulRate = (m_prefetchCount > 0) ? (m_usefulPrefetches * 100.0 / m_prefetchCount) : 0;
+
+    return QString("Prefetch: Hit Rate: %1% (%2/%3 pages ready on arrival), "
+                   "Useful: %4% (%5/%6 prefetched), Fling suppressions: %7, Velocity: %8 px/s")
+        .arg(hitRate, 0, 'f', 1)
+        .arg(m_hits)
+        .arg(m_arrivals)
+        .arg(usefulRate, 0, 'f', 1)
+        .arg(m_usefulPrefetches)
+        .arg(m_prefetchCount)
+        .arg(m_suppressedCount)
+        .arg(velocity(), 0, 'f', 0);
+}
@@ -0,0 +1,99 @@
+#ifndef PREFETCHPLANNER_H
+#define PREFETCHPLANNER_H
+
+#include <QElapsedTimer>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 连续滚动模式的方向性预加载规划
+ *
+ * 根据滚动事件估算滚动速度与方向：
+ * - 静止时与原来一样，视口上下对称预加载
+ * - 滚动时把预加载集中到前方，距离和推测页数随速度增长，后方只保留少量边距
+ * - 快速滑动（fling）时页面会被直接跳过，暂停预加载，只渲染可见页面；
+ *   滚动停下后由调用方重新规划
+ *
+ * 同时统计预加载效果：页面进入视口时是否已有最终渲染（命中率），
+ * 以及预加载过的页面中有多少最终真正进入了视口。
+ *
+ * 只在 UI 线程使用。
+ */
+class PrefetchPlanner
+{
+public:
+    /**
+     * @brief 一次预加载规划
+     */
+    struct Plan {
+        int marginBefore = 0;       ///< 视口上方的预加载边距（像素）
+        int marginAfter = 0;        ///< 视口下方的预加载边距（像素）
+        int pagesBefore = 0;        ///< 预加载区域上方推测渲染的页数
+        int pagesAfter = 0;         ///< 预加载区域下方推测渲染的页数
+        bool suppressed = false;    ///< 快速滑动中，不预加载
+    };
+
+    /// 超过该时长没有滚动事件视为已停下（毫秒）
+    static constexpr int IDLE_MS = 150;
+
+    PrefetchPlanner();
+
+    /**
+     * @brief 记录一次滚动位置（onScrollValueChanged 中调用）
+     */
+    void recordScroll(int scrollY);
+
+    /**
+     * @brief 清除速度与页面记录（文档、缩放或布局变化后调用，统计保留）
+     */
+    void reset();
+
+    /**
+     * @brief 当前速度（像素/秒，向下为正），已停下时为 0
+     */
+    double velocity() const;
+
+    /**
+     * @brief 计算预加载规划
+     * @param viewportHeight 视口高度（像素）
+     * @param baseMargin 静止时的预加载边距（AppConfig::preloadMargin）
+     * @param basePages 静止时上下各推测渲染的页数
+     * @param averagePageHeight 平均页面高度（像素，含间距）
+     */
+    Plan plan(int viewportHeight, int baseMargin, int basePages, double averagePageHeight);
+
+    /**
+     * @brief 记录已提交的预加载页面（不含可见页面）
+     */
+    void recordPrefetch(const QVector<int>& pages);
+
+    /**
+     * @brief 记录当前可见页面，统计新进入视口的页面
+     * @param cachedPages 可见页面中已有最终渲染的页面
+     */
+    void recordVisible(const QSet<int>& visiblePages, const QSet<int>& cachedPages);
+
+    /**
+     * @brief 获取统计信息（调试用）
+     */
+    QString getStatistics() const;
+
+private:
+    QElapsedTimer m_clock;
+    qint64 m_lastSampleMs;          ///< 上次滚动事件的时间（-1 表示没有）
+    int m_lastScrollY;
+    double m_velocity;              ///< 平滑后的速度（像素/秒）
+
+    QSet<int> m_visible;            ///< 上次记录的可见页面
+    QSet<int> m_prefetched;         ///< 已预加载、尚未进入视口的页面
+
+    // 统计信息
+    qint64 m_arrivals;              ///< 新进入视口的页面数
+    qint64 m_hits;                  ///< 其中进入时已有最终渲染的页面数
+    qint64 m_prefetchCount;         ///< 提交的预加载页面数
+    qint64 m_usefulPrefetches;      ///< 其中后来进入视口的页面数
+    qint64 m_suppressedCount;       ///< 因快速滑动暂停预加载的次数
+};
+
+#endif // PREFETCHPLANNER_H
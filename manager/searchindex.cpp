@@ -0,0 +1,511 @@
+#include "searchindex.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <algorithm>
+
+namespace {
+
+constexpr quint32 FILE_MAGIC = 0x4D515349;     // "MQSI"
+constexpr quint32 FILE_VERSION = 2;     // 2: 按整页搜索文本分词（跨行）
+
+// 保留的索引文件数量（按最近更新时间）
+constexpr int MAX_INDEX_FILES = 100;
+
+// 组成拉丁等文字单词的字符（中日韩文字单独处理）
+bool isWordChar(QChar ch)
+{
+    return ch.isLetterOrNumber() && !PageTextData::isCJK(ch);
+}
+
+// 折叠大小写（逐字符，长度不变，与 Qt::CaseInsensitive 的比较方式一致）
+QString fold(QStringView text)
+{
+    QString result(text.size(), Qt::Uninitialized);
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        result[i] = text[i].toCaseFolded();
+    }
+    return result;
+}
+
+// 搜索文本的索引词：单词，以及中日韩文字的相邻两字（文本已折叠大小写）
+void collectTerms(QStringView text, QSet<QString>& terms)
+{
+    const qsizetype n = text.size();
+    qsizetype i = 0;
+
+    while (i < n) {
+        if (PageTextData::isCJK(text[i])) {
+            qsizetype j = i;
+            while (j < n && PageTextData::isCJK(text[j])) {
+                j++;
+            }
+            for (qsizetype k = i; k + 1 < j; ++k) {
+                terms.insert(text.mid(k, 2).toString());
+            }
+            i = j;
+        } else if (isWordChar(text[i])) {
+            qsizetype j = i;
+            while (j < n && isWordChar(text[j])) {
+                j++;
+            }
+            terms.insert(text.mid(i, j - i).toString());
+            i = j;
+        } else {
+            i++;
+        }
+    }
+}
+
+} // namespace
+
+SearchIndex::SearchIndex()
+    : m_pageCount(0)
+    , m_epoch(0)
+    , m_indexedCount(0)
+    , m_postingCount(0)
+    , m_dirty(false)
+    , m_loadedFromDisk(false)
+    , m_builtPages(0)
+    , m_builtChars(0)
+    , m_buildNs(0)
+    , m_fileBytes(0)
+    , m_queryCount(0)
+    , m_candidateTotal(0)
+{
+    m_directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/search";
+}
+
+SearchIndex::~SearchIndex()
+{
+    close();
+}
+
+void SearchIndex::open(const QString& fingerprint, int pageCount)
+{
+    close();
+
+    QMutexLocker locker(&m_mutex);
+
+    m_epoch++;
+    m_fingerprint = fingerprint;
+    m_pageCount = qMax(0, pageCount);
+    m_indexedPages = QBitArray(m_pageCount);
+
+    if (!m_fingerprint.isEmpty() && m_pageCount > 0) {
+        QElapsedTimer timer;
+        timer.start();
+
+        m_loadedFromDisk = loadLocked();
+        if (m_loadedFromDisk) {
+            qDebug() << "SearchIndex: Loaded" << m_indexedCount << "pages," << m_terms.size()
+                     << "terms in" << timer.elapsed() << "ms";
+        }
+    }
+}
+
+void SearchIndex::close()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_dirty && !m_fingerprint.isEmpty()) {
+        saveLocked();
+    }
+
+    m_epoch++;
+    m_fingerprint.clear();
+    m_pageCount = 0;
+    m_termIds.clear();
+    m_terms.clear();
+    m_postings.clear();
+    m_indexedPages.clear();
+    m_indexedCount = 0;
+    m_postingCount = 0;
+    m_dirty = false;
+    m_loadedFromDisk = false;
+    m_fileBytes = 0;
+}
+
+void SearchIndex::save()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_dirty && !m_fingerprint.isEmpty()) {
+        saveLocked();
+    }
+}
+
+int SearchIndex::epoch() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_epoch;
+}
+
+void SearchIndex::addPage(const PageTextData& data, int epoch)
+{
+    const int pageIndex = data.pageIndex;
+
+    if (isPageIndexed(pageIndex)) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 分词在锁外进行，多个提取线程可以同时建立索引
+    // 与搜索使用同一份文本，跨行的匹配也能由索引找到
+    QSet<QString> terms;
+    collectTerms(data.searchText(), terms);
+
+    QMutexLocker locker(&m_mutex);
+
+    if (epoch != m_epoch || pageIndex < 0 || pageIndex >= m_pageCount ||
+        m_indexedPages.testBit(pageIndex)) {
+        return;
+    }
+
+    for (const QString& term : terms) {
+        int id;
+        auto it = m_termIds.constFind(term);
+        if (it == m_termIds.constEnd()) {
+            id = m_terms.size();
+            m_termIds.insert(term, id);
+            m_terms.append(term);
+            m_postings.append(QVector<int>());
+        } else {
+            id = it.value();
+        }
+
+        // 提取任务的完成顺序不定，按页码插入保持升序
+        QVector<int>& postings = m_postings[id];
+        postings.insert(std::lower_bound(postings.begin(), postings.end(), pageIndex), pageIndex);
+    }
+
+    m_postingCount += terms.size();
+    m_indexedPages.setBit(pageIndex);
+    m_indexedCount++;
+    m_dirty = true;
+
+    m_builtPages++;
+    m_builtChars += data.charCount();
+    m_buildNs += timer.nsecsElapsed();
+}
+
+bool SearchIndex::isPageIndexed(int pageIndex) const
+{
+    QMutexLocker locker(&m_mutex);
+    return pageIndex >= 0 && pageIndex < m_pageCount && m_indexedPages.testBit(pageIndex);
+}
+
+int SearchIndex::indexedPageCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_indexedCount;
+}
+
+bool SearchIndex::isComplete() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pageCount > 0 && m_indexedCount == m_pageCount;
+}
+
+QVector<SearchIndex::QueryTerm> SearchIndex::parseQuery(const QString& query, bool wholeWords)
+{
+    QVector<QueryTerm> terms;
+    const QString text = fold(query);
+    const int n = text.size();
+    int i = 0;
+
+    while (i < n) {
+        if (PageTextData::isCJK(text[i])) {
+            int j = i;
+            while (j < n && PageTextData::isCJK(text[j])) {
+                j++;
+            }
+            // 单个汉字没有对应的索引词，不能用来缩小范围
+            for (int k = i; k + 1 < j; ++k) {
+                QueryTerm term;
+                term.text = text.mid(k, 2);
+                term.match = QueryTerm::Exact;
+                terms.append(term);
+            }
+            i = j;
+        } else if (isWordChar(text[i])) {
+            int j = i;
+            while (j < n && isWordChar(text[j])) {
+                j++;
+            }
+
+            // 查询内部的分隔符限定了词的边界；查询的首尾可能落在词中间
+            bool startBounded = wholeWords || i > 0;
+            bool endBounded = wholeWords || j < n;
+
+            QueryTerm term;
+            term.text = text.mid(i, j - i);
+            if (startBounded && endBounded) {
+                term.match = QueryTerm::Exact;
+            } else if (startBounded) {
+                term.match = QueryTerm::Prefix;
+            } else if (endBounded) {
+                term.match = QueryTerm::Suffix;
+            } else {
+                term.match = QueryTerm::Contains;
+            }
+            terms.append(term);
+            i = j;
+        } else {
+            i++;
+        }
+    }
+
+    // 整词查找最便宜，也最能缩小范围，先做
+    std::stable_sort(terms.begin(), terms.end(), [](const QueryTerm& a, const QueryTerm& b) {
+        return (a.match == QueryTerm::Exact) && (b.match != QueryTerm::Exact);
+    });
+
+    return terms;
+}
+
+bool SearchIndex::candidatePages(const QString& query, const SearchOptions& options,
+                                 QVector<int>* pages) const
+{
+    // 正则和模糊匹配无法由索引词推出候选页面
+    if (options.mode != SearchMode::Exact || !pages) {
+        return false;
+    }
+
+    QVector<QueryTerm> terms = parseQuery(query, options.wholeWords);
+    if (terms.isEmpty()) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_pageCount <= 0 || m_indexedCount == 0) {
+        return false;
+    }
+
+    QBitArray matched(m_pageCount, true);
+    for (const QueryTerm& term : terms) {
+        matched &= termPagesLocked(term);
+        if (matched.count(true) == 0) {
+            break;
+        }
+    }
+
+    // 尚未建立索引的页面无法排除
+    matched |= ~m_indexedPages;
+
+    pages->clear();
+    for (int i = 0; i < m_pageCount; ++i) {
+        if (matched.testBit(i)) {
+            pages->append(i);
+        }
+    }
+
+    m_queryCount++;
+    m_candidateTotal += pages->size();
+    return true;
+}
+
+QBitArray SearchIndex::termPagesLocked(const QueryTerm& term) const
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    QBitArray pages(m_pageCount);
+    auto addPostings = [&pages, this](int id) {
+        for (int pageIndex : m_postings[id]) {
+            pages.setBit(pageIndex);
+        }
+    };
+
+    if (term.match == QueryTerm::Exact) {
+        auto it = m_termIds.constFind(term.text);
+        if (it != m_termIds.constEnd()) {
+            addPostings(it.value());
+        }
+        return pages;
+    }
+
+    // 词的一部分：在词表中查找所有可能的完整词（词表远小于全文）
+    for (int id = 0; id < m_terms.size(); ++id) {
+        const QString& candidate = m_terms[id];
+        bool hit = false;
+        switch (term.match) {
+        case QueryTerm::Prefix:
+            hit = candidate.startsWith(term.text);
+            break;
+        case QueryTerm::Suffix:
+            hit = candidate.endsWith(term.text);
+            break;
+        default:
+            hit = candidate.contains(term.text);
+            break;
+        }
+        if (hit) {
+            addPostings(id);
+        }
+    }
+
+    return pages;
+}
+
+qint64 SearchIndex::memoryUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    // 每个索引词：字符串、哈希节点、倒排表头部；每个倒排项一个 int
+    qint64 bytes = m_indexedPages.size() / 8;
+    for (const QString& term : m_terms) {
+        bytes += qint64(sizeof(QString)) * 2 + term.size() * qint64(sizeof(QChar)) + 48;
+    }
+    bytes += m_postingCount * qint64(sizeof(int));
+    return bytes;
+}
+
+QString SearchIndex::getStatistics() const
+{
+    qint64 memory = memoryUsage();
+
+    QMutexLocker locker(&m_mutex);
+
+    const double mb = 1024.0 * 1024.0;
+    double seconds = m_buildNs / 1e9;
+    double pagesPerSecond = (seconds > 0) ? (m_builtPages / seconds) : 0;
+    double charsPerSecond = (seconds > 0) ? (m_builtChars / seconds) : 0;
+    double avgCandidates = (m_queryCount > 0 && m_pageCount > 0)
+        ? (m_candidateTotal * 100.0 / (m_queryCount * qint64(m_pageCount))) : 0;
+
+    return QString("SearchIndex: %1/%2 pages%3, %4 terms, %5 postings, %6 MB in memory, "
+                   "%7 MB on disk, Build: %8 pages/s, %9 M chars/s, "
+                   "Queries: %10, Avg candidates: %11% of pages")
+        .arg(m_indexedCount)
+        .arg(m_pageCount)
+        .arg(m_loadedFromDisk ? " (loaded from disk)" : "")
+        .arg(m_terms.size())
+        .arg(m_postingCount)
+        .arg(memory / mb, 0, 'f', 1)
+        .arg(m_fileBytes / mb, 0, 'f', 1)
+        .arg(pagesPerSecond, 0, 'f', 0)
+        .arg(charsPerSecond / 1e6, 0, 'f', 1)
+        .arg(m_queryCount)
+        .arg(avgCandidates, 0, 'f', 1);
+}
+
+QString SearchIndex::filePath() const
+{
+    // 文档指纹是十六进制字符串，可以直接用作文件名
+    return QString("%1/%2.idx").arg(m_directory, m_fingerprint);
+}
+
+bool SearchIndex::loadLocked()
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    QFile file(filePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 pageCount = 0;
+    qint32 termCount = 0;
+    QBitArray indexedPages;
+
+    in >> magic >> version >> pageCount >> indexedPages >> termCount;
+    if (in.status() != QDataStream::Ok || magic != FILE_MAGIC || version != FILE_VERSION ||
+        pageCount != m_pageCount || indexedPages.size() != m_pageCount || termCount < 0) {
+        qWarning() << "SearchIndex: Ignoring incompatible index file" << file.fileName();
+        return false;
+    }
+
+    QHash<QString, int> termIds;
+    QVector<QString> terms;
+    QVector<QVector<int>> postings;
+    qint64 postingCount = 0;
+    termIds.reserve(termCount);
+    terms.reserve(termCount);
+    postings.reserve(termCount);
+
+    for (qint32 id = 0; id < termCount; ++id) {
+        QString term;
+        QVector<int> pages;
+        in >> term >> pages;
+        if (in.status() != QDataStream::Ok) {
+            qWarning() << "SearchIndex: Index file is corrupt" << file.fileName();
+            return false;
+        }
+
+        termIds.insert(term, id);
+        terms.append(term);
+        postingCount += pages.size();
+        postings.append(pages);
+    }
+
+    m_termIds = std::move(termIds);
+    m_terms = std::move(terms);
+    m_postings = std::move(postings);
+    m_indexedPages = indexedPages;
+    m_indexedCount = int(indexedPages.count(true));
+    m_postingCount = postingCount;
+    m_fileBytes = file.size();
+    m_dirty = false;
+    return true;
+}
+
+void SearchIndex::saveLocked()
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QDir().mkpath(m_directory);
+
+    QSaveFile file(filePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "SearchIndex: Failed to save index:" << file.errorString();
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+
+    out << FILE_MAGIC << FILE_VERSION << qint32(m_pageCount) << m_indexedPages
+        << qint32(m_terms.size());
+    for (int id = 0; id < m_terms.size(); ++id) {
+        out << m_terms[id] << m_postings[id];
+    }
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "SearchIndex: Failed to save index:" << file.errorString();
+        return;
+    }
+
+    m_fileBytes = QFileInfo(filePath()).size();
+    m_dirty = false;
+
+    qDebug() << "SearchIndex: Saved" << m_indexedCount << "pages," << m_terms.size() << "terms,"
+             << m_fileBytes / 1024 << "KB in" << timer.elapsed() << "ms";
+
+    pruneFiles();
+}
+
+void SearchIndex::pruneFiles() const
+{
+    QFileInfoList files = QDir(m_directory).entryInfoList({"*.idx"}, QDir::Files, QDir::Time);
+    for (int i = MAX_INDEX_FILES; i < files.size(); ++i) {
+        QFile::remove(files[i].absoluteFilePath());
+    }
+}
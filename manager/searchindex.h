@@ -0,0 +1,146 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "datastructure.h"
+
+/**
+ * @brief 文档的倒排索引（索引词 -> 页面）
+ *
+ * 索引词取自页面的搜索文本（PageTextData::searchText()，已折叠大小写、可跨行）：
+ * 拉丁等文字按词，中日韩文字按相邻两字（bigram）。
+ * 搜索时先由索引得到可能包含匹配的页面，再只在这些页面上逐页验证，
+ * 不必每次查询都扫描全部页面。
+ *
+ * 查询是子串匹配，查询词两端不一定是完整的词：两侧被查询内部的分隔符
+ * 限定的词按整词查找，首尾的词按前缀/后缀/包含在词表中查找，取并集。
+ * 得到的页面集合总是实际匹配页面的超集；尚未建立索引的页面总是包含在内，
+ * 因此边建索引边搜索也不会漏掉结果。
+ *
+ * 索引由文本提取任务增量建立（线程安全），按文档指纹保存到用户缓存目录，
+ * 再次打开同一文档时直接加载。
+ */
+class SearchIndex
+{
+public:
+    SearchIndex();
+    ~SearchIndex();
+
+    /**
+     * @brief 关联文档：从磁盘加载已有索引，没有或不匹配时从空索引开始
+     * @param fingerprint 文档指纹（为空时只在内存中建立，不保存）
+     * @param pageCount 文档页数
+     */
+    void open(const QString& fingerprint, int pageCount);
+
+    /**
+     * @brief 保存（有新内容时）并清空
+     */
+    void close();
+
+    /**
+     * @brief 有新内容时写入磁盘
+     */
+    void save();
+
+    /**
+     * @brief 建立一页的索引（已建立过的页面直接跳过）
+     * @param epoch 调用方创建时记下的 epoch()，与当前不符时丢弃
+     */
+    void addPage(const PageTextData& data, int epoch);
+
+    /**
+     * @brief 当前关联的代次，每次 open()/close() 递增
+     *
+     * 提取任务在创建时记下代次，文档关闭后迟到的页面按代次丢弃，
+     * 不会混入下一个文档的索引
+     */
+    int epoch() const;
+
+    bool isPageIndexed(int pageIndex) const;
+    int indexedPageCount() const;
+    bool isComplete() const;
+
+    /**
+     * @brief 可能包含匹配的页面（升序，需要逐页验证）
+     * @param pages 输出：候选页面，包括所有尚未建立索引的页面
+     * @return 查询中没有可用的索引词（例如单个汉字）或不是精确匹配时返回 false，
+     *         需要搜索全部页面
+     */
+    bool candidatePages(const QString& query, const SearchOptions& options,
+                        QVector<int>* pages) const;
+
+    /**
+     * @brief 估算内存占用（字节）
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief 获取统计信息（索引大小与建立速度）
+     */
+    QString getStatistics() const;
+
+private:
+    /**
+     * @brief 查询词在词表中的匹配方式
+     */
+    struct QueryTerm {
+        enum Match {
+            Exact,      ///< 两端都被限定：整词
+            Prefix,     ///< 只有开头被限定
+            Suffix,     ///< 只有结尾被限定
+            Contains    ///< 两端都不限定
+        };
+
+        QString text;
+        Match match = Exact;
+    };
+
+    static QVector<QueryTerm> parseQuery(const QString& query, bool wholeWords);
+
+    /**
+     * @brief 包含查询词的页面（调用前必须已持有锁）
+     */
+    QBitArray termPagesLocked(const QueryTerm& term) const;
+
+    QString filePath() const;
+    bool loadLocked();
+    void saveLocked();
+
+    /**
+     * @brief 删除最久未使用的索引文件，保留最近的若干个
+     */
+    void pruneFiles() const;
+
+private:
+    mutable QMutex m_mutex;
+
+    QString m_directory;
+    QString m_fingerprint;
+    int m_pageCount;
+    int m_epoch;
+
+    QHash<QString, int> m_termIds;          ///< 索引词 -> 编号
+    QVector<QString> m_terms;               ///< 编号 -> 索引词
+    QVector<QVector<int>> m_postings;       ///< 编号 -> 升序页码
+    QBitArray m_indexedPages;               ///< 已建立索引的页面
+    int m_indexedCount;
+    qint64 m_postingCount;
+    bool m_dirty;
+
+    // 统计信息
+    bool m_loadedFromDisk;
+    qint64 m_builtPages;                    ///< 本次会话建立索引的页数
+    qint64 m_builtChars;                    ///< 其中的字符数
+    qint64 m_buildNs;                       ///< 建立索引的累计耗时（各线程之和）
+    qint64 m_fileBytes;                     ///< 最近一次加载或保存的文件大小
+    mutable qint64 m_queryCount;
+    mutable qint64 m_candidateTotal;        ///< 各次查询的候选页数之和
+};
+
+#endif // SEARCHINDEX_H
@@ -1,12 +1,159 @@
 #include "searchmanager.h"
 #include "perthreadmupdfrenderer.h"
+#include "rendererpool.h"
 #include "textcachemanager.h"
+#include "textscanner.h"
+#include <QBitArray>
 #include <QDebug>
+#include <QRegularExpressionMatchIterator>
 #include <QMutexLocker>
 #include <QThread>
-#include <QCoreApplication>
 #include <QMetaObject>
-#include <QTimer>
+#include <QRunnable>
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+// 没有匹配的页面累计到该数量才报告一次进度，避免每页一次跨线程调用
+constexpr int REPORT_INTERVAL_PAGES = 64;
+
+const char* modeName(SearchMode mode)
+{
+    switch (mode) {
+    case SearchMode::Regex:
+        return "regex";
+    case SearchMode::Fuzzy:
+        return "fuzzy";
+    default:
+        return "exact";
+    }
+}
+
+} // namespace
+
+/**
+ * @brief 一次搜索的共享状态，所有任务共用
+ */
+struct SearchJob {
+    int generation = 0;
+    SearchManager::CompiledQuery query;
+    SearchOptions options;
+    QString documentPath;
+    QVector<int> pages;                 ///< 搜索顺序
+    std::atomic_int cursor{0};          ///< 下一个待领取的位置
+    RenderCancelTokenPtr cancelToken;
+    TextCacheManager* textCache = nullptr;
+    SearchIndex* index = nullptr;       ///< 即时提取的页面顺便建立索引
+    int indexEpoch = 0;
+};
+
+// ----------------- SearchPageTask 实现 -----------------
+
+/**
+ * @brief 搜索任务：从共享游标领取页面直到领完或被取消
+ */
+class SearchPageTask : public QRunnable
+{
+public:
+    SearchPageTask(SearchManager* manager, std::shared_ptr<SearchJob> job)
+        : m_manager(manager)
+        , m_job(std::move(job))
+        , m_pendingPages(0)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        SearchJob& job = *m_job;
+
+        while (!job.cancelToken->isCancelled()) {
+            int next = job.cursor.fetch_add(1);
+            if (next >= job.pages.size()) {
+                break;
+            }
+
+            int pageIndex = job.pages[next];
+
+            // 已缓存的页面直接使用快照，否则即时提取
+            PageTextDataPtr text = job.textCache ? job.textCache->getPageTextData(pageIndex) : nullptr;
+            if (!text) {
+                text = extract(pageIndex);
+                if (text) {
+                    if (job.index) {
+                        job.index->addPage(*text, job.indexEpoch);
+                    }
+                    m_extracted.append(text);
+                }
+            }
+
+            if (job.cancelToken->isCancelled()) {
+                break;
+            }
+
+            if (text && !text->isEmpty()) {
+                m_pendingResults += SearchManager::searchPage(*text, job.query, job.options,
+                                                              job.options.maxResults);
+            }
+            m_pendingPages++;
+
+            if (!m_pendingResults.isEmpty() || m_pendingPages >= REPORT_INTERVAL_PAGES) {
+                report();
+            }
+        }
+
+        if (m_pendingPages > 0) {
+            report();
+        }
+    }
+
+private:
+    PageTextDataPtr extract(int pageIndex)
+    {
+        // 第一次遇到未缓存的页面时才借出渲染器，全部命中缓存时不打开文档
+        if (!m_renderer) {
+            m_renderer = RendererPool::instance().acquire(m_job->documentPath);
+            if (!m_renderer) {
+                qWarning() << "SearchPageTask: Failed to load document" << m_job->documentPath;
+                return nullptr;
+            }
+        }
+
+        auto pageData = std::make_shared<PageTextData>();
+        QString error;
+        if (!m_renderer->extractText(pageIndex, *pageData, &error, m_job->cancelToken.get())) {
+            if (!m_job->cancelToken->isCancelled()) {
+                qWarning() << "SearchPageTask: Failed to extract text from page" << pageIndex
+                           << "Error:" << error;
+            }
+            return nullptr;
+        }
+        return pageData;
+    }
+
+    void report()
+    {
+        QMetaObject::invokeMethod(m_manager, "handlePageResults",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(int, m_job->generation),
+                                  Q_ARG(int, m_pendingPages),
+                                  Q_ARG(QVector<SearchResult>, m_pendingResults),
+                                  Q_ARG(QVector<PageTextDataPtr>, m_extracted));
+        m_pendingPages = 0;
+        m_pendingResults.clear();
+        m_extracted.clear();
+    }
+
+    SearchManager* m_manager;
+    std::shared_ptr<SearchJob> m_job;
+    RendererPool::Lease m_renderer;
+
+    // 尚未报告的内容
+    int m_pendingPages;
+    QVector<SearchResult> m_pendingResults;
+    QVector<PageTextDataPtr> m_extracted;
+};
 
 // ----------------- SearchManager 实现 -----------------
 
@@ -17,26 +164,23 @@ SearchManager::SearchManager(PerThreadMuPDFRenderer* renderer,
     , m_renderer(renderer)
     , m_textCacheManager(textCacheManager)
     , m_currentMatchIndex(-1)
+    , m_startPage(0)
     , m_isSearching(false)
-    , m_cancelRequested(false)
-    , m_workerThread(nullptr)
-    , m_worker(nullptr)
+    , m_generation(0)
+    , m_totalPages(0)
+    , m_searchedPages(0)
+    , m_hasCompletedSearch(false)
 {
+    m_threadPool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+
+    qDebug() << "SearchManager: Text scanning uses" << TextScanner::instructionSet();
 }
 
 SearchManager::~SearchManager()
 {
-    // 请求取消并等待线程结束，确保析构时没有活动线程访问本对象
+    // 任务在下一页之前检查取消令牌，正在提取的页面由令牌中止，很快就会退出
     cancelSearch();
-
-    if (m_workerThread) {
-        // 等待一小段时间让线程优雅退出
-        if (!m_workerThread->wait(3000)) {
-            qWarning() << "Worker thread did not exit in time, forcing termination";
-            m_workerThread->terminate();
-            m_workerThread->wait();
-        }
-    }
+    m_threadPool.waitForDone();
 }
 
 void SearchManager::startSearch(const QString& query,
@@ -47,111 +191,128 @@ void SearchManager::startSearch(const QString& query,
         return;
     }
 
-    // 如果已有搜索在运行，先尝试取消并等待其结束（短超时）
-    if (isSearching()) {
-        cancelSearch();
-        if (m_workerThread) {
-            // 等待直到线程结束或超时（3秒）
-            if (!m_workerThread->wait(3000)) {
-                qWarning() << "Previous search did not stop in 3s; will force stop as last resort";
-                m_workerThread->terminate();
-                m_workerThread->wait();
-            }
-        }
+    // 取消正在进行的搜索，其任务自行退出，迟到的结果按代次丢弃
+    cancelSearch();
+
+    int pageCount = m_renderer->pageCount();
+    if (pageCount <= 0) {
+        return;
     }
 
-    {
-        QMutexLocker locker(&m_mutex);
-        m_currentQuery = query;
-        m_currentOptions = options;
-        m_results.clear();
-        m_currentMatchIndex = -1;
-        m_isSearching.store(true);
-        m_cancelRequested.store(false);
+    // 查询只编译一次（正则表达式在这里完成 JIT 编译），所有任务共用
+    auto job = std::make_shared<SearchJob>();
+    QString error;
+    if (!compileQuery(query, options, &job->query, &error)) {
+        qWarning() << "SearchManager: Invalid query" << query << error;
+        clearResults();
+        // 与正常搜索一样异步通知，调用方此时已进入搜索状态
+        QMetaObject::invokeMethod(this, [this, error]() {
+            emit searchError(error);
+        }, Qt::QueuedConnection);
+        return;
     }
 
     // 确定起始页
-    if (startPage < 0 || !m_renderer || startPage >= m_renderer->pageCount()) {
+    if (startPage < 0 || startPage >= pageCount) {
         startPage = 0;
     }
 
-    // 创建新的工作线程和 worker
-    QThread* thread = new QThread;
-    SearchWorker* worker = new SearchWorker(this, query, options, startPage);
-
-    // 记录 pointers（QPointer 方便后续检查）
-    m_workerThread = thread;
-    m_worker = worker;
-
-    // 把 worker 移到线程
-    worker->moveToThread(thread);
+    m_searchTimer.start();
 
-    // 连接：线程启动 => worker 处理
-    connect(thread, &QThread::started, worker, &SearchWorker::process);
+    const QString documentPath = m_renderer->documentPath();
+    QVector<int> pages = searchOrder(pageCount, startPage);
 
-    // 连接 worker 的信号到 manager（使用 QueuedConnection 确保线程间安全）
-    connect(worker, &SearchWorker::progress, this, &SearchManager::searchProgress, Qt::QueuedConnection);
-
-    // 当 worker 完成/取消/报错时，让线程退出（quit），以便触发线程的 finished 信号并清理。
-    connect(worker, &SearchWorker::finished, thread, &QThread::quit, Qt::QueuedConnection);
-    connect(worker, &SearchWorker::cancelled, thread, &QThread::quit, Qt::QueuedConnection);
-    connect(worker, &SearchWorker::error, thread, &QThread::quit, Qt::QueuedConnection);
+    {
+        QMutexLocker locker(&m_mutex);
 
-    // 当线程退出时，删除 worker（worker 在其线程上下文中 deleteLater）与删除 thread 对象
-    connect(thread, &QThread::finished, worker, &QObject::deleteLater);
-    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+        // 增量搜索：新查询包含上一次完整搜索的查询时，只有上一次有匹配的页面可能匹配
+        if (canRefineLocked(query, options, documentPath)) {
+            pages.erase(std::remove_if(pages.begin(), pages.end(),
+                                       [this](int pageIndex) {
+                                           return !m_pageResults.contains(pageIndex);
+                                       }),
+                        pages.end());
 
-    // 处理完成/取消/错误，更新状态并发射公开信号（在主线程）
-    connect(worker, &SearchWorker::finished, this, [this](const QString& q, int total) {
-        {
-            QMutexLocker locker(&m_mutex);
-            m_isSearching.store(false);
-            // m_worker / m_workerThread 将在 thread finished 时置空（见后面的连接）
+            qDebug() << "SearchManager: Refining" << m_completedQuery << "->" << query
+                     << "on" << pages.size() << "pages";
         }
-        emit searchCompleted(q, total);
-    }, Qt::QueuedConnection);
 
-    connect(worker, &SearchWorker::cancelled, this, [this]() {
-        {
-            QMutexLocker locker(&m_mutex);
-            m_isSearching.store(false);
-        }
-        emit searchCancelled();
-    }, Qt::QueuedConnection);
+        m_currentQuery = query;
+        m_currentOptions = options;
+        m_results.clear();
+        m_pageResults.clear();
+        m_currentMatchIndex = -1;
+        m_hasCompletedSearch = false;
+        m_isSearching.store(true);
+    }
 
-    connect(worker, &SearchWorker::error, this, [this](const QString& err) {
-        {
-            QMutexLocker locker(&m_mutex);
-            m_isSearching.store(false);
+    // 由索引排除不可能匹配的页面，只在候选页面上验证
+    SearchIndex* index = m_textCacheManager ? m_textCacheManager->searchIndex() : nullptr;
+    QVector<int> candidates;
+    if (index && index->candidatePages(query, options, &candidates)) {
+        QBitArray isCandidate(pageCount);
+        for (int pageIndex : candidates) {
+            if (pageIndex < pageCount) {
+                isCandidate.setBit(pageIndex);
+            }
         }
-        emit searchError(err);
-    }, Qt::QueuedConnection);
+        pages.erase(std::remove_if(pages.begin(), pages.end(),
+                                   [&isCandidate](int pageIndex) {
+                                       return !isCandidate.testBit(pageIndex);
+                                   }),
+                    pages.end());
+
+        qDebug() << "SearchManager: Index narrowed search to" << pages.size() << "of"
+                 << pageCount << "pages";
+    }
 
-    // 当线程真正 finished 时，清理 manager 内部的指针引用（在主线程执行）
-    connect(thread, &QThread::finished, this, [this, thread]() {
-        if (m_workerThread == thread) {
-            m_workerThread = nullptr;
-        }
-        // m_worker 会在 worker 的 deleteLater 执行后自动变为 nullptr（QPointer）
-        m_worker = nullptr;
-    }, Qt::QueuedConnection);
+    m_startPage = startPage;
+    m_totalPages = int(pages.size());
+    m_searchedPages = 0;
+    m_cancelToken = std::make_shared<RenderCancelToken>();
+
+    job->generation = ++m_generation;
+    job->options = options;
+    job->documentPath = documentPath;
+    job->pages = pages;
+    job->cancelToken = m_cancelToken;
+    job->textCache = m_textCacheManager;
+    job->index = index;
+    job->indexEpoch = index ? index->epoch() : 0;
+
+    if (pages.isEmpty()) {
+        // 没有候选页面：仍然异步完成，与正常搜索的信号顺序一致
+        QMetaObject::invokeMethod(this, "handlePageResults",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(int, job->generation),
+                                  Q_ARG(int, 0),
+                                  Q_ARG(QVector<SearchResult>, QVector<SearchResult>()),
+                                  Q_ARG(QVector<PageTextDataPtr>, QVector<PageTextDataPtr>()));
+        return;
+    }
 
-    // 启动线程
-    thread->start();
+    int taskCount = qMin(m_threadPool.maxThreadCount(), int(pages.size()));
+    for (int i = 0; i < taskCount; ++i) {
+        m_threadPool.start(new SearchPageTask(this, job));
+    }
+
+    qDebug() << "SearchManager: Searching" << pages.size() << "pages from page" << startPage
+             << "with" << taskCount << "tasks";
 }
 
 void SearchManager::cancelSearch()
 {
-    // 标记取消标志并请求 worker 执行取消
-    m_cancelRequested.store(true);
+    if (m_cancelToken) {
+        m_cancelToken->cancel();
+    }
 
-    // 如果 worker 存在，向 worker 请求取消（QueuedConnection 安全跨线程）
-    if (m_worker) {
-        QMetaObject::invokeMethod(m_worker, "requestCancel", Qt::QueuedConnection);
+    if (!m_isSearching.exchange(false)) {
+        return;
     }
 
-    // Additionally, process events to help wake up the event loop if needed
-    QCoreApplication::processEvents();
+    // 之后到达的结果都属于旧代次
+    ++m_generation;
+    emit searchCancelled();
 }
 
 bool SearchManager::isSearching() const
@@ -168,14 +329,7 @@ QVector<SearchResult> SearchManager::getAllResults() const
 QVector<SearchResult> SearchManager::getPageResults(int pageIndex) const
 {
     QMutexLocker locker(&m_mutex);
-
-    QVector<SearchResult> pageResults;
-    for (const SearchResult& result : m_results) {
-        if (result.pageIndex == pageIndex) {
-            pageResults.append(result);
-        }
-    }
-    return pageResults;
+    return m_pageResults.value(pageIndex);
 }
 
 int SearchManager::totalMatches() const
@@ -230,8 +384,10 @@ void SearchManager::clearResults()
 {
     QMutexLocker locker(&m_mutex);
     m_results.clear();
+    m_pageResults.clear();
     m_currentMatchIndex = -1;
     m_currentQuery.clear();
+    m_hasCompletedSearch = false;
 }
 
 void SearchManager::addToHistory(const QString& query)
@@ -273,116 +429,197 @@ void SearchManager::clearHistory()
 
 // ----------------- 从缓存的文本数据中搜索 -----------------
 
-QVector<SearchResult> SearchManager::searchPage(int pageIndex,
-                                                const QString& query,
-                                                const SearchOptions& options)
+bool SearchManager::compileQuery(const QString& query, const SearchOptions& options,
+                                 CompiledQuery* compiled, QString* error)
 {
-    QVector<SearchResult> results;
+    compiled->text = query;
 
-    if (!m_renderer || !m_renderer->isDocumentLoaded()) {
-        return results;
+    switch (options.mode) {
+    case SearchMode::Regex: {
+        QRegularExpression::PatternOptions patternOptions = QRegularExpression::UseUnicodePropertiesOption;
+        if (!options.caseSensitive) {
+            patternOptions |= QRegularExpression::CaseInsensitiveOption;
+        }
+        compiled->regex = QRegularExpression(query, patternOptions);
+        if (!compiled->regex.isValid()) {
+            *error = compiled->regex.errorString();
+            return false;
+        }
+        compiled->regex.optimize();
+        return true;
     }
+    case SearchMode::Fuzzy:
+        // 大小写敏感时在原文上匹配，否则在折叠后的搜索文本上匹配
+        compiled->fuzzy = FuzzyMatcher(options.caseSensitive
+                                           ? query
+                                           : PageTextData::normalizeForSearch(query),
+                                       options.maxEdits);
+        return compiled->fuzzy.isValid();
+    default:
+        compiled->normalized = PageTextData::normalizeForSearch(query);
+        return !compiled->normalized.isEmpty();
+    }
+}
 
-    // 从缓存获取文本数据
-    PageTextData textData = m_textCacheManager->getPageTextData(pageIndex);
+QVector<SearchResult> SearchManager::searchPage(const PageTextData& textData,
+                                                const CompiledQuery& query,
+                                                const SearchOptions& options,
+                                                int maxResults)
+{
+    QVector<SearchResult> results;
 
-    if (textData.isEmpty()) {
-        qDebug() << "searchPage: No text data cached for page" << pageIndex;
-        return results;
+    // 三种方式都在与 searchText() 逐位置对应的文本上查找，匹配可以跨行
+    auto accept = [&](QStringView text, int matchPos, int length) {
+        if (options.wholeWords && !isWholeWord(text, matchPos, length)) {
+            return;
+        }
+        const QVector<MatchSegment> segments = matchSegments(textData, matchPos, length);
+        if (!segments.isEmpty()) {
+            results.append(makeResult(textData, segments));
+        }
+    };
+
+    switch (options.mode) {
+    case SearchMode::Regex: {
+        const QString text = textData.joinedText();
+        QRegularExpressionMatchIterator it = query.regex.globalMatch(text);
+        while (it.hasNext() && results.size() < maxResults) {
+            QRegularExpressionMatch match = it.next();
+            if (match.capturedLength() > 0) {   // 跳过空匹配（例如 "a*"）
+                accept(text, int(match.capturedStart()), int(match.capturedLength()));
+            }
+        }
+        break;
     }
+    case SearchMode::Fuzzy: {
+        QString original;
+        QStringView text = textData.searchText();
+        if (options.caseSensitive) {
+            original = textData.joinedText();
+            text = original;
+        }
 
-    // 在缓存的文本数据中搜索
-    QString searchQuery = query;
-    if (!options.caseSensitive) {
-        searchQuery = searchQuery.toLower();
+        qsizetype from = 0;
+        qsizetype start = 0;
+        qsizetype length = 0;
+        while (results.size() < maxResults && query.fuzzy.findNext(text, from, &start, &length)) {
+            accept(text, int(start), int(length));
+            from = start + length;
+        }
+        break;
     }
+    default: {
+        // 在已折叠大小写的搜索文本上查找；大小写敏感时再按原文逐字符核对
+        const QStringView text = textData.searchText();
+        const int patternLength = query.normalized.length();
+
+        qsizetype pos = 0;
+        while (results.size() < maxResults &&
+               (pos = TextScanner::indexOf(text, query.normalized, pos)) != -1) {
+            const int matchPos = int(pos);
+            pos++;  // 继续查找下一个匹配
+
+            if (options.wholeWords && !isWholeWord(text, matchPos, patternLength)) {
+                continue;
+            }
 
-    // 遍历所有文本块
-    for (const TextBlock& block : textData.blocks) {
-        for (const TextLine& line : block.lines) {
-            // 构建当前行的文本
-            QString lineText;
-            QVector<TextChar> lineChars;
-
-            for (const TextChar& ch : line.chars) {
-                QString charStr = QString(ch.character);
-                if (!options.caseSensitive) {
-                    charStr = charStr.toLower();
-                }
-                lineText.append(charStr);
-                lineChars.append(ch);
+            const QVector<MatchSegment> segments = matchSegments(textData, matchPos, patternLength);
+            if (segments.isEmpty()) {
+                continue;
+            }
+            if (options.caseSensitive && !matchesCaseSensitive(textData, segments, query.text)) {
+                continue;
             }
 
-            // 在行文本中查找匹配
-            int pos = 0;
-            while ((pos = lineText.indexOf(searchQuery, pos)) != -1) {
-                // 如果要求全词匹配，检查边界
-                if (options.wholeWords) {
-                    bool validStart = (pos == 0 || !lineText[pos - 1].isLetterOrNumber());
-                    bool validEnd = (pos + searchQuery.length() >= lineText.length() ||
-                                     !lineText[pos + searchQuery.length()].isLetterOrNumber());
-
-                    if (!validStart || !validEnd) {
-                        pos++;
-                        continue;
-                    }
-                }
+            results.append(makeResult(textData, segments));
+        }
+        break;
+    }
+    }
 
-                SearchResult result(pageIndex);
+    return results;
+}
 
-                // 计算匹配文本的边界框
-                int endPos = pos + searchQuery.length();
-                if (endPos > lineChars.size()) {
-                    break;
-                }
+bool SearchManager::isWholeWord(QStringView text, int matchPos, int length)
+{
+    bool validStart = (matchPos == 0 || !text[matchPos - 1].isLetterOrNumber());
+    bool validEnd = (matchPos + length >= text.length() ||
+                     !text[matchPos + length].isLetterOrNumber());
+    return validStart && validEnd;
+}
 
-                // 合并匹配字符的边界框
-                QRectF matchRect;
-                for (int i = pos; i < endPos; ++i) {
-                    if (matchRect.isNull()) {
-                        matchRect = lineChars[i].bbox;
-                    } else {
-                        matchRect = matchRect.united(lineChars[i].bbox);
-                    }
-                }
+SearchResult SearchManager::makeResult(const PageTextData& textData,
+                                       const QVector<MatchSegment>& segments)
+{
+    SearchResult result(textData.pageIndex);
 
-                result.quads.append(matchRect);
-                result.context = getContextFromTextData(textData, block, line, pos, 30);
+    // 每行一个边界框
+    for (const MatchSegment& segment : segments) {
+        result.quads.append(textData.charRangeRect(segment.line, segment.firstChar,
+                                                   segment.lastChar));
+    }
+
+    const MatchSegment& first = segments.first();
+    result.context = getContextFromTextData(textData, first.line,
+                                            first.firstChar - textData.lineCharBegin(first.line),
+                                            30);
+    return result;
+}
 
-                results.append(result);
+QVector<SearchManager::MatchSegment> SearchManager::matchSegments(const PageTextData& textData,
+                                                                  int matchPos, int length)
+{
+    QVector<MatchSegment> segments;
+    const int matchEnd = matchPos + length;
+
+    for (int line = textData.searchLineAt(matchPos);
+         line < textData.lineCount() && textData.lineSearchBegin(line) < matchEnd; ++line) {
+        const int lineBegin = textData.lineSearchBegin(line);
+        const int first = qMax(matchPos, lineBegin);
+        const int last = qMin(matchEnd, lineBegin + textData.lineLength(line));
+        if (first >= last) {
+            continue;   // 只覆盖了行分隔符
+        }
 
-                pos++;  // 继续查找下一个匹配
+        MatchSegment segment;
+        segment.line = line;
+        segment.firstChar = textData.lineCharBegin(line) + (first - lineBegin);
+        segment.lastChar = segment.firstChar + (last - first) - 1;
+        segment.queryOffset = first - matchPos;
+        segments.append(segment);
+    }
 
-                if (results.size() >= options.maxResults) {
-                    // 直接返回，不再继续
-                    return results;
-                }
+    return segments;
+}
+
+bool SearchManager::matchesCaseSensitive(const PageTextData& textData,
+                                         const QVector<MatchSegment>& segments,
+                                         const QString& query)
+{
+    for (const MatchSegment& segment : segments) {
+        for (int c = segment.firstChar; c <= segment.lastChar; ++c) {
+            QChar original = textData.charAt(c);
+            QChar expected = query[segment.queryOffset + (c - segment.firstChar)];
+            // 搜索文本中空白已统一，这里同样不区分空白字符
+            if (original != expected && !(original.isSpace() && expected.isSpace())) {
+                return false;
             }
         }
     }
-
-    return results;
+    return true;
 }
 
 QString SearchManager::getContextFromTextData(const PageTextData& textData,
-                                              const TextBlock& currentBlock,
-                                              const TextLine& currentLine,
+                                              int line,
                                               int matchPos,
                                               int contextLength)
 {
-    Q_UNUSED(textData);
-    Q_UNUSED(currentBlock);
-
-    // 构建当前行的完整文本
-    QString lineText;
-    for (const TextChar& ch : currentLine.chars) {
-        lineText.append(ch.character);
-    }
+    QStringView lineText = textData.lineText(line);
 
     int start = qMax(0, matchPos - contextLength);
-    int end = qMin(lineText.length(), matchPos + contextLength);
+    int end = qMin(int(lineText.length()), matchPos + contextLength);
 
-    QString context = lineText.mid(start, end - start);
+    QString context = lineText.mid(start, end - start).toString();
 
     // 添加省略号
     if (start > 0) {
@@ -395,76 +632,140 @@ QString SearchManager::getContextFromTextData(const PageTextData& textData,
     return context;
 }
 
-// ----------------- SearchWorker 实现 -----------------
-
-SearchWorker::SearchWorker(SearchManager* manager,
-                           const QString& query,
-                           const SearchOptions& options,
-                           int startPage)
-    : QObject(nullptr)
-    , m_manager(manager)
-    , m_query(query)
-    , m_options(options)
-    , m_startPage(startPage)
-    , m_cancelRequested(false)
-{
-}
+// ----------------- 结果合并 -----------------
 
-void SearchWorker::requestCancel()
+QVector<int> SearchManager::searchOrder(int pageCount, int startPage)
 {
-    m_cancelRequested.store(true);
+    QVector<int> order;
+    order.reserve(pageCount);
+    order.append(startPage);
+
+    for (int distance = 1; order.size() < pageCount; ++distance) {
+        if (startPage + distance < pageCount) {
+            order.append(startPage + distance);
+        }
+        if (startPage - distance >= 0) {
+            order.append(startPage - distance);
+        }
+    }
+
+    return order;
 }
 
-void SearchWorker::process()
+void SearchManager::handlePageResults(int generation, int pagesSearched,
+                                      QVector<SearchResult> results,
+                                      QVector<PageTextDataPtr> extracted)
 {
-    if (!m_manager || !m_manager->m_renderer ||
-        !m_manager->m_renderer->isDocumentLoaded()) {
-        emit error("No document loaded");
+    if (generation != m_generation || !m_isSearching.load()) {
         return;
     }
 
-    qDebug() << "SearchWorker started - searching page:" << m_startPage;
+    // 即时提取的文本交给缓存，后续搜索和文本选择不必再提取
+    if (m_textCacheManager) {
+        for (const PageTextDataPtr& text : extracted) {
+            m_textCacheManager->addPageTextData(text->pageIndex, text);
+        }
+    }
+
+    m_searchedPages += pagesSearched;
 
-    int pageIndex = m_startPage;
-    int totalMatches = 0;
+    int matchCount = 0;
+    bool limitReached = false;
+    {
+        QMutexLocker locker(&m_mutex);
 
-    // 检查取消请求（快速检查）
-    if (m_cancelRequested.load() || (m_manager && m_manager->m_cancelRequested.load())) {
-        qDebug() << "SearchWorker: cancelled before start";
-        emit cancelled();
-        return;
+        // 各页完成的顺序不定，按页序插入，保证导航顺序与文档顺序一致
+        for (const SearchResult& result : results) {
+            if (m_results.size() >= m_currentOptions.maxResults) {
+                limitReached = true;
+                break;
+            }
+            auto pos = std::upper_bound(m_results.begin(), m_results.end(), result.pageIndex,
+                                        [](int page, const SearchResult& r) {
+                                            return page < r.pageIndex;
+                                        });
+            m_results.insert(pos, result);
+            m_pageResults[result.pageIndex].append(result);
+        }
+        matchCount = m_results.size();
     }
 
-    // 在工作线程中执行页面搜索（使用 manager 的 searchPage）
-    QVector<SearchResult> pageResults;
-    try {
-        pageResults = m_manager->searchPage(pageIndex, m_query, m_options);
-    } catch (...) {
-        emit error("Exception during searchPage");
-        return;
+    emit searchProgress(m_searchedPages, m_totalPages, matchCount);
+
+    if (limitReached || m_searchedPages >= m_totalPages) {
+        if (m_cancelToken) {
+            m_cancelToken->cancel();
+        }
+        finishSearch(!limitReached);
     }
+}
 
-    if (m_cancelRequested.load() || (m_manager && m_manager->m_cancelRequested.load())) {
-        qDebug() << "SearchWorker: cancelled after searchPage";
-        emit cancelled();
-        return;
+bool SearchManager::canRefineLocked(const QString& query, const SearchOptions& options,
+                                    const QString& documentPath) const
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    if (!m_hasCompletedSearch || m_completedDocument != documentPath) {
+        return false;
     }
 
-    if (!pageResults.isEmpty()) {
-        // 将结果追加到 manager（在追加时使用 manager 的 mutex 保护）
-        {
-            QMutexLocker locker(&m_manager->m_mutex);
-            for (const SearchResult& r : pageResults) {
-                m_manager->m_results.append(r);
-            }
-            totalMatches = pageResults.size();
+    // 只有精确子串匹配满足“包含关系”：正则和模糊匹配的结果不随查询单调缩小
+    const SearchOptions& previous = m_completedOptions;
+    if (previous.mode != SearchMode::Exact || options.mode != SearchMode::Exact) {
+        return false;
+    }
+
+    // 上一次是全词匹配时，更长查询的匹配不一定包含上一次的全词匹配
+    if (previous.wholeWords && query != m_completedQuery) {
+        return false;
+    }
+
+    // 大小写敏感的匹配一定也是不敏感的匹配，反之不成立
+    if (previous.caseSensitive) {
+        return options.caseSensitive && query.contains(m_completedQuery);
+    }
+    return PageTextData::normalizeForSearch(query).contains(
+        PageTextData::normalizeForSearch(m_completedQuery));
+}
+
+void SearchManager::finishSearch(bool complete)
+{
+    int total = 0;
+    QString query;
+    SearchMode mode = SearchMode::Exact;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // 下一次 nextMatch() 跳到起始页或其后的第一个匹配
+        auto first = std::lower_bound(m_results.begin(), m_results.end(), m_startPage,
+                                      [](const SearchResult& r, int page) {
+                                          return r.pageIndex < page;
+                                      });
+        int firstIndex = (first == m_results.end()) ? 0 : int(first - m_results.begin());
+        m_currentMatchIndex = firstIndex - 1;
+
+        total = m_results.size();
+        query = m_currentQuery;
+        mode = m_currentOptions.mode;
+
+        // 完整的搜索（所有页面都已搜索，没有因数量上限丢弃结果）可以作为下一次增量搜索的基础
+        m_hasCompletedSearch = complete;
+        if (complete) {
+            m_completedQuery = m_currentQuery;
+            m_completedOptions = m_currentOptions;
+            m_completedDocument = m_renderer ? m_renderer->documentPath() : QString();
         }
     }
 
-    // 发送进度（这里仅用于单页显示）
-    emit progress(1, 1, totalMatches);
+    m_isSearching.store(false);
+    ++m_generation;
 
-    qDebug() << "SearchWorker: Search completed on page" << pageIndex << ", matches:" << totalMatches;
+    // 吞吐量按匹配方式分别记录，便于比较精确、正则和模糊搜索的开销
+    const qint64 elapsed = m_searchTimer.elapsed();
+    const double pagesPerSecond = (elapsed > 0) ? (m_searchedPages * 1000.0 / elapsed) : 0.0;
+    qDebug() << "SearchManager: Search completed (" << modeName(mode) << "),"
+             << total << "matches in" << m_searchedPages << "pages," << elapsed << "ms,"
+             << qRound(pagesPerSecond) << "pages/s";
 
-    emit finished(m_query, totalMatches);
+    emit searchCompleted(query, total);
 }
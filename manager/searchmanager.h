@@ -6,12 +6,16 @@
 #include <QVector>
 #include <QRectF>
 #include <QMutex>
-#include <QThread>
-#include <QPointer>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRegularExpression>
 #include <QStringList>
 #include <atomic>
 
 #include "datastructure.h"
+#include "rendercanceltoken.h"
+#include "fuzzymatcher.h"
 
 extern "C" {
 #include <mupdf/fitz.h>
@@ -19,46 +23,31 @@ extern "C" {
 
 class PerThreadMuPDFRenderer;
 class TextCacheManager;
-class SearchManager;
-struct PageTextData;
-struct TextBlock;
-struct TextLine;
-struct TextChar;
-
-
-
-// ========== 搜索工作线程 ==========
-
-class SearchWorker : public QObject
-{
-    Q_OBJECT
-
-public:
-    SearchWorker(SearchManager* manager,
-                 const QString& query,
-                 const SearchOptions& options,
-                 int startPage);
-
-public slots:
-    void process();
-    void requestCancel();
-
-signals:
-    void progress(int currentPage, int totalPages, int matchCount);
-    void finished(const QString& query, int totalMatches);
-    void cancelled();
-    void error(const QString& errorMsg);
-
-private:
-    SearchManager* m_manager;
-    QString m_query;
-    SearchOptions m_options;
-    int m_startPage;
-    std::atomic_bool m_cancelRequested;
-};
+class SearchPageTask;
+struct SearchJob;
 
 // ========== 搜索管理器 ==========
 
+/**
+ * @brief 全文搜索
+ *
+ * 一次搜索覆盖整个文档：页面按与起始页的距离排序，线程池中的任务从
+ * 共享游标依次领取页面，起始页附近的页面最先完成。已缓存的页面直接在
+ * 文本快照上搜索，未缓存的页面在任务中即时提取，提取结果交回
+ * TextCacheManager 供后续搜索和文本选择使用。
+ *
+ * 匹配方式由 SearchOptions::mode 决定：精确子串、正则表达式（编译一次，
+ * 各任务共用）或近似匹配（编辑距离）。三种方式都在整页的搜索文本上进行，
+ * 得到的范围用同一种方式换算为边界框。
+ *
+ * 每页的匹配一到达就合并到结果中（按页序）并通过 searchProgress 通知界面。
+ * 结果同时按页索引，getPageResults() 不需要遍历全部结果。
+ *
+ * 边输入边搜索时，新查询包含上一次完整搜索的查询（精确匹配）时只重新搜索
+ * 上一次有匹配的页面。
+ * 取消通过取消令牌中止正在提取的页面，任务在下一页之前退出；
+ * 迟到的结果按搜索代次丢弃，不需要等待或强制结束线程。
+ */
 class SearchManager : public QObject
 {
     Q_OBJECT
@@ -101,38 +90,132 @@ signals:
     void searchCancelled();
     void searchError(const QString& error);
 
-private:
-    friend class SearchWorker;
-
-    // 搜索单页（从缓存的文本数据）
-    QVector<SearchResult> searchPage(int pageIndex,
-                                     const QString& query,
-                                     const SearchOptions& options);
+private slots:
+    /**
+     * @brief 合并任务报告的结果（由 SearchPageTask 通过 QMetaObject::invokeMethod 调用）
+     * @param generation 搜索代次，与当前搜索不符时丢弃
+     * @param pagesSearched 本次报告覆盖的页数
+     * @param results 这些页面上的匹配
+     * @param extracted 任务即时提取的页面文本
+     */
+    void handlePageResults(int generation, int pagesSearched,
+                           QVector<SearchResult> results,
+                           QVector<PageTextDataPtr> extracted);
 
-    // 辅助方法：从文本数据中提取上下文
-    QString getContextFromTextData(const PageTextData& textData,
-                                   const TextBlock& currentBlock,
-                                   const TextLine& currentLine,
-                                   int matchPos,
-                                   int contextLength);
+private:
+    friend class SearchPageTask;
+    friend struct SearchJob;
+
+    /**
+     * @brief 匹配落在某一行上的部分
+     */
+    struct MatchSegment {
+        int line = 0;           ///< 全局行号
+        int firstChar = 0;      ///< 全局字符号
+        int lastChar = 0;       ///< 全局字符号（含）
+        int queryOffset = 0;    ///< 对应查询中的位置
+    };
+
+    /**
+     * @brief 把搜索文本中的匹配 [matchPos, matchPos + length) 拆分到各行（跳过行分隔符）
+     */
+    static QVector<MatchSegment> matchSegments(const PageTextData& textData,
+                                               int matchPos, int length);
+
+    /**
+     * @brief 按原文逐字符核对大小写
+     */
+    static bool matchesCaseSensitive(const PageTextData& textData,
+                                     const QVector<MatchSegment>& segments,
+                                     const QString& query);
+
+    /**
+     * @brief 一次搜索编译好的查询，所有任务共用（只读）
+     */
+    struct CompiledQuery {
+        QString text;                   ///< 原始查询
+        QString normalized;             ///< 折叠大小写后的查询（精确匹配）
+        QRegularExpression regex;       ///< 正则表达式（已 JIT 编译）
+        FuzzyMatcher fuzzy;             ///< 近似匹配
+    };
+
+    /**
+     * @brief 按匹配方式编译查询
+     * @param error 输出：正则表达式无效时的错误信息
+     * @return 查询无效时返回 false
+     */
+    static bool compileQuery(const QString& query, const SearchOptions& options,
+                             CompiledQuery* compiled, QString* error);
+
+    // 在一页的文本快照中搜索（线程安全，最多返回 maxResults 个匹配）
+    static QVector<SearchResult> searchPage(const PageTextData& textData,
+                                            const CompiledQuery& query,
+                                            const SearchOptions& options,
+                                            int maxResults);
+
+    /**
+     * @brief 全词匹配：范围两侧不是字母或数字
+     */
+    static bool isWholeWord(QStringView text, int matchPos, int length);
+
+    /**
+     * @brief 由各行的匹配部分生成结果（每行一个边界框）
+     */
+    static SearchResult makeResult(const PageTextData& textData,
+                                   const QVector<MatchSegment>& segments);
+
+    // 辅助方法：从文本数据中提取上下文（line 为全局行号，matchPos 为行内位置）
+    static QString getContextFromTextData(const PageTextData& textData,
+                                          int line,
+                                          int matchPos,
+                                          int contextLength);
+
+    /**
+     * @brief 搜索顺序：起始页，然后向前后两侧交替扩展
+     */
+    static QVector<int> searchOrder(int pageCount, int startPage);
+
+    /**
+     * @brief 新查询能否在上一次完整搜索的结果页面上增量搜索（调用前必须已持有锁）
+     */
+    bool canRefineLocked(const QString& query, const SearchOptions& options,
+                         const QString& documentPath) const;
+
+    /**
+     * @brief 结束当前搜索，把导航位置放到起始页之前
+     * @param complete 所有页面都已搜索且没有达到数量上限
+     */
+    void finishSearch(bool complete);
 
     PerThreadMuPDFRenderer* m_renderer;
     TextCacheManager* m_textCacheManager;
 
     // 搜索结果
-    QVector<SearchResult> m_results;
+    QVector<SearchResult> m_results;                    ///< 按页序排列，用于导航
+    QHash<int, QVector<SearchResult>> m_pageResults;    ///< 页索引 -> 该页的匹配
     int m_currentMatchIndex;
 
     // 当前搜索
     QString m_currentQuery;
     SearchOptions m_currentOptions;
+    int m_startPage;
 
     // 搜索状态
     mutable QMutex m_mutex; // 保护 m_results, m_currentMatchIndex, m_searchHistory 等共享数据
     std::atomic_bool m_isSearching;
-    std::atomic_bool m_cancelRequested;
-    QPointer<QThread> m_workerThread;
-    QPointer<SearchWorker> m_worker; // 当前 worker（如果有）
+    int m_generation;                       ///< 搜索代次（只在主线程修改）
+    RenderCancelTokenPtr m_cancelToken;     ///< 当前搜索的取消令牌
+    int m_totalPages;                       ///< 当前搜索的页数（索引筛选后）
+    int m_searchedPages;                    ///< 已报告的页数
+    QElapsedTimer m_searchTimer;
+
+    // 上一次完整搜索（增量搜索的基础），其匹配页面即 m_pageResults 的键
+    bool m_hasCompletedSearch;
+    QString m_completedQuery;
+    SearchOptions m_completedOptions;
+    QString m_completedDocument;
+
+    QThreadPool m_threadPool;
 
     // 搜索历史
     QStringList m_searchHistory;
@@ -1,5 +1,6 @@
 #include "textcachemanager.h"
 #include "perthreadmupdfrenderer.h"
+#include "rendererpool.h"
 #include <QDebug>
 #include <QMutexLocker>
 #include <QCoreApplication>
@@ -17,11 +18,14 @@ class PageExtractTask : public QRunnable
 public:
     PageExtractTask(TextCacheManager* manager,
                     const QString& pdfPath,
-                    const QVector<int>& pageIndices)
+                    const QVector<int>& pageIndices,
+                    RenderCancelTokenPtr cancelToken,
+                    int indexEpoch)
         : m_manager(manager)
         , m_pdfPath(pdfPath)
         , m_pageIndices(pageIndices)
-        , m_renderer(nullptr)
+        , m_cancelToken(std::move(cancelToken))
+        , m_indexEpoch(indexEpoch)
     {
         setAutoDelete(true);
     }
@@ -40,16 +44,14 @@ public:
             return;
         }
 
-        // 创建独立的渲染器实例（线程安全）
-        // 一个 task 共享一个 renderer 实例，避免重复打开文档
-        qDebug() << "PageExtractTask: Creating renderer for batch, pages:" << m_pageIndices.size()
+        // 从渲染器池借出本线程的渲染器，同一线程上的后续批次直接复用
+        qDebug() << "PageExtractTask: Acquiring renderer for batch, pages:" << m_pageIndices.size()
                  << "first:" << m_pageIndices.first() << "last:" << m_pageIndices.last();
 
-        m_renderer = std::make_unique<PerThreadMuPDFRenderer>(m_pdfPath);
+        m_renderer = RendererPool::instance().acquire(m_pdfPath);
 
-        if (!m_renderer->isDocumentLoaded()) {
-            qWarning() << "PageExtractTask: Failed to load document, error:"
-                       << m_renderer->getLastError();
+        if (!m_renderer) {
+            qWarning() << "PageExtractTask: Failed to load document" << m_pdfPath;
             reportAllFailed();
             return;
         }
@@ -65,7 +67,7 @@ public:
             // 每页处理前都检查取消
             if (m_manager->m_cancelRequested.loadAcquire()) {
                 qDebug() << "PageExtractTask: Cancelled at page" << pageIndex;
-                reportDone(pageIndex, PageTextData(), false);
+                reportDone(pageIndex, nullptr, false);
                 failCount++;
                 continue;
             }
@@ -74,20 +76,28 @@ public:
             if (pageIndex < 0 || pageIndex >= totalPages) {
                 qWarning() << "PageExtractTask: Invalid page index" << pageIndex
                            << "total pages:" << totalPages;
-                reportDone(pageIndex, PageTextData(), false);
+                reportDone(pageIndex, nullptr, false);
                 failCount++;
                 continue;
             }
 
-            // 提取文本
-            PageTextData pageData;
+            // 提取文本（快照只在这里创建一次，之后以只读共享指针传递，不再复制）
+            auto pageData = std::make_shared<PageTextData>();
 
-            m_renderer->extractText(pageIndex, pageData);
+            // 渲染器会跨批次复用，使用本次调用的错误信息而不是 getLastError()
+            QString error;
+            bool hasError = !m_renderer->extractText(pageIndex, *pageData, &error,
+                                                     m_cancelToken.get());
+
+            if (hasError && m_cancelToken->isCancelled()) {
+                qDebug() << "PageExtractTask: Extraction aborted at page" << pageIndex;
+                reportDone(pageIndex, nullptr, false);
+                failCount++;
+                continue;
+            }
 
             // 区分空白页和真正的错误
-            QString error = m_renderer->getLastError();
-            bool hasError = !error.isEmpty();
-            bool isBlankPage = pageData.blocks.isEmpty() && !hasError;
+            bool isBlankPage = pageData->isEmpty() && !hasError;
             bool success = !hasError; // 只要没有错误就算成功（空白页也是成功）
 
             if (hasError) {
@@ -102,6 +112,11 @@ public:
                 successCount++;
             }
 
+            // 在提取线程中建立索引，不占用 UI 线程
+            if (success) {
+                m_manager->m_searchIndex.addPage(*pageData, m_indexEpoch);
+            }
+
             reportDone(pageIndex, pageData, success);
         }
 
@@ -112,26 +127,28 @@ public:
     }
 
 private:
-    void reportDone(int pageIndex, const PageTextData& data, bool ok)
+    void reportDone(int pageIndex, const PageTextDataPtr& data, bool ok)
     {
         QMetaObject::invokeMethod(m_manager, "handleTaskDone",
                                   Qt::QueuedConnection,
                                   Q_ARG(int, pageIndex),
-                                  Q_ARG(PageTextData, data),
+                                  Q_ARG(PageTextDataPtr, data),
                                   Q_ARG(bool, ok));
     }
 
     void reportAllFailed()
     {
         for (int pageIndex : m_pageIndices) {
-            reportDone(pageIndex, PageTextData(), false);
+            reportDone(pageIndex, nullptr, false);
         }
     }
 
     TextCacheManager* m_manager;
     QString m_pdfPath;
     QVector<int> m_pageIndices;
-    std::unique_ptr<PerThreadMuPDFRenderer> m_renderer;
+    RenderCancelTokenPtr m_cancelToken;
+    int m_indexEpoch;
+    RendererPool::Lease m_renderer;
 };
 
 // ========================================
@@ -140,12 +157,16 @@ private:
 TextCacheManager::TextCacheManager(PerThreadMuPDFRenderer* renderer, QObject* parent)
     : QObject(parent)
     , m_renderer(renderer)
+    , m_cacheBytes(0)
+    , m_cacheSearchBytes(0)
+    , m_cacheChars(0)
     , m_maxCacheSize(-1)
     , m_isPreloading(0)
     , m_cancelRequested(0)
     , m_preloadedPages(0)
     , m_hitCount(0)
     , m_missCount(0)
+    , m_cancelledExtractions(0)
 {
 }
 
@@ -196,6 +217,11 @@ void TextCacheManager::startPreload()
     m_isPreloading.storeRelease(1);
     m_cancelRequested.storeRelease(0);
     m_preloadedPages.storeRelease(0);
+
+    if (m_cancelToken) {
+        m_cancelledExtractions += m_cancelToken->cancelledCount();
+    }
+    m_cancelToken = std::make_shared<RenderCancelToken>();
     m_remainingTasks.storeRelease(pageCount);
 
     // 配置线程池（使用一半的CPU核心）
@@ -210,6 +236,12 @@ void TextCacheManager::startPreload()
              << "with" << threadCount << "threads"
              << "batch size:" << batchSize;
 
+    // 预先分配快照表，提取过程中不再扩容
+    {
+        QMutexLocker locker(&m_mutex);
+        ensureSlotsLocked(pageCount);
+    }
+
     // 收集需要处理的页面（跳过已缓存的）
     QVector<int> pagesToProcess;
     for (int i = 0; i < pageCount; ++i) {
@@ -234,7 +266,8 @@ void TextCacheManager::startPreload()
         }
 
         if (!batch.isEmpty()) {
-            PageExtractTask* task = new PageExtractTask(this, pdfPath, batch);
+            PageExtractTask* task = new PageExtractTask(this, pdfPath, batch, m_cancelToken,
+                                                         m_searchIndex.epoch());
             m_threadPool.start(task);
             ++tasksSubmitted;
         }
@@ -257,6 +290,11 @@ void TextCacheManager::cancelPreload()
     }
 
     m_cancelRequested.storeRelease(1);
+
+    // 正在提取的页面立即中止，不必等到下一页才检查取消
+    if (m_cancelToken) {
+        m_cancelToken->cancel();
+    }
     qDebug() << "TextCacheManager: Cancel requested";
 }
 
@@ -270,36 +308,124 @@ int TextCacheManager::computePreloadProgress() const
     return m_preloadedPages.loadAcquire();
 }
 
-PageTextData TextCacheManager::getPageTextData(int pageIndex)
+PageTextDataPtr TextCacheManager::getPageTextData(int pageIndex) const
 {
-    QMutexLocker locker(&m_mutex);
-    if (m_cache.contains(pageIndex)) {
-        ++m_hitCount;
-        return m_cache.value(pageIndex);
+    // 不加锁：先取当前快照表，再原子读取槽位
+    PageTextDataPtr data;
+    std::shared_ptr<SnapshotTable> table = std::atomic_load(&m_snapshots);
+    if (table && pageIndex >= 0 && pageIndex < int(table->pages.size())) {
+        data = std::atomic_load(&table->pages[pageIndex]);
     }
-    ++m_missCount;
-    return PageTextData();
+
+    if (data) {
+        m_hitCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_missCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    return data;
 }
 
-void TextCacheManager::addPageTextData(int pageIndex, const PageTextData& data)
+void TextCacheManager::addPageTextData(int pageIndex, const PageTextDataPtr& data)
 {
-    QMutexLocker locker(&m_mutex);
+    {
+        QMutexLocker locker(&m_mutex);
+        insertLocked(pageIndex, data);
+    }
+
+    // 其他途径提取的页面（例如搜索）同样建立索引
+    if (data) {
+        m_searchIndex.addPage(*data, m_searchIndex.epoch());
+    }
+}
+
+void TextCacheManager::setDocumentFingerprint(const QString& fingerprint)
+{
+    int pageCount = m_renderer ? m_renderer->pageCount() : 0;
+    m_searchIndex.open(fingerprint, pageCount);
+}
+
+void TextCacheManager::closeSearchIndex()
+{
+    // 仍在运行的提取任务代次已过期，不会再写入
+    m_searchIndex.close();
+}
+
+void TextCacheManager::insertLocked(int pageIndex, const PageTextDataPtr& data)
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    if (!data || pageIndex < 0) {
+        return;
+    }
+
+    auto existing = m_cache.find(pageIndex);
+    if (existing != m_cache.end()) {
+        removeLocked(existing);
+    }
 
     // 如果超过最大缓存大小，移除最旧的条目
     if (m_maxCacheSize > 0 && m_cache.size() >= m_maxCacheSize) {
         if (!m_cache.isEmpty()) {
-            auto it = m_cache.begin();
-            m_cache.erase(it);
+            removeLocked(m_cache.begin());
         }
     }
 
     m_cache.insert(pageIndex, data);
+    m_cacheBytes += data->memoryUsage();
+    m_cacheSearchBytes += data->searchMemoryUsage();
+    m_cacheChars += data->charCount();
+    publishLocked(pageIndex, data);
+}
+
+void TextCacheManager::removeLocked(QHash<int, PageTextDataPtr>::iterator it)
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    publishLocked(it.key(), nullptr);
+    m_cacheBytes -= it.value()->memoryUsage();
+    m_cacheSearchBytes -= it.value()->searchMemoryUsage();
+    m_cacheChars -= it.value()->charCount();
+    m_cache.erase(it);
+}
+
+void TextCacheManager::publishLocked(int pageIndex, const PageTextDataPtr& data)
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    if (!m_snapshots || pageIndex >= int(m_snapshots->pages.size())) {
+        if (!data) {
+            return;
+        }
+        ensureSlotsLocked(qMax(pageIndex + 1, m_snapshots ? int(m_snapshots->pages.size()) * 2 : 0));
+    }
+
+    std::atomic_store(&m_snapshots->pages[pageIndex], data);
+}
+
+void TextCacheManager::ensureSlotsLocked(int pageCount)
+{
+    // 注意：调用此方法前必须已经获取互斥锁
+
+    const int oldCount = m_snapshots ? int(m_snapshots->pages.size()) : 0;
+    if (pageCount <= oldCount) {
+        return;
+    }
+
+    // 复制到新表后整体发布，正在读取旧表的线程不受影响
+    auto table = std::make_shared<SnapshotTable>();
+    table->pages.resize(pageCount);
+    for (int i = 0; i < oldCount; ++i) {
+        table->pages[i] = std::atomic_load(&m_snapshots->pages[i]);
+    }
+
+    std::atomic_store(&m_snapshots, table);
 }
 
 bool TextCacheManager::contains(int pageIndex) const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_cache.contains(pageIndex);
+    std::shared_ptr<SnapshotTable> table = std::atomic_load(&m_snapshots);
+    return table && pageIndex >= 0 && pageIndex < int(table->pages.size())
+        && std::atomic_load(&table->pages[pageIndex]) != nullptr;
 }
 
 void TextCacheManager::clear()
@@ -311,8 +437,14 @@ void TextCacheManager::clear()
     }
 
     m_cache.clear();
+    m_cacheBytes = 0;
+    m_cacheSearchBytes = 0;
+    m_cacheChars = 0;
     m_hitCount = 0;
     m_missCount = 0;
+
+    // 已取出的快照由持有者继续使用，读取端之后只会看到空表
+    std::atomic_store(&m_snapshots, std::shared_ptr<SnapshotTable>());
 }
 
 void TextCacheManager::setMaxCacheSize(int maxPages)
@@ -327,36 +459,62 @@ int TextCacheManager::cacheSize() const
     return m_cache.size();
 }
 
+qint64 TextCacheManager::memoryUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cacheBytes;
+}
+
+qint64 TextCacheManager::releaseMemory(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const qint64 before = m_cacheBytes;
+    while (before - m_cacheBytes < bytes && !m_cache.isEmpty()) {
+        removeLocked(m_cache.begin());
+    }
+
+    return before - m_cacheBytes;
+}
+
 QString TextCacheManager::getStatistics() const
 {
     QMutexLocker locker(&m_mutex);
-    qint64 total = m_hitCount + m_missCount;
-    double hitRate = (total > 0) ? (m_hitCount * 100.0 / total) : 0.0;
+    const qint64 hits = m_hitCount.load();
+    const qint64 misses = m_missCount.load();
+    qint64 total = hits + misses;
+    double hitRate = (total > 0) ? (hits * 100.0 / total) : 0.0;
+
+    int cancelled = m_cancelledExtractions + (m_cancelToken ? m_cancelToken->cancelledCount() : 0);
 
-    return QString("TextCache: %1 pages, Hit Rate: %2%, Hits: %3, Misses: %4")
+    // 每字符字节数包含搜索文本副本（约 2 字节/字符）和每行的开销
+    double bytesPerChar = (m_cacheChars > 0) ? double(m_cacheBytes) / m_cacheChars : 0.0;
+
+    return QString("TextCache: %1 pages (%2 MB, search text %3 MB), %4 chars, %5 B/char, "
+                   "Hit Rate: %6%, Hits: %7, Misses: %8, Cancelled: %9\n%10")
         .arg(m_cache.size())
+        .arg(m_cacheBytes / (1024.0 * 1024.0), 0, 'f', 2)
+        .arg(m_cacheSearchBytes / (1024.0 * 1024.0), 0, 'f', 2)
+        .arg(m_cacheChars)
+        .arg(bytesPerChar, 0, 'f', 1)
         .arg(hitRate, 0, 'f', 1)
-        .arg(m_hitCount)
-        .arg(m_missCount);
+        .arg(hits)
+        .arg(misses)
+        .arg(cancelled)
+        .arg(m_searchIndex.getStatistics());
 }
 
-void TextCacheManager::handleTaskDone(int pageIndex, PageTextData pageData, bool ok)
+void TextCacheManager::handleTaskDone(int pageIndex, PageTextDataPtr pageData, bool ok)
 {
     // 无论成功与否，都要递减剩余任务计数
     int remaining = m_remainingTasks.fetchAndSubRelaxed(1) - 1;
     Q_UNUSED(remaining);
 
-    if (ok) {
+    if (ok && pageData) {
         // 成功提取，写入缓存
         {
             QMutexLocker locker(&m_mutex);
-            if (m_maxCacheSize > 0 && m_cache.size() >= m_maxCacheSize) {
-                if (!m_cache.isEmpty()) {
-                    auto it = m_cache.begin();
-                    m_cache.erase(it);
-                }
-            }
-            m_cache.insert(pageIndex, pageData);
+            insertLocked(pageIndex, pageData);
         }
 
         m_preloadedPages.ref();
@@ -376,6 +534,8 @@ void TextCacheManager::handleTaskDone(int pageIndex, PageTextData pageData, bool
         } else {
             m_isPreloading.storeRelease(0);
             qDebug() << "TextCacheManager: Preload completed";
+            qDebug().noquote() << m_searchIndex.getStatistics();
+            m_searchIndex.save();
             emit preloadCompleted();
         }
     }
@@ -7,8 +7,13 @@
 #include <QString>
 #include <QAtomicInt>
 #include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 #include "datastructure.h"
+#include "rendercanceltoken.h"
+#include "searchindex.h"
 
 class PerThreadMuPDFRenderer;
 class PageExtractTask;
@@ -18,6 +23,14 @@ class PageExtractTask;
  *
  * 负责管理页面文本数据的缓存和异步预加载
  * 不直接接触 MuPDF API，所有渲染工作委托给 PerThreadMuPDFRenderer
+ *
+ * 缓存的是只读快照（PageTextDataPtr），由提取任务创建一次后共享。
+ * 读取（getPageTextData / contains）不加锁：写入端在持有互斥锁时
+ * 原子地替换快照表中的槽位，读取端原子地取出槽位，返回的快照在
+ * 被淘汰后仍然有效。
+ *
+ * 提取任务同时建立文档的搜索索引（SearchIndex），索引按文档指纹保存，
+ * 不受缓存淘汰影响。
  */
 class TextCacheManager : public QObject
 {
@@ -34,15 +47,42 @@ public:
     int computePreloadProgress() const;
 
     // 缓存访问
-    PageTextData getPageTextData(int pageIndex);
-    void addPageTextData(int pageIndex, const PageTextData& data);
+    /**
+     * @brief 获取页面文本快照（不加锁）
+     * @return 未缓存时返回空指针
+     */
+    PageTextDataPtr getPageTextData(int pageIndex) const;
+    void addPageTextData(int pageIndex, const PageTextDataPtr& data);
     bool contains(int pageIndex) const;
 
+    // 搜索索引
+    /**
+     * @brief 关联文档指纹，加载已保存的搜索索引（文档加载完成后、预加载前调用）
+     */
+    void setDocumentFingerprint(const QString& fingerprint);
+
+    /**
+     * @brief 保存并关闭搜索索引（关闭文档时调用；clear() 只清空文本缓存，不影响索引）
+     */
+    void closeSearchIndex();
+    SearchIndex* searchIndex() { return &m_searchIndex; }
+
     // 缓存管理
     void clear();
     void setMaxCacheSize(int maxPages);
     int cacheSize() const;
 
+    /**
+     * @brief 估算缓存占用的内存（字节）
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief 移除缓存页面直到释放至少 bytes 字节（文本可重新提取）
+     * @return 实际释放的字节数（估算值）
+     */
+    qint64 releaseMemory(qint64 bytes);
+
     // 统计信息
     QString getStatistics() const;
 
@@ -54,16 +94,51 @@ signals:
 
 private slots:
     // 由 PageExtractTask 通过 QMetaObject::invokeMethod 调用
-    void handleTaskDone(int pageIndex, PageTextData pageData, bool ok);
+    void handleTaskDone(int pageIndex, PageTextDataPtr pageData, bool ok);
 
 private:
     friend class PageExtractTask;
 
+    /**
+     * @brief 写入缓存，超过页数上限时移除一个条目（调用前必须已持有锁）
+     */
+    void insertLocked(int pageIndex, const PageTextDataPtr& data);
+
+    /**
+     * @brief 移除条目并扣除其内存（调用前必须已持有锁）
+     */
+    void removeLocked(QHash<int, PageTextDataPtr>::iterator it);
+
+    /**
+     * @brief 把快照发布到读取端的槽位，data 为空表示移除（调用前必须已持有锁）
+     */
+    void publishLocked(int pageIndex, const PageTextDataPtr& data);
+
+    /**
+     * @brief 确保快照表至少有 pageCount 个槽位（调用前必须已持有锁）
+     */
+    void ensureSlotsLocked(int pageCount);
+
+    /**
+     * @brief 读取端的快照表，下标为页索引
+     *
+     * 表本身和其中的槽位都通过 std::atomic_load / std::atomic_store 访问。
+     * 扩容时复制到新表后整体替换，仍持有旧表的读取端不受影响。
+     */
+    struct SnapshotTable {
+        std::vector<PageTextDataPtr> pages;
+    };
+
     PerThreadMuPDFRenderer* m_renderer;
 
-    // 缓存（页索引 -> PageTextData）
-    QHash<int, PageTextData> m_cache;
+    // 缓存（页索引 -> 快照），写入端的簿记，受 m_mutex 保护
+    QHash<int, PageTextDataPtr> m_cache;
     mutable QMutex m_mutex;
+    qint64 m_cacheBytes;                    ///< 缓存的估算内存占用
+    qint64 m_cacheSearchBytes;              ///< 其中搜索文本的占用
+    qint64 m_cacheChars;                    ///< 缓存的字符总数
+
+    std::shared_ptr<SnapshotTable> m_snapshots;
 
     // 缓存限制（-1 表示无限制）
     int m_maxCacheSize;
@@ -71,15 +146,20 @@ private:
     // 预加载状态（原子）
     QAtomicInt m_isPreloading;
     QAtomicInt m_cancelRequested;
+    RenderCancelTokenPtr m_cancelToken;     // 本次预加载的取消令牌，中止正在提取的页面
     QAtomicInt m_preloadedPages;
     QAtomicInt m_remainingTasks;
 
     // 线程池
     QThreadPool m_threadPool;
 
+    // 搜索索引（自带锁，提取线程直接写入）
+    SearchIndex m_searchIndex;
+
     // 统计信息
-    qint64 m_hitCount;
-    qint64 m_missCount;
+    mutable std::atomic<qint64> m_hitCount;
+    mutable std::atomic<qint64> m_missCount;
+    int m_cancelledExtractions;             // 已结束的预加载中被中止的提取次数
 };
 
 #endif // TEXTCACHEMANAGER_H
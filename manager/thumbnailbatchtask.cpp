@@ -1,5 +1,6 @@
 #include "thumbnailbatchtask.h"
 #include "perthreadmupdfrenderer.h"
+#include "rendererpool.h"
 #include "thumbnailcache.h"
 #include "thumbnailmanagerv2.h"
 #include <QElapsedTimer>
@@ -13,8 +14,9 @@ ThumbnailBatchTask::ThumbnailBatchTask(const QString& docPath,
                                        int thumbnailWidth,
                                        int rotation,
                                        double devicePixelRatio,
+                                       RenderCancelTokenPtr cancelToken,
                                        FinishCallback cb)
-    : m_renderer(std::make_unique<PerThreadMuPDFRenderer>(docPath))
+    : m_docPath(docPath)
     , m_cache(cache)
     , m_manager(manager)
     , m_pageIndices(pageIndices)
@@ -22,7 +24,7 @@ ThumbnailBatchTask::ThumbnailBatchTask(const QString& docPath,
     , m_thumbnailWidth(thumbnailWidth)
     , m_rotation(rotation)
     , m_devicePixelRatio(devicePixelRatio)
-    , m_aborted(0)
+    , m_cancelToken(cancelToken ? std::move(cancelToken) : std::make_shared<RenderCancelToken>())
     , m_finishCallback(cb)
 {
     setAutoDelete(true);
@@ -34,8 +36,15 @@ ThumbnailBatchTask::~ThumbnailBatchTask()
 
 void ThumbnailBatchTask::run()
 {
-    if (!m_renderer || !m_cache || !m_manager) {
-        qWarning() << "ThumbnailBatchTask: Invalid renderer, cache or manager";
+    if (!m_cache || !m_manager) {
+        qWarning() << "ThumbnailBatchTask: Invalid cache or manager";
+        return;
+    }
+
+    // 在工作线程上借出渲染器，同一线程上的后续批次直接复用
+    RendererPool::Lease renderer = RendererPool::instance().acquire(m_docPath);
+    if (!renderer) {
+        qWarning() << "ThumbnailBatchTask: Failed to acquire renderer for" << m_docPath;
         return;
     }
 
@@ -73,7 +82,7 @@ void ThumbnailBatchTask::run()
         }
 
         // 计算缩放比例（使用高DPI渲染宽度）
-        QSizeF pageSize = m_renderer->pageSize(pageIndex);
+        QSizeF pageSize = renderer->pageSize(pageIndex);
         if (pageSize.isEmpty()) {
             qWarning() << "ThumbnailBatchTask: Invalid page size for page" << pageIndex;
             continue;
@@ -82,7 +91,12 @@ void ThumbnailBatchTask::run()
         double zoom = m_thumbnailWidth / pageSize.width();
 
         // 渲染页面
-        RenderResult thumbnailRes = m_renderer->renderPage(pageIndex, zoom, m_rotation);
+        RenderResult thumbnailRes = renderer->renderPage(pageIndex, zoom, m_rotation,
+                                                         m_cancelToken.get());
+        if (thumbnailRes.cancelled) {
+            qDebug() << "ThumbnailBatchTask: Render of page" << pageIndex << "aborted";
+            break;
+        }
 
         QImage thumbnail = thumbnailRes.image;
 
@@ -123,12 +137,12 @@ void ThumbnailBatchTask::run()
 
 void ThumbnailBatchTask::abort()
 {
-    m_aborted.storeRelaxed(1);
+    m_cancelToken->cancel();
 }
 
 bool ThumbnailBatchTask::isAborted() const
 {
-    return m_aborted.loadRelaxed() != 0;
+    return m_cancelToken->isCancelled();
 }
 
 int ThumbnailBatchTask::getTimeBudget() const
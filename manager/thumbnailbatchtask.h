@@ -6,6 +6,7 @@
 #include <QAtomicInt>
 #include <QImage>
 #include <QPointer>
+#include "rendercanceltoken.h"
 
 class PerThreadMuPDFRenderer;
 class ThumbnailCache;
@@ -37,11 +38,18 @@ public:
                        int thumbnailWidth,        // 实际渲染宽度（已乘以DPR）
                        int rotation,
                        double devicePixelRatio,   // 设备像素比
+                       RenderCancelTokenPtr cancelToken,
                        FinishCallback cb);
 
     ~ThumbnailBatchTask();
 
     void run() override;
+
+    /**
+     * @brief 中止任务，正在渲染的页面立即停止
+     *
+     * 令牌由同一批提交的任务共享，中止会作用于共享该令牌的所有任务
+     */
     void abort();
     bool isAborted() const;
 
@@ -49,7 +57,7 @@ private:
     int getTimeBudget() const;
     int getBatchLimit() const;
 
-    std::unique_ptr<PerThreadMuPDFRenderer> m_renderer;
+    QString m_docPath;
     ThumbnailCache* m_cache;
     ThumbnailManagerV2* m_manager;
     QVector<int> m_pageIndices;
@@ -57,7 +65,7 @@ private:
     int m_thumbnailWidth;        // 实际渲染宽度
     int m_rotation;
     double m_devicePixelRatio;   // 设备像素比
-    QAtomicInt m_aborted;
+    RenderCancelTokenPtr m_cancelToken;
 
     FinishCallback m_finishCallback;
 };
@@ -17,6 +17,7 @@ ThumbnailManagerV2::ThumbnailManagerV2(PerThreadMuPDFRenderer* renderer, QObject
     , m_runningTasks(0)
     , m_isLoadingInProgress(false)
     , m_devicePixelRatio(1.0)
+    , m_cancelToken(std::make_shared<RenderCancelToken>())
 {
     int threadCount = qMax(4, QThread::idealThreadCount() / 3);
     m_threadPool->setMaxThreadCount(threadCount);
@@ -73,6 +74,11 @@ int ThumbnailManagerV2::cachedCount() const
     return m_cache->count();
 }
 
+qint64 ThumbnailManagerV2::memoryUsage() const
+{
+    return m_cache->memoryUsage();
+}
+
 void ThumbnailManagerV2::startLoading(const QSet<int>& initialVisible)
 {
     if (!m_renderer || !m_renderer->isDocumentLoaded()) {
@@ -193,11 +199,17 @@ void ThumbnailManagerV2::cancelAllTasks()
     m_nextBatchIndex = 0;
     m_runningTasks = 0;
 
+    // 正在渲染的页面立即中止，waitForDone() 不必等整批渲染完
+    m_cancelToken->cancel();
+
     // 等待所有任务完成（自动删除）
     if (m_threadPool) {
         m_threadPool->clear();        // 清除还没开始的任务
         m_threadPool->waitForDone();  // 等待所有正在运行的任务完成
     }
+
+    m_cancelledRenders += m_cancelToken->cancelledCount();
+    m_cancelToken = std::make_shared<RenderCancelToken>();
 }
 
 void ThumbnailManagerV2::clear()
@@ -216,7 +228,9 @@ void ThumbnailManagerV2::clear()
 
 QString ThumbnailManagerV2::getStatistics() const
 {
-    return m_cache->getStatistics();
+    return m_cache->getStatistics() +
+           QString(", Cancelled renders: %1")
+               .arg(m_cancelledRenders + m_cancelToken->cancelledCount());
 }
 
 bool ThumbnailManagerV2::shouldRespondToScroll() const
@@ -326,6 +340,7 @@ void ThumbnailManagerV2::renderPagesAsync(const QVector<int>& pages, RenderPrior
         getRenderWidth(),  // 使用高DPI渲染宽度
         m_rotation,
         m_devicePixelRatio,  // 传递设备像素比
+        m_cancelToken,
         nullptr);
 
     m_threadPool->start(task, static_cast<int>(priority));
@@ -378,6 +393,7 @@ void ThumbnailManagerV2::processNextBatch()
         getRenderWidth(),
         m_rotation,
         m_devicePixelRatio,
+        m_cancelToken,
         callback
         );
 
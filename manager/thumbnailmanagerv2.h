@@ -71,6 +71,7 @@ public:
     void clear();
     QString getStatistics() const;
     int cachedCount() const;
+    qint64 memoryUsage() const;
 
     /**
      * @brief 是否应该响应滚动事件
@@ -127,6 +128,10 @@ private:
     // 任务跟踪（仅中文档使用）
     QMutex m_taskMutex;
 
+    // 已提交任务共享的取消令牌，cancelAllTasks() 时中止并换新
+    RenderCancelTokenPtr m_cancelToken;
+    int m_cancelledRenders = 0;     // 已换下的令牌累计中止的渲染次数
+
     bool m_isLoadingInProgress;
 };
 
@@ -23,7 +23,12 @@ void ThumbnailCache::set(int pageIndex, const QImage& thumbnail)
     }
 
     QWriteLocker locker(&m_lock);
+    auto it = m_cache.find(pageIndex);
+    if (it != m_cache.end()) {
+        m_bytes -= it.value().sizeInBytes();
+    }
     m_cache[pageIndex] = thumbnail;
+    m_bytes += thumbnail.sizeInBytes();
 }
 
 bool ThumbnailCache::has(int pageIndex) const
@@ -36,18 +41,16 @@ void ThumbnailCache::clear()
 {
     QWriteLocker locker(&m_lock);
     m_cache.clear();
+    m_bytes = 0;
 }
 
 QString ThumbnailCache::getStatistics() const
 {
-    int cachedCount = count();
-
-    // 估算内存占用（平均 50KB/页）
-    qint64 memoryKB = cachedCount * 50;
+    QReadLocker locker(&m_lock);
 
-    return QString("Thumbnail Cache: %1 pages (%.2 MB)")
-        .arg(cachedCount)
-        .arg(memoryKB / 1024.0, 0, 'f', 2);
+    return QString("Thumbnail Cache: %1 pages (%2 MB)")
+        .arg(m_cache.size())
+        .arg(m_bytes / (1024.0 * 1024.0), 0, 'f', 2);
 }
 
 int ThumbnailCache::count() const
@@ -55,3 +58,9 @@ int ThumbnailCache::count() const
     QReadLocker locker(&m_lock);
     return m_cache.size();
 }
+
+qint64 ThumbnailCache::memoryUsage() const
+{
+    QReadLocker locker(&m_lock);
+    return m_bytes;
+}
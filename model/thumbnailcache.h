@@ -20,9 +20,11 @@ public:
     void clear();
     QString getStatistics() const;
     int count() const;
+    qint64 memoryUsage() const;
 
 private:
     QHash<int, QImage> m_cache;
+    qint64 m_bytes = 0;     ///< 缓存图像的 sizeInBytes() 之和
     mutable QReadWriteLock m_lock;
 };
 
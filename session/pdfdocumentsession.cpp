@@ -1,7 +1,14 @@
 #include "pdfdocumentsession.h"
 #include "perthreadmupdfrenderer.h"
+#include "mupdfdocumentcore.h"
+#include "rendererpool.h"
+#include "pagegeometryscanner.h"
 #include "pagecachemanager.h"
+#include "pagerenderservice.h"
+#include "diskpagecache.h"
 #include "textcachemanager.h"
+#include "thumbnailmanagerv2.h"
+#include "cachegovernor.h"
 #include "pdfviewhandler.h"
 #include "pdfcontenthandler.h"
 #include "pdfinteractionhandler.h"
@@ -11,6 +18,8 @@
 #include "appconfig.h"
 #include <QDebug>
 #include <QFileInfo>
+#include <QtConcurrent>
+#include <QFutureWatcher>
 
 PDFDocumentSession::PDFDocumentSession(QObject* parent)
     : QObject(parent)
@@ -18,9 +27,13 @@ PDFDocumentSession::PDFDocumentSession(QObject* parent)
     m_renderer = std::make_unique<PerThreadMuPDFRenderer>();
 
     m_pageCache = std::make_unique<PageCacheManager>(
-        AppConfig::instance().maxCacheSize(),
+        AppConfig::instance().pageCacheHighWatermarkBytes(),
+        AppConfig::instance().pageCacheLowWatermarkBytes(),
         PageCacheManager::CacheStrategy::NearCurrent
         );
+    m_pageCache->setCompressedBudget(AppConfig::instance().compressedCacheBytes());
+
+    m_renderService = std::make_unique<PageRenderService>(m_pageCache.get(), this);
 
     m_textCache = std::make_unique<TextCacheManager>(m_renderer.get(), this);
 
@@ -35,10 +48,13 @@ PDFDocumentSession::PDFDocumentSession(QObject* parent)
     m_state = std::make_unique<PDFDocumentState>(this);
 
     setupConnections();
+
+    CacheGovernor::instance().registerClient(this);
 }
 
 PDFDocumentSession::~PDFDocumentSession()
 {
+    CacheGovernor::instance().unregisterClient(this);
     disconnect(m_interactionHandler.get(), nullptr, this, nullptr);
     closeDocument();
     qInfo() << "PDFDocumentSession: Destroyed";
@@ -70,6 +86,8 @@ void PDFDocumentSession::closeDocument()
         return;
     }
 
+    cancelGeometryScan();
+
     if (m_interactionHandler && m_state->isTextPDF()) {
         m_interactionHandler->cancelSearch();
         m_interactionHandler->clearHoveredLink();
@@ -80,18 +98,29 @@ void PDFDocumentSession::closeDocument()
         m_textCache->cancelPreload();
     }
 
+    if (m_renderService) {
+        m_renderService->closeDocument();
+    }
+
     if (m_pageCache) {
         m_pageCache->clear();
     }
 
     if (m_textCache) {
         m_textCache->clear();
+        m_textCache->closeSearchIndex();
     }
 
     if (m_contentHandler) {
         m_contentHandler->closeDocument();
     }
 
+    // 释放线程池中为本会话保留的渲染器（同一文件在其他标签页中仍打开时保留），
+    // 仍在运行的后台任务各自持有引用，全部结束后文档才真正关闭
+    RendererPool::instance().releaseDocument(m_documentCore);
+    m_documentCore.reset();
+    m_documentFingerprint.clear();
+
     m_state->reset();
 
     qInfo() << "PDFDocumentSession: Document closed";
@@ -298,12 +327,11 @@ QString PDFDocumentSession::getThumbnailStatistics() const
 }
 
 void PDFDocumentSession::startSearch(const QString& query,
-                                     bool caseSensitive,
-                                     bool wholeWords,
+                                     const SearchOptions& options,
                                      int startPage)
 {
     if (m_interactionHandler) {
-        m_interactionHandler->startSearch(query, caseSensitive, wholeWords, startPage);
+        m_interactionHandler->startSearch(query, options, startPage);
     }
 }
 
@@ -419,18 +447,81 @@ void PDFDocumentSession::calculatePagePositions()
         return;
     }
 
-    QVector<int> positions;
     QVector<int> heights;
 
     bool success = m_viewHandler->calculatePagePositions(
         m_state->currentZoom(),
         m_state->currentRotation(),
         m_state->pageCount(),
-        positions,
         heights
         );
 }
 
+void PDFDocumentSession::updatePageHeight(int pageIndex, int height)
+{
+    const PageLayoutIndex& layout = m_state->pageLayout();
+    if (pageIndex < 0 || pageIndex >= layout.pageCount()) {
+        return;
+    }
+
+    int delta = height - layout.pageHeight(pageIndex);
+    if (m_state->setPageHeight(pageIndex, height)) {
+        emit pageHeightChanged(pageIndex, delta);
+    }
+}
+
+void PDFDocumentSession::startGeometryScan()
+{
+    cancelGeometryScan();
+
+    if (!m_documentCore || m_documentCore->pageCount() < AppConfig::GEOMETRY_SCAN_MIN_PAGES) {
+        // 小文档逐页加载的代价可以接受
+        return;
+    }
+
+    m_renderer->estimatePageSizes();
+
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_geometryScanCancelled = cancelled;
+
+    std::shared_ptr<MuPDFDocumentCore> core = m_documentCore;
+    QFuture<QVector<QSizeF>> future = QtConcurrent::run([core, cancelled]() {
+        QVector<QSizeF> sizes;
+        QString error;
+        if (!PageGeometryScanner::scan(core, sizes, cancelled.get(), &error) && !cancelled->load()) {
+            qWarning() << "PDFDocumentSession: Geometry scan incomplete:" << error;
+        }
+        return sizes;
+    });
+
+    auto* watcher = new QFutureWatcher<QVector<QSizeF>>(this);
+    connect(watcher, &QFutureWatcher<QVector<QSizeF>>::finished,
+            this, [this, watcher, cancelled]() {
+                watcher->deleteLater();
+
+                if (cancelled->load()) {
+                    return;
+                }
+                m_geometryScanCancelled.reset();
+
+                // 未扫描到的页面丢弃估算值，改为按需加载
+                if (m_renderer->applyPageSizes(watcher->result()) &&
+                    m_state->isContinuousScroll()) {
+                    calculatePagePositions();
+                }
+            });
+
+    watcher->setFuture(future);
+}
+
+void PDFDocumentSession::cancelGeometryScan()
+{
+    if (m_geometryScanCancelled) {
+        m_geometryScanCancelled->store(true);
+        m_geometryScanCancelled.reset();
+    }
+}
+
 void PDFDocumentSession::updateCurrentPageFromScroll(int scrollY, int margin)
 {
     if (!m_viewHandler) {
@@ -440,7 +531,7 @@ void PDFDocumentSession::updateCurrentPageFromScroll(int scrollY, int margin)
     int newPage = m_viewHandler->calculateCurrentPageFromScroll(
         scrollY,
         margin,
-        m_state->pageYPositions()
+        m_state->pageLayout()
         );
 
     if (newPage >= 0 && newPage != m_state->currentPage()) {
@@ -458,13 +549,14 @@ int PDFDocumentSession::getScrollPositionForPage(int pageIndex, int margin) cons
     return m_viewHandler->getScrollPositionForPage(
         pageIndex,
         margin,
-        m_state->pageYPositions()
+        m_state->pageLayout()
         );
 }
 
 QString PDFDocumentSession::getCacheStatistics() const
 {
-    return m_pageCache ? m_pageCache->getStatistics() : QString();
+    QString stats = m_pageCache ? m_pageCache->getStatistics() : QString();
+    return stats + "\n" + CacheGovernor::instance().getStatistics();
 }
 
 QString PDFDocumentSession::getTextCacheStatistics() const
@@ -472,6 +564,13 @@ QString PDFDocumentSession::getTextCacheStatistics() const
     return m_textCache ? m_textCache->getStatistics() : QString();
 }
 
+QString PDFDocumentSession::getRenderStatistics() const
+{
+    QString stats = m_renderService ? m_renderService->getStatistics() : QString();
+    return stats + "\n" + RendererPool::instance().getStatistics() +
+           "\n" + DiskPageCache::instance().getStatistics();
+}
+
 void PDFDocumentSession::saveViewportState(int scrollY) {
     m_state->saveViewportState(scrollY);
 }
@@ -492,7 +591,7 @@ void PDFDocumentSession::setupConnections()
                     updateCacheAfterStateChange();
                     if(m_state->isContinuousScroll()) {
                         int targetY = m_viewHandler->getScrollPositionForPage(
-                            newPageIndex, AppConfig::PAGE_MARGIN, m_state->pageYPositions());
+                            newPageIndex, AppConfig::PAGE_MARGIN, m_state->pageLayout());
                         emit scrollToPositionRequested(targetY);
                     }
                     emit currentPageChanged(newPageIndex);
@@ -517,6 +616,11 @@ void PDFDocumentSession::setupConnections()
                         emit requestCurrentScrollPosition();  // 新信号
                     }
 
+                    if (qAbs(m_state->currentZoom() - newZoom) > 0.001) {
+                        // 旧缩放下尚未完成的渲染请求不再需要
+                        m_renderService->invalidate();
+                    }
+
                     m_state->setCurrentZoom(newZoom);
 
                     updateCacheAfterStateChange();
@@ -551,9 +655,9 @@ void PDFDocumentSession::setupConnections()
                 });
 
         connect(m_viewHandler.get(), &PDFViewHandler::pagePositionsCalculated,
-                this, [this](const QVector<int>& positions,const QVector<int>& heights) {
-                    m_state->setPagePositions(positions, heights);
-                    emit pagePositionsChanged(positions, heights);
+                this, [this](const QVector<int>& heights) {
+                    m_state->setPageHeights(heights);
+                    emit pagePositionsChanged();
                 });
 
 
@@ -561,6 +665,9 @@ void PDFDocumentSession::setupConnections()
         // 旋转设置完成 -> 更新State
         connect(m_viewHandler.get(), &PDFViewHandler::rotationSettingCompleted,
                 this, [this](int newRotation) {
+                    if (newRotation != m_state->currentRotation()) {
+                        m_renderService->invalidate();
+                    }
                     m_state->setCurrentRotation(newRotation);
 
                     // 旋转变化需要重新计算页面位置
@@ -589,6 +696,23 @@ void PDFDocumentSession::setupConnections()
                     m_state->setDocumentLoaded(true, filePath, pageCount, isTextPDF);
                     m_state->setCurrentPage(0); // 重置到第一页
 
+                    // 后台任务（渲染、缩略图、文本提取）共享同一份已解析的文档
+                    QString coreError;
+                    RendererPool::instance().releaseDocument(m_documentCore);
+                    m_documentCore = MuPDFDocumentCore::acquire(filePath, &coreError);
+                    if (m_documentCore) {
+                        RendererPool::instance().retainDocument(m_documentCore);
+                    } else {
+                        qWarning() << "PDFDocumentSession: Failed to open shared document core:"
+                                   << coreError;
+                    }
+
+                    m_documentFingerprint = DiskPageCache::documentFingerprint(m_documentCore.get());
+                    m_renderService->setDocument(filePath, m_documentFingerprint);
+                    m_textCache->setDocumentFingerprint(m_documentFingerprint);
+
+                    startGeometryScan();
+
                     qInfo() << "PDFDocumentSession: Document loaded -"
                             << QFileInfo(filePath).fileName()
                             << "Type:" << (isTextPDF ? "Text PDF" : "Scanned PDF");
@@ -625,6 +749,12 @@ void PDFDocumentSession::setupConnections()
                     emit searchCancelled();
                 });
 
+        connect(m_interactionHandler.get(), &PDFInteractionHandler::searchError,
+                this, [this](const QString& error) {
+                    m_state->setSearchState(false, 0, -1);
+                    emit searchError(error);
+                });
+
         connect(m_interactionHandler.get(), &PDFInteractionHandler::searchNavigationCompleted,
                 this, [this](const SearchResult& result, int currentIndex, int totalMatches) {
                     m_state->setSearchState(false, totalMatches, currentIndex);
@@ -657,9 +787,15 @@ void PDFDocumentSession::setupConnections()
                 this, &PDFDocumentSession::textCopied);
     }
 
+    // 缓存增长后请求一次全局预算检查（多次请求会合并）
+    connect(m_renderService.get(), &PageRenderService::pageRendered,
+            this, []() { CacheGovernor::instance().requestEnforce(); });
+
     if (m_textCache) {
         connect(m_textCache.get(), &TextCacheManager::preloadProgress,
                 this, &PDFDocumentSession::textPreloadProgress);
+        connect(m_textCache.get(), &TextCacheManager::preloadProgress,
+                this, []() { CacheGovernor::instance().requestEnforce(); });
         connect(m_textCache.get(), &TextCacheManager::preloadCompleted,
                 this, &PDFDocumentSession::textPreloadCompleted);
         connect(m_textCache.get(), &TextCacheManager::preloadCancelled,
@@ -667,6 +803,45 @@ void PDFDocumentSession::setupConnections()
     }
 }
 
+QString PDFDocumentSession::cacheClientName() const
+{
+    QString path = m_state ? m_state->documentPath() : QString();
+    return path.isEmpty() ? tr("未打开文档") : QFileInfo(path).fileName();
+}
+
+CacheUsage PDFDocumentSession::cacheUsage() const
+{
+    CacheUsage usage;
+    if (m_pageCache) {
+        usage.pageBytes = m_pageCache->memoryUsage();
+        usage.compressedBytes = m_pageCache->compressedMemoryUsage();
+    }
+    if (m_textCache) {
+        usage.textBytes = m_textCache->memoryUsage();
+    }
+    if (m_contentHandler && m_contentHandler->thumbnailManager()) {
+        usage.thumbnailBytes = m_contentHandler->thumbnailManager()->memoryUsage();
+    }
+    return usage;
+}
+
+qint64 PDFDocumentSession::releaseCacheMemory(qint64 bytes, bool active)
+{
+    // 缩略图只加载一次且体积小，不参与释放
+    qint64 freed = 0;
+
+    if (m_pageCache) {
+        freed += m_pageCache->releaseMemory(bytes, !active);
+    }
+
+    // 当前标签页的文本用于搜索和选择，只从后台标签页释放
+    if (!active && freed < bytes && m_textCache && !m_textCache->isPreloading()) {
+        freed += m_textCache->releaseMemory(bytes - freed);
+    }
+
+    return freed;
+}
+
 void PDFDocumentSession::updateCacheAfterStateChange()
 {
     if (!m_pageCache) {
@@ -686,6 +861,11 @@ void PDFDocumentSession::setPaperEffectEnabled(bool enabled)
     if (m_renderer) {
         m_renderer->setPaperEffectEnabled(enabled);
 
+        // 先使在途的异步渲染失效，避免旧效果的结果回写缓存
+        if (m_renderService) {
+            m_renderService->setPaperEffectEnabled(enabled);
+        }
+
         // 清空缓存以便重新渲染
         if (m_pageCache) {
             m_pageCache->clear();
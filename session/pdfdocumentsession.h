@@ -7,14 +7,18 @@
 #include <QSize>
 #include <QPointF>
 #include <memory>
+#include <atomic>
 
 #include "datastructure.h"
 #include "textcachemanager.h"
 #include "pdfcontenthandler.h"
 #include "pdfdocumentstate.h"
+#include "cachegovernor.h"
 
 class PerThreadMuPDFRenderer;
+class MuPDFDocumentCore;
 class PageCacheManager;
+class PageRenderService;
 class PDFViewHandler;
 class PDFContentHandler;
 class PDFInteractionHandler;
@@ -28,7 +32,7 @@ struct PDFLink;
  * @brief PDF文档会话 - 协调所有Handler和State
  *
  */
-class PDFDocumentSession : public QObject
+class PDFDocumentSession : public QObject, public CacheGovernorClient
 {
     Q_OBJECT
 
@@ -40,6 +44,7 @@ public:
 
     PerThreadMuPDFRenderer* renderer() const { return m_renderer.get(); }
     PageCacheManager* pageCache() const { return m_pageCache.get(); }
+    PageRenderService* renderService() const { return m_renderService.get(); }
     TextCacheManager* textCache() const { return m_textCache.get(); }
 
     PDFViewHandler* viewHandler() const { return m_viewHandler.get(); }
@@ -187,8 +192,7 @@ public:
      * @brief 开始搜索
      */
     void startSearch(const QString& query,
-                     bool caseSensitive = false,
-                     bool wholeWords = false,
+                     const SearchOptions& options = SearchOptions(),
                      int startPage = 0);
 
     /**
@@ -276,6 +280,11 @@ public:
      */
     void calculatePagePositions();
 
+    /**
+     * @brief 更新单页高度（实际尺寸与估算不符时），O(log n)，不重建整个布局
+     */
+    void updatePageHeight(int pageIndex, int height);
+
     /**
      * @brief 从滚动位置更新当前页
      */
@@ -288,6 +297,7 @@ public:
 
     QString getCacheStatistics() const;
     QString getTextCacheStatistics() const;
+    QString getRenderStatistics() const;
 
     void saveViewportState(int scrollY);
     void clearViewportRestore();
@@ -345,9 +355,15 @@ signals:
     void currentRotationChanged(int rotation);
 
     /**
-     * @brief 页面位置计算完成
+     * @brief 页面位置计算完成（布局整体重建）
      */
-    void pagePositionsChanged(const QVector<int>& positions, const QVector<int>& heights);
+    void pagePositionsChanged();
+
+    /**
+     * @brief 单页高度变化（布局已增量更新）
+     * @param delta 高度变化量，其后所有页面随之移动
+     */
+    void pageHeightChanged(int pageIndex, int delta);
 
     /**
      * @brief 需要滚动到指定位置
@@ -393,6 +409,11 @@ signals:
      */
     void searchCancelled();
 
+    /**
+     * @brief 搜索错误（例如正则表达式无效）
+     */
+    void searchError(const QString& error);
+
     /**
      * @brief 链接悬停
      */
@@ -434,10 +455,25 @@ private:
     void setupConnections();
     void updateCacheAfterStateChange();
 
+    /**
+     * @brief 大文档：先以估算尺寸布局，后台扫描精确页面尺寸后重新布局
+     */
+    void startGeometryScan();
+    void cancelGeometryScan();
+
+    // ==== CacheGovernorClient ====
+    QString cacheClientName() const override;
+    CacheUsage cacheUsage() const override;
+    qint64 releaseCacheMemory(qint64 bytes, bool active) override;
+
 private:
     // 核心组件
     std::unique_ptr<PerThreadMuPDFRenderer> m_renderer;
+    std::shared_ptr<MuPDFDocumentCore> m_documentCore;    // 后台任务共享的文档，文档打开期间保持
+    QString m_documentFingerprint;                        // 磁盘渲染缓存使用的文档指纹
+    std::shared_ptr<std::atomic_bool> m_geometryScanCancelled;  // 进行中的几何扫描的取消标志
     std::unique_ptr<PageCacheManager> m_pageCache;
+    std::unique_ptr<PageRenderService> m_renderService;   // 必须先于 m_pageCache 析构
     std::unique_ptr<TextCacheManager> m_textCache;
 
     // Handler（处理业务逻辑）
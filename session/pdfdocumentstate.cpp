@@ -75,11 +75,14 @@ void PDFDocumentState::setCurrentRotation(int rotation)
     }
 }
 
-void PDFDocumentState::setPagePositions(const QVector<int>& positions,
-                                        const QVector<int>& heights)
+void PDFDocumentState::setPageHeights(const QVector<int>& heights)
 {
-    m_pageYPositions = positions;
-    m_pageHeights = heights;
+    m_pageLayout.reset(heights, AppConfig::PAGE_GAP);
+}
+
+bool PDFDocumentState::setPageHeight(int pageIndex, int height)
+{
+    return m_pageLayout.setPageHeight(pageIndex, height);
 }
 
 void PDFDocumentState::setLinksVisible(bool visible)
@@ -111,18 +114,18 @@ void PDFDocumentState::setSearchState(bool searching, int totalMatches, int curr
 
 void PDFDocumentState::saveViewportState(int scrollY)
 {
-    if (!m_isContinuousScroll || m_pageYPositions.isEmpty()) {
+    if (!m_isContinuousScroll || m_pageLayout.isEmpty()) {
         m_viewportRestore.needRestore = false;
         return;
     }
 
-    if (m_currentPage < 0 || m_currentPage >= m_pageYPositions.size()) {
+    if (m_currentPage < 0 || m_currentPage >= m_pageLayout.pageCount()) {
         m_viewportRestore.needRestore = false;
         return;
     }
 
-    int pageTop = m_pageYPositions[m_currentPage];
-    int pageHeight = m_pageHeights[m_currentPage];
+    int pageTop = m_pageLayout.pageTop(m_currentPage);
+    int pageHeight = m_pageLayout.pageHeight(m_currentPage);
 
     if (pageHeight > 0) {
         double offsetRatio = (scrollY - pageTop) / (double)pageHeight;
@@ -140,13 +143,13 @@ int PDFDocumentState::getRestoredScrollPosition(int margin) const
     }
 
     if (m_viewportRestore.pageIndex < 0 ||
-        m_viewportRestore.pageIndex >= m_pageYPositions.size()) {
+        m_viewportRestore.pageIndex >= m_pageLayout.pageCount()) {
         return -1;
     }
 
-    // 使用新的positions计算绝对位置
-    int pageTop = m_pageYPositions[m_viewportRestore.pageIndex] + margin;
-    int pageHeight = m_pageHeights[m_viewportRestore.pageIndex];
+    // 使用新的布局计算绝对位置
+    int pageTop = m_pageLayout.pageTop(m_viewportRestore.pageIndex) + margin;
+    int pageHeight = m_pageLayout.pageHeight(m_viewportRestore.pageIndex);
 
     int targetY = pageTop + (int)(pageHeight * m_viewportRestore.pageOffsetRatio);
 
@@ -162,7 +165,7 @@ void PDFDocumentState::reset()
     setCurrentDisplayMode(PageDisplayMode::SinglePage);
     setContinuousScroll(true);
     setCurrentRotation(0);
-    setPagePositions(QVector<int>(), QVector<int>());
+    setPageHeights(QVector<int>());
     setLinksVisible(true);
     setHasTextSelection(false);
     setSearchState(false, 0, -1);
@@ -5,6 +5,7 @@
 #include <QString>
 #include <QVector>
 #include "datastructure.h"
+#include "pagelayoutindex.h"
 
 /**
  * @brief PDF文档状态对象 - 集中管理文档的所有状态
@@ -79,14 +80,9 @@ public:
 
 
     /**
-     * @brief 获取页面Y位置列表
+     * @brief 获取连续滚动模式的页面布局（页面位置与高度）
      */
-    const QVector<int>& pageYPositions() const { return m_pageYPositions; }
-
-    /**
-     * @brief 获取页面高度列表
-     */
-    const QVector<int>& pageHeights() const { return m_pageHeights; }
+    const PageLayoutIndex& pageLayout() const { return m_pageLayout; }
 
     /**
      * @brief 链接是否可见
@@ -121,7 +117,13 @@ public:
     void setCurrentDisplayMode(PageDisplayMode mode);
     void setContinuousScroll(bool continuous);
     void setCurrentRotation(int rotation);
-    void setPagePositions(const QVector<int>& positions, const QVector<int>& heights);
+    void setPageHeights(const QVector<int>& heights);
+
+    /**
+     * @brief 更新单页高度（不重建布局）
+     * @return 高度是否发生变化
+     */
+    bool setPageHeight(int pageIndex, int height);
     void setLinksVisible(bool visible);
     void setHasTextSelection(bool has);
     void setSearchState(bool searching, int totalMatches = 0, int currentIndex = -1);
@@ -165,8 +167,7 @@ private:
     ViewportRestoreState m_viewportRestore;
 
     // 连续滚动状态
-    QVector<int> m_pageYPositions;
-    QVector<int> m_pageHeights;
+    PageLayoutIndex m_pageLayout;
 
     // 交互状态
     bool m_linksVisible;
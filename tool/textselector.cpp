@@ -25,10 +25,11 @@ void TextSelector::startSelection(int pageIndex, const QPointF& pagePos, double
         return;
     }
 
-    PageTextData pageData = m_textCache->getPageTextData(pageIndex);
-    if (!pageData.isValid()) {
+    PageTextDataPtr snapshot = pageText(pageIndex);
+    if (!snapshot || !snapshot->isValid()) {
         return;
     }
+    const PageTextData& pageData = *snapshot;
 
     CharPosition charPos = hitTestCharacter(pageData, pagePos, zoom);
     if (!charPos.isValid()) {
@@ -84,10 +85,11 @@ void TextSelector::updateSelection(int pageIndex, const QPointF& pagePos, double
         return;
     }
 
-    PageTextData pageData = m_textCache->getPageTextData(pageIndex);
-    if (!pageData.isValid()) {
+    PageTextDataPtr snapshot = pageText(pageIndex);
+    if (!snapshot || !snapshot->isValid()) {
         return;
     }
+    const PageTextData& pageData = *snapshot;
 
     CharPosition currentPos = hitTestCharacter(pageData, pagePos, zoom);
     if (!currentPos.isValid()) {
@@ -144,10 +146,11 @@ void TextSelector::extendSelection(int pageIndex, const QPointF& pagePos, double
         return;
     }
 
-    PageTextData pageData = m_textCache->getPageTextData(pageIndex);
-    if (!pageData.isValid()) {
+    PageTextDataPtr snapshot = pageText(pageIndex);
+    if (!snapshot || !snapshot->isValid()) {
         return;
     }
+    const PageTextData& pageData = *snapshot;
 
     CharPosition endPos = hitTestCharacter(pageData, pagePos, zoom);
     if (!endPos.isValid()) {
@@ -163,10 +166,11 @@ void TextSelector::selectWord(int pageIndex, const QPointF& pagePos, double zoom
         return;
     }
 
-    PageTextData pageData = m_textCache->getPageTextData(pageIndex);
-    if (!pageData.isValid()) {
+    PageTextDataPtr snapshot = pageText(pageIndex);
+    if (!snapshot || !snapshot->isValid()) {
         return;
     }
+    const PageTextData& pageData = *snapshot;
 
     CharPosition charPos = hitTestCharacter(pageData, pagePos, zoom);
     if (!charPos.isValid()) {
@@ -189,10 +193,11 @@ void TextSelector::selectLine(int pageIndex, const QPointF& pagePos, double zoom
         return;
     }
 
-    PageTextData pageData = m_textCache->getPageTextData(pageIndex);
-    if (!pageData.isValid()) {
+    PageTextDataPtr snapshot = pageText(pageIndex);
+    if (!snapshot || !snapshot->isValid()) {
         return;
     }
+    const PageTextData& pageData = *snapshot;
 
     CharPosition charPos = hitTestCharacter(pageData, pagePos, zoom);
     if (!charPos.isValid()) {
@@ -214,10 +219,11 @@ void TextSelector::selectBlock(int pageIndex, const QPointF& pagePos, double zoo
         return;
     }
 
-    PageTextData pageData = m_textCache->getPageTextData(pageIndex);
-    if (!pageData.isValid()) {
+    PageTextDataPtr snapshot = pageText(pageIndex);
+    if (!snapshot || !snapshot->isValid()) {
         return;
     }
+    const PageTextData& pageData = *snapshot;
 
     CharPosition charPos = hitTestCharacter(pageData, pagePos, zoom);
     if (!charPos.isValid()) {
@@ -239,19 +245,23 @@ void TextSelector::selectAll(int pageIndex)
         return;
     }
 
-    PageTextData pageData = m_textCache->getPageTextData(pageIndex);
-    if (!pageData.isValid() || pageData.blocks.isEmpty()) {
+    PageTextDataPtr snapshot = pageText(pageIndex);
+    if (!snapshot || !snapshot->isValid() || snapshot->isEmpty()) {
         return;
     }
+    const PageTextData& pageData = *snapshot;
 
     // 找到第一个和最后一个字符
     CharPosition start(0, 0, 0);
 
-    const TextBlock& lastBlock = pageData.blocks.last();
-    const TextLine& lastLine = lastBlock.lines.last();
-    CharPosition end(pageData.blocks.size() - 1,
-                     lastBlock.lines.size() - 1,
-                     lastLine.chars.size() - 1);
+    int lastBlock = pageData.blockCount() - 1;
+    if (pageData.blockLineCount(lastBlock) == 0) {
+        return;
+    }
+    int lastLine = pageData.blockLineEnd(lastBlock) - 1;
+    CharPosition end(lastBlock,
+                     lastLine - pageData.blockLineBegin(lastBlock),
+                     pageData.lineLength(lastLine) - 1);
 
     setSelectionRange(pageIndex, start, end, SelectionMode::Character);
 }
@@ -268,6 +278,7 @@ void TextSelector::endSelection()
 void TextSelector::clearSelection()
 {
     m_selection.clear();
+    m_pageText.reset();
     m_isSelecting = false;
     m_hasAnchor = false;
     emit selectionChanged();
@@ -285,6 +296,15 @@ void TextSelector::copyToClipboard()
     qDebug() << "Copied to clipboard:" << m_selection.selectedText.length() << "characters";
 }
 
+PageTextDataPtr TextSelector::pageText(int pageIndex)
+{
+    // 拖拽过程中每次鼠标移动都会用到同一页，直接复用持有的快照
+    if (!m_pageText || m_pageText->pageIndex != pageIndex) {
+        m_pageText = m_textCache ? m_textCache->getPageTextData(pageIndex) : nullptr;
+    }
+    return m_pageText;
+}
+
 CharPosition TextSelector::hitTestCharacter(const PageTextData& pageData,
                                             const QPointF& pos,
                                             double zoom)
@@ -295,18 +315,21 @@ CharPosition TextSelector::hitTestCharacter(const PageTextData& pageData,
     double minDistance = std::numeric_limits<double>::max();
     CharPosition result;
 
-    for (int b = 0; b < pageData.blocks.size(); ++b) {
-        const TextBlock& block = pageData.blocks[b];
+    for (int b = 0; b < pageData.blockCount(); ++b) {
+        const int blockLineBegin = pageData.blockLineBegin(b);
 
-        for (int l = 0; l < block.lines.size(); ++l) {
-            const TextLine& line = block.lines[l];
+        for (int line = blockLineBegin; line < pageData.blockLineEnd(b); ++line) {
+            const int l = line - blockLineBegin;
+            const int charBegin = pageData.lineCharBegin(line);
+            const int charEnd = pageData.lineCharEnd(line);
 
-            if (line.chars.isEmpty()) continue;
+            if (charBegin == charEnd) continue;
 
             // 检查是否在行的垂直范围内（扩大容差到50%）
-            double lineTop = line.bbox.top();
-            double lineBottom = line.bbox.bottom();
-            double verticalMargin = line.bbox.height() * 0.5;
+            QRectF lineBox = pageData.lineRect(line);
+            double lineTop = lineBox.top();
+            double lineBottom = lineBox.bottom();
+            double verticalMargin = lineBox.height() * 0.5;
 
             // 如果不在行的垂直范围内，跳过
             if (pageCoord.y() < lineTop - verticalMargin ||
@@ -315,37 +338,40 @@ CharPosition TextSelector::hitTestCharacter(const PageTextData& pageData,
             }
 
             // 在行的水平范围内查找最近的字符
-            for (int c = 0; c < line.chars.size(); ++c) {
-                const TextChar& ch = line.chars[c];
+            for (int c = charBegin; c < charEnd; ++c) {
+                QRectF charBox = pageData.charRect(line, c);
 
                 // 如果点在字符bbox内，直接返回
-                if (ch.bbox.contains(pageCoord)) {
-                    return CharPosition(b, l, c);
+                if (charBox.contains(pageCoord)) {
+                    return CharPosition(b, l, c - charBegin);
                 }
 
                 // 计算到字符中心的距离
-                QPointF charCenter = ch.bbox.center();
+                QPointF charCenter = charBox.center();
                 double distance = QLineF(pageCoord, charCenter).length();
 
                 if (distance < minDistance) {
                     minDistance = distance;
-                    result = CharPosition(b, l, c);
+                    result = CharPosition(b, l, c - charBegin);
                 }
             }
 
             // 如果点在行内但超过最后一个字符，选择最后一个字符
             if (pageCoord.y() >= lineTop && pageCoord.y() <= lineBottom) {
-                if (pageCoord.x() > line.chars.last().bbox.right()) {
-                    int lastCharIdx = line.chars.size() - 1;
-                    double distance = pageCoord.x() - line.chars.last().bbox.right();
+                double lastRight = pageData.charRect(line, charEnd - 1).right();
+                double firstLeft = pageData.charRect(line, charBegin).left();
+
+                if (pageCoord.x() > lastRight) {
+                    int lastCharIdx = charEnd - charBegin - 1;
+                    double distance = pageCoord.x() - lastRight;
                     if (distance < minDistance) {
                         minDistance = distance;
                         result = CharPosition(b, l, lastCharIdx);
                     }
                 }
                 // 如果点在第一个字符之前，选择第一个字符
-                else if (pageCoord.x() < line.chars.first().bbox.left()) {
-                    double distance = line.chars.first().bbox.left() - pageCoord.x();
+                else if (pageCoord.x() < firstLeft) {
+                    double distance = firstLeft - pageCoord.x();
                     if (distance < minDistance) {
                         minDistance = distance;
                         result = CharPosition(b, l, 0);
@@ -358,27 +384,19 @@ CharPosition TextSelector::hitTestCharacter(const PageTextData& pageData,
     return result;
 }
 
-static inline bool isCJK(QChar ch)
-{
-    uint u = ch.unicode();
-    return (u >= 0x4E00 && u <= 0x9FFF) ||    // CJK Unified Ideographs
-           (u >= 0x3400 && u <= 0x4DBF) ||    // CJK Extension A
-           (u >= 0xF900 && u <= 0xFAFF) ||    // CJK Compatibility Ideographs
-           (u >= 0x3040 && u <= 0x30FF) ||    // Japanese Hiragana/Katakana
-           (u >= 0xAC00 && u <= 0xD7AF);      // Korean Hangul
-}
-
 void TextSelector::findWordBoundary(
     const PageTextData& pageData,
     const CharPosition& pos,
     CharPosition* start,
     CharPosition* end)
 {
-    const TextLine& line = pageData.blocks[pos.blockIndex].lines[pos.lineIndex];
-    QChar c = line.chars[pos.charIndex].character;
+    const int line = pageData.lineIndex(pos.blockIndex, pos.lineIndex);
+    const int charBegin = pageData.lineCharBegin(line);
+    const int lineLength = pageData.lineLength(line);
+    QChar c = pageData.charAt(charBegin + pos.charIndex);
 
     // ★★★ 如果是中文/日文/韩文：单字为“词” ★★★
-    if (isCJK(c)) {
+    if (PageTextData::isCJK(c)) {
         *start = pos;
         *end = pos;
         return;
@@ -387,14 +405,14 @@ void TextSelector::findWordBoundary(
     // 原英文处理逻辑
     int startIdx = pos.charIndex;
     while (startIdx > 0) {
-        QChar prev = line.chars[startIdx - 1].character;
+        QChar prev = pageData.charAt(charBegin + startIdx - 1);
         if (isWordSeparator(prev)) break;
         startIdx--;
     }
 
     int endIdx = pos.charIndex;
-    while (endIdx < line.chars.size() - 1) {
-        QChar next = line.chars[endIdx + 1].character;
+    while (endIdx < lineLength - 1) {
+        QChar next = pageData.charAt(charBegin + endIdx + 1);
         if (isWordSeparator(next)) break;
         endIdx++;
     }
@@ -409,22 +427,21 @@ void TextSelector::findLineBoundary(const PageTextData& pageData,
                                     CharPosition* start,
                                     CharPosition* end)
 {
-    if (!pos.isValid() || pos.blockIndex >= pageData.blocks.size()) {
+    if (!pos.isValid() || pos.blockIndex >= pageData.blockCount()) {
         return;
     }
 
-    const TextBlock& block = pageData.blocks[pos.blockIndex];
-    if (pos.lineIndex >= block.lines.size()) {
+    if (pos.lineIndex >= pageData.blockLineCount(pos.blockIndex)) {
         return;
     }
 
-    const TextLine& line = block.lines[pos.lineIndex];
-    if (line.chars.isEmpty()) {
+    const int lineLength = pageData.lineLength(pageData.lineIndex(pos.blockIndex, pos.lineIndex));
+    if (lineLength == 0) {
         return;
     }
 
     *start = CharPosition(pos.blockIndex, pos.lineIndex, 0);
-    *end = CharPosition(pos.blockIndex, pos.lineIndex, line.chars.size() - 1);
+    *end = CharPosition(pos.blockIndex, pos.lineIndex, lineLength - 1);
 }
 
 void TextSelector::findBlockBoundary(const PageTextData& pageData,
@@ -432,12 +449,12 @@ void TextSelector::findBlockBoundary(const PageTextData& pageData,
                                      CharPosition* start,
                                      CharPosition* end)
 {
-    if (!pos.isValid() || pos.blockIndex >= pageData.blocks.size()) {
+    if (!pos.isValid() || pos.blockIndex >= pageData.blockCount()) {
         return;
     }
 
-    const TextBlock& block = pageData.blocks[pos.blockIndex];
-    if (block.lines.isEmpty()) {
+    const int lineCount = pageData.blockLineCount(pos.blockIndex);
+    if (lineCount == 0) {
         return;
     }
 
@@ -445,9 +462,9 @@ void TextSelector::findBlockBoundary(const PageTextData& pageData,
     *start = CharPosition(pos.blockIndex, 0, 0);
 
     // 块的结束：最后一行最后一个字符
-    const TextLine& lastLine = block.lines.last();
-    *end = CharPosition(pos.blockIndex, block.lines.size() - 1,
-                        lastLine.chars.size() - 1);
+    const int lastLine = pageData.blockLineEnd(pos.blockIndex) - 1;
+    *end = CharPosition(pos.blockIndex, lineCount - 1,
+                        pageData.lineLength(lastLine) - 1);
 }
 
 bool TextSelector::isWordSeparator(QChar ch) const
@@ -495,10 +512,11 @@ void TextSelector::buildSelection()
         return;
     }
 
-    PageTextData pageData = m_textCache->getPageTextData(m_selection.pageIndex);
-    if (!pageData.isValid()) {
+    PageTextDataPtr snapshot = pageText(m_selection.pageIndex);
+    if (!snapshot || !snapshot->isValid()) {
         return;
     }
+    const PageTextData& pageData = *snapshot;
 
     m_selection.selectedText = extractSelectedText(pageData);
     m_selection.highlightRects = calculateHighlightRects(pageData);
@@ -515,20 +533,23 @@ QString TextSelector::extractSelectedText(const PageTextData& pageData)
     int endLine = m_selection.endLineIndex;
     int endChar = m_selection.endCharIndex;
 
-    for (int b = startBlock; b <= endBlock && b < pageData.blocks.size(); ++b) {
-        const TextBlock& block = pageData.blocks[b];
+    for (int b = startBlock; b <= endBlock && b < pageData.blockCount(); ++b) {
+        const int blockLines = pageData.blockLineCount(b);
 
         int firstLine = (b == startBlock) ? startLine : 0;
-        int lastLine = (b == endBlock) ? endLine : block.lines.size() - 1;
+        int lastLine = (b == endBlock) ? endLine : blockLines - 1;
 
-        for (int l = firstLine; l <= lastLine && l < block.lines.size(); ++l) {
-            const TextLine& line = block.lines[l];
+        for (int l = firstLine; l <= lastLine && l < blockLines; ++l) {
+            QStringView lineText = pageData.lineText(pageData.lineIndex(b, l));
+
+            const int lineLength = int(lineText.size());
 
             int firstChar = (b == startBlock && l == startLine) ? startChar : 0;
-            int lastChar = (b == endBlock && l == endLine) ? endChar : line.chars.size() - 1;
+            int lastChar = (b == endBlock && l == endLine) ? endChar : lineLength - 1;
+            lastChar = qMin(lastChar, lineLength - 1);
 
-            for (int c = firstChar; c <= lastChar && c < line.chars.size(); ++c) {
-                text.append(line.chars[c].character);
+            if (firstChar <= lastChar) {
+                text.append(lineText.mid(firstChar, lastChar - firstChar + 1));
             }
 
             // 行尾添加换行符（除了最后一个字符）
@@ -557,31 +578,28 @@ QVector<QRectF> TextSelector::calculateHighlightRects(const PageTextData& pageDa
     int endLine = m_selection.endLineIndex;
     int endChar = m_selection.endCharIndex;
 
-    for (int b = startBlock; b <= endBlock && b < pageData.blocks.size(); ++b) {
-        const TextBlock& block = pageData.blocks[b];
+    for (int b = startBlock; b <= endBlock && b < pageData.blockCount(); ++b) {
+        const int blockLines = pageData.blockLineCount(b);
 
         int firstLine = (b == startBlock) ? startLine : 0;
-        int lastLine = (b == endBlock) ? endLine : block.lines.size() - 1;
+        int lastLine = (b == endBlock) ? endLine : blockLines - 1;
 
-        for (int l = firstLine; l <= lastLine && l < block.lines.size(); ++l) {
-            const TextLine& line = block.lines[l];
+        for (int l = firstLine; l <= lastLine && l < blockLines; ++l) {
+            const int line = pageData.lineIndex(b, l);
+            const int lineLength = pageData.lineLength(line);
 
-            if (line.chars.isEmpty()) continue;
+            if (lineLength == 0) continue;
 
             int firstChar = (b == startBlock && l == startLine) ? startChar : 0;
-            int lastChar = (b == endBlock && l == endLine) ? endChar : line.chars.size() - 1;
+            int lastChar = (b == endBlock && l == endLine) ? endChar : lineLength - 1;
 
-            if (firstChar >= line.chars.size() || lastChar >= line.chars.size()) {
+            if (firstChar >= lineLength || lastChar >= lineLength) {
                 continue;
             }
 
             // 合并同一行的字符bbox
-            QRectF lineRect = line.chars[firstChar].bbox;
-            for (int c = firstChar + 1; c <= lastChar && c < line.chars.size(); ++c) {
-                lineRect = lineRect.united(line.chars[c].bbox);
-            }
-
-            rects.append(lineRect);
+            const int charBegin = pageData.lineCharBegin(line);
+            rects.append(pageData.charRangeRect(line, charBegin + firstChar, charBegin + lastChar));
         }
     }
 
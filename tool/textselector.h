@@ -195,6 +195,14 @@ signals:
     void scrollRequested(int direction);
 
 private:
+    /**
+     * @brief 获取页面文本快照
+     *
+     * 与上次是同一页时直接返回持有的快照，不查询缓存；
+     * 快照只读，被缓存淘汰后仍然有效。
+     */
+    PageTextDataPtr pageText(int pageIndex);
+
     /**
      * @brief 命中测试：找到位置对应的字符
      */
@@ -274,6 +282,7 @@ private:
     TextCacheManager* m_textCache;
 
     TextSelection m_selection;              ///< 当前选择
+    PageTextDataPtr m_pageText;             ///< 选择所在页面的文本快照
     bool m_isSelecting;                     ///< 是否正在选择
 
     // 选择锚点（用于Shift+点击扩展选择）
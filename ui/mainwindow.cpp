@@ -5,6 +5,9 @@
 #include "ocrmanager.h"
 #include "chinesetokenizer.h"
 #include "appconfig.h"
+#include "pdfdocumentsession.h"
+#include "cachegovernor.h"
+#include "diskpagecache.h"
 
 #include <QMenuBar>
 #include <QToolBar>
@@ -71,6 +74,16 @@ MainWindow::MainWindow(QWidget* parent)
     // 应用全局样式
     applyModernStyle();
 
+    // 缓存配置变化时同步到全局缓存
+    connect(&AppConfig::instance(), &AppConfig::cacheConfigChanged,
+            this, &MainWindow::applyCacheConfig);
+    applyCacheConfig();
+
+    // 退出前写完磁盘缓存并保存索引（静态对象析构时 QApplication 已经销毁）
+    connect(qApp, &QCoreApplication::aboutToQuit, this, []() {
+        DiskPageCache::instance().flush();
+    });
+
     // 检查GoldenDict是否可用
     if (!DictionaryConnector::instance().isGoldenDictAvailable()) {
         qWarning() << "GoldenDict not found, lookup feature will not work";
@@ -221,6 +234,9 @@ void MainWindow::onTabChanged(int index)
 
     PDFDocumentTab* tab = currentTab();
 
+    // 其余标签页转为后台，内存紧张时优先从它们释放缓存
+    CacheGovernor::instance().setActiveClient(tab ? tab->session() : nullptr);
+
     if (tab && tab->isDocumentLoaded()) {
         // 切换到已加载文档的标签页
 
@@ -1196,6 +1212,17 @@ void MainWindow::closeEvent(QCloseEvent* event)
     QMainWindow::closeEvent(event);
 }
 
+void MainWindow::applyCacheConfig()
+{
+    const AppConfig& config = AppConfig::instance();
+
+    DiskPageCache& diskCache = DiskPageCache::instance();
+    diskCache.setMaxBytes(config.diskCacheBytes());
+    diskCache.setEnabled(config.diskCacheEnabled());    // 启用时在后台加载索引
+
+    CacheGovernor::instance().setBudget(config.globalCacheBudgetBytes());
+}
+
 void MainWindow::applyModernStyle()
 {
     QFile styleFile(":styles/resources/styles/main.qss");
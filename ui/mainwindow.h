@@ -84,6 +84,9 @@ private slots:
     void onOCRHoverEnabledChanged(bool enabled);
     void triggerOCRAtCurrentPosition();
 
+    // 配置
+    void applyCacheConfig();
+
 private:
     void createMenuBar();
     void createToolBar();
@@ -7,6 +7,7 @@
 #include "ocrfloatingwidget.h"
 #include "perthreadmupdfrenderer.h"
 #include "pagecachemanager.h"
+#include "pagerenderservice.h"
 #include "pdfinteractionhandler.h"
 #include "textcachemanager.h"
 #include "pdfviewhandler.h"
@@ -28,6 +29,7 @@
 #include <QMenu>
 #include <QApplication>
 #include <QToolTip>
+#include <algorithm>
 
 PDFDocumentTab::PDFDocumentTab(QWidget* parent)
     : QWidget(parent)
@@ -41,6 +43,7 @@ PDFDocumentTab::PDFDocumentTab(QWidget* parent)
     , m_lastClickTime(0)
     , m_clickCount(0)
     , m_isUserScrolling(false)
+    , m_prefetchSettleTimer(nullptr)
     , m_ocrFloatingWidget(nullptr)
 {
     setupUI();
@@ -160,6 +163,8 @@ void PDFDocumentTab::setupConnections()
 
     connect(m_session, &PDFDocumentSession::pagePositionsChanged,
             this, &PDFDocumentTab::onPagePositionsChanged);
+    connect(m_session, &PDFDocumentSession::pageHeightChanged,
+            this, &PDFDocumentTab::onPageHeightChanged);
 
     connect(m_session, &PDFDocumentSession::currentRotationChanged,
             this, [this](int rotation) {
@@ -201,6 +206,15 @@ void PDFDocumentTab::setupConnections()
     connect(m_session, &PDFDocumentSession::searchCompleted,
             this, &PDFDocumentTab::onSearchCompleted);
 
+    // 搜索结果逐页到达，随时刷新高亮
+    connect(m_session, &PDFDocumentSession::searchProgressUpdated,
+            this, [this]() {
+                m_pageWidget->update();
+            });
+
+    connect(m_session->renderService(), &PageRenderService::pageRendered,
+            this, &PDFDocumentTab::onPageRendered);
+
     connect(m_pageWidget, &PDFPageWidget::pageClicked,
             this, &PDFDocumentTab::onPageClicked);
 
@@ -226,6 +240,12 @@ void PDFDocumentTab::setupConnections()
     connect(m_scrollArea->verticalScrollBar(), &QScrollBar::valueChanged,
             this, &PDFDocumentTab::onScrollValueChanged);
 
+    m_prefetchSettleTimer = new QTimer(this);
+    m_prefetchSettleTimer->setSingleShot(true);
+    m_prefetchSettleTimer->setInterval(PrefetchPlanner::IDLE_MS + 50);
+    connect(m_prefetchSettleTimer, &QTimer::timeout,
+            this, &PDFDocumentTab::refreshVisiblePages);
+
     connect(m_searchWidget, &SearchWidget::closeRequested,
             this, &PDFDocumentTab::hideSearchBar);
 
@@ -584,7 +604,7 @@ void PDFDocumentTab::onContinuousScrollChanged(bool continuous)
     emit continuousScrollChanged(continuous);
 }
 
-void PDFDocumentTab::onPagePositionsChanged(const QVector<int>& positions, const QVector<int>& heights)
+void PDFDocumentTab::onPagePositionsChanged()
 {
     QSize targetSize = m_pageWidget->calculateRequiredSize();
     m_pageWidget->resize(targetSize);
@@ -614,6 +634,25 @@ void PDFDocumentTab::onPagePositionsChanged(const QVector<int>& positions, const
     }
 }
 
+void PDFDocumentTab::onPageHeightChanged(int pageIndex, int delta)
+{
+    const PageLayoutIndex& layout = m_session->state()->pageLayout();
+
+    // 变化的页面在视口上方时同步移动滚动位置，视口内容保持不动
+    QScrollBar* scrollBar = m_scrollArea->verticalScrollBar();
+    int pageBottom = layout.pageTop(pageIndex) + layout.pageHeight(pageIndex) + AppConfig::PAGE_MARGIN;
+    bool aboveViewport = pageBottom - delta <= scrollBar->value();
+
+    m_pageWidget->resize(m_pageWidget->calculateRequiredSize());
+
+    if (aboveViewport) {
+        scrollBar->setValue(scrollBar->value() + delta);
+    }
+
+    m_pageWidget->update();
+    refreshVisiblePages();
+}
+
 void PDFDocumentTab::onTextSelectionChanged(bool hasSelection)
 {
     m_pageWidget->update();
@@ -737,9 +776,13 @@ void PDFDocumentTab::onScrollValueChanged(int value)
     if (state->isContinuousScroll()) {
         m_isUserScrolling = true;
 
+        m_prefetchPlanner.recordScroll(value);
         m_session->updateCurrentPageFromScroll(value, AppConfig::PAGE_MARGIN);
         refreshVisiblePages();
 
+        // 停下后补上滑动期间暂停的预加载
+        m_prefetchSettleTimer->start();
+
         m_isUserScrolling = false;
     }
 }
@@ -754,14 +797,35 @@ void PDFDocumentTab::renderAndUpdatePages()
     }
 
     if (state->isContinuousScroll()) {
+        // 布局变化后旧的滚动速度与页面记录不再适用
+        m_prefetchPlanner.reset();
         m_session->calculatePagePositions();
     } else {
-        // 单页/双页模式
-        QImage img1 = renderPage(state->currentPage());
+        // 单页/双页模式：当前页先显示草稿（或已缓存的最终渲染），最终渲染在后台完成
+        int currentPage = state->currentPage();
+        bool doublePage = state->currentDisplayMode() == PageDisplayMode::DoublePage;
+
+        // 相邻页交给后台渲染，翻页时直接命中缓存
+        // （先提交并替换旧请求，当前页的最终渲染随后以更高优先级加入）
+        int step = doublePage ? 2 : 1;
+        QVector<int> neighbours;
+        for (int i = 0; i < step; ++i) {
+            int after = currentPage + step + i;
+            int before = currentPage - step + i;
+            if (after < state->pageCount()) neighbours.append(after);
+            if (before >= 0) neighbours.append(before);
+        }
+
+        m_session->renderService()->schedule(neighbours, PageRenderPriority::Preload,
+                                             state->currentZoom(),
+                                             state->currentRotation(),
+                                             true);
+
+        QImage img1 = renderPage(currentPage);
         QImage img2;
 
-        if (state->currentDisplayMode() == PageDisplayMode::DoublePage) {
-            int nextPage = state->currentPage() + 1;
+        if (doublePage) {
+            int nextPage = currentPage + 1;
             if (nextPage < state->pageCount()) {
                 img2 = renderPage(nextPage);
             }
@@ -781,22 +845,107 @@ QImage PDFDocumentTab::renderPage(int pageIndex)
     double zoom = state->currentZoom();
     int rotation = state->currentRotation();
 
+    // 草稿排在所有请求之前（缩略图可用时直接写入缓存），要在取替身之前提交
+    if (!m_session->pageCache()->isResident(pageIndex, zoom, rotation)) {
+        scheduleDrafts({pageIndex}, zoom, rotation);
+    }
+
+    bool isFinal = false;
+    QImage image = cachedDisplayImage(pageIndex, zoom, rotation, &isFinal);
+
+    if (!isFinal) {
+        // 最终渲染交给后台（依次查压缩层、磁盘缓存），完成后 onPageRendered 替换
+        m_session->renderService()->schedule({pageIndex}, PageRenderPriority::Visible, zoom, rotation);
+    }
+
+    return image;
+}
+
+QImage PDFDocumentTab::cachedDisplayImage(int pageIndex, double zoom, int rotation, bool* isFinal)
+{
     PageCacheManager* cache = m_session->pageCache();
-    PerThreadMuPDFRenderer* renderer = m_session->renderer();
+    *isFinal = false;
+
+    QImage finalImage = cache->getResidentPage(pageIndex, zoom, rotation);
+    if (!finalImage.isNull()) {
+        *isFinal = true;
+        return finalImage;
+    }
+
+    QSize targetSize = m_session->viewHandler()->getPagePixelSize(pageIndex, zoom, rotation);
+    if (targetSize.isEmpty()) {
+        return QImage();
+    }
 
-    // 检查缓存
-    if (cache->contains(pageIndex, zoom, rotation)) {
-        return cache->getPage(pageIndex, zoom, rotation);
+    // 替身：其他缩放下的最终渲染（放大不超过草稿的损失时）> 缓存中的草稿（含缩略图）
+    double nearestScale = 1.0;
+    QImage draft = cache->getNearestZoomPage(pageIndex, zoom, rotation, &nearestScale);
+    if (nearestScale > 1.0 / AppConfig::DRAFT_ZOOM_RATIO) {
+        draft = QImage();
+    }
+    if (draft.isNull()) {
+        draft = cache->getPageOrDraft(pageIndex, zoom, rotation);
     }
 
-    // 渲染新页面
-    auto result = renderer->renderPage(pageIndex, zoom, rotation);
-    if (result.success) {
-        cache->addPage(pageIndex, zoom, rotation, result.image);
-        return result.image;
+    if (draft.isNull()) {
+        // 草稿到达前先显示占位，保持页面尺寸不跳动
+        QImage placeholder(targetSize, QImage::Format_RGB32);
+        placeholder.fill(QColor(80, 80, 80));
+        return placeholder;
     }
 
-    return QImage();
+    QImage scaled = draft.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    scaled.setDevicePixelRatio(1.0);
+    return scaled;
+}
+
+void PDFDocumentTab::scheduleDrafts(const QVector<int>& pages, double zoom, int rotation)
+{
+    PageCacheManager* cache = m_session->pageCache();
+    QVector<int> toRender;
+
+    for (int pageIndex : pages) {
+        if (cache->containsAnyQuality(pageIndex, zoom, rotation)) {
+            continue;
+        }
+
+        QImage thumbnail = thumbnailDraft(pageIndex, zoom, rotation);
+        if (!thumbnail.isNull()) {
+            cache->addPage(pageIndex, zoom, rotation, thumbnail, PageQuality::Draft);
+        } else {
+            toRender.append(pageIndex);
+        }
+    }
+
+    m_session->renderService()->scheduleDrafts(toRender, zoom, rotation);
+}
+
+QImage PDFDocumentTab::thumbnailDraft(int pageIndex, double zoom, int rotation) const
+{
+    // 缩略图总是按 0 度、无纸质效果渲染
+    if (rotation % 360 != 0 || m_session->paperEffectEnabled()) {
+        return QImage();
+    }
+
+    QImage thumbnail = m_session->getThumbnail(pageIndex);
+    if (thumbnail.isNull()) {
+        return QImage();
+    }
+
+    // 宽高比不一致说明缩略图与当前页面方向不符
+    QSize targetSize = m_session->viewHandler()->getPagePixelSize(pageIndex, zoom, rotation);
+    if (targetSize.isEmpty()) {
+        return QImage();
+    }
+
+    double targetAspect = double(targetSize.width()) / targetSize.height();
+    double thumbAspect = double(thumbnail.width()) / thumbnail.height();
+    if (qAbs(targetAspect - thumbAspect) > targetAspect * 0.02) {
+        return QImage();
+    }
+
+    thumbnail.setDevicePixelRatio(1.0);
+    return thumbnail;
 }
 
 void PDFDocumentTab::refreshVisiblePages()
@@ -811,36 +960,192 @@ void PDFDocumentTab::refreshVisiblePages()
         return;
     }
 
+    int scrollX = m_scrollArea->horizontalScrollBar()->value();
     int scrollY = m_scrollArea->verticalScrollBar()->value();
-    QRect visibleRect(0, scrollY, m_scrollArea->viewport()->width(), m_scrollArea->viewport()->height());
+    QRect visibleRect(scrollX, scrollY, m_scrollArea->viewport()->width(), m_scrollArea->viewport()->height());
 
-    // 使用Session的ViewHandler获取可见页面
-    QSet<int> visiblePages = m_session->viewHandler()->getVisiblePages(
+    PDFViewHandler* viewHandler = m_session->viewHandler();
+    const PageLayoutIndex& layout = state->pageLayout();
+
+    // 视口内页面
+    QSet<int> visiblePages = viewHandler->getVisiblePages(
         visibleRect,
+        0,
+        AppConfig::PAGE_MARGIN,
+        layout
+        );
+
+    // 按滚动速度与方向规划预加载：前方多、后方少，快速滑动时暂停
+    double averagePageHeight = layout.isEmpty() ? 0.0
+        : double(layout.totalHeight()) / layout.pageCount();
+
+    PrefetchPlanner::Plan plan = m_prefetchPlanner.plan(
+        visibleRect.height(),
         AppConfig::instance().preloadMargin(),
+        AppConfig::SPECULATIVE_RENDER_PAGES,
+        averagePageHeight
+        );
+
+    // 预加载边距内页面
+    QSet<int> preloadPages = viewHandler->getVisiblePages(
+        visibleRect,
+        plan.marginBefore,
+        plan.marginAfter,
         AppConfig::PAGE_MARGIN,
-        state->pageYPositions(),
-        state->pageHeights()
+        layout
         );
 
     // 标记可见页面
     PageCacheManager* cache = m_session->pageCache();
-    cache->markVisiblePages(visiblePages);
+    cache->markVisiblePages(preloadPages);
+
+    if (preloadPages.isEmpty()) {
+        return;
+    }
 
-    // 渲染可见页面
     double zoom = state->currentZoom();
     int rotation = state->currentRotation();
+    PageRenderService* service = m_session->renderService();
+
+    // 高缩放比例：只渲染视口附近的瓦片，内存随视口大小而非页面大小增长
+    if (PDFViewHandler::useTiledRendering(zoom, m_session->paperEffectEnabled())) {
+        const int tileSize = AppConfig::TILE_SIZE;
+        QRect preloadRect = visibleRect.adjusted(0, -plan.marginBefore, 0, plan.marginAfter);
+
+        // 瓦片缓存上限：预加载区域所需瓦片数的两倍
+        int cols = visibleRect.width() / tileSize + 2;
+        int rows = preloadRect.height() / tileSize + 2;
+        cache->setMaxTiles(cols * rows * 2);
 
-    bool anyRendered = false;
-    for (int pageIndex : visiblePages) {
-        if (!cache->contains(pageIndex, zoom, rotation)) {
-            renderPage(pageIndex);
-            anyRendered = true;
+        QVector<int> pages(preloadPages.begin(), preloadPages.end());
+        std::sort(pages.begin(), pages.end());
+
+        QVector<TileCacheKey> visibleTiles;
+        QVector<TileCacheKey> preloadTiles;
+
+        for (int pageIndex : pages) {
+            QSize pixelSize = viewHandler->getPagePixelSize(pageIndex, zoom, rotation);
+            QRect pageRect((m_pageWidget->width() - pixelSize.width()) / 2,
+                           layout.pageTop(pageIndex) + AppConfig::PAGE_MARGIN,
+                           pixelSize.width(), pixelSize.height());
+
+            const QVector<QPoint> tiles = viewHandler->getTilesInRect(preloadRect, pageRect, tileSize);
+            for (const QPoint& tile : tiles) {
+                TileCacheKey key(pageIndex, zoom, rotation, tile.x(), tile.y());
+                QRect tileRect(pageRect.topLeft() + tile * tileSize, QSize(tileSize, tileSize));
+
+                if (tileRect.intersects(visibleRect)) {
+                    visibleTiles.append(key);
+                } else {
+                    preloadTiles.append(key);
+                }
+            }
         }
+
+        service->scheduleTiles(visibleTiles, PageRenderPriority::Visible, zoom, true);
+        service->scheduleTiles(preloadTiles, PageRenderPriority::Preload, zoom);
+
+        // 瓦片就绪前先以草稿垫底
+        QVector<int> visibleList(visiblePages.begin(), visiblePages.end());
+        std::sort(visibleList.begin(), visibleList.end());
+        scheduleDrafts(visibleList, zoom, rotation);
+        return;
     }
 
-    if (anyRendered) {
-        m_pageWidget->update();
+    QVector<int> visibleList(visiblePages.begin(), visiblePages.end());
+    std::sort(visibleList.begin(), visibleList.end());
+
+    QVector<int> preloadList;
+    for (int pageIndex : preloadPages) {
+        if (!visiblePages.contains(pageIndex)) {
+            preloadList.append(pageIndex);
+        }
+    }
+    std::sort(preloadList.begin(), preloadList.end());
+
+    // 预加载范围之外的推测页面（页数由规划决定，滚动时只在前方）
+    int firstPage = *std::min_element(preloadPages.begin(), preloadPages.end());
+    int lastPage = *std::max_element(preloadPages.begin(), preloadPages.end());
+    QVector<int> speculativeList;
+    for (int i = 1; i <= plan.pagesAfter && lastPage + i < state->pageCount(); ++i) {
+        speculativeList.append(lastPage + i);
+    }
+    for (int i = 1; i <= plan.pagesBefore && firstPage - i >= 0; ++i) {
+        speculativeList.append(firstPage - i);
+    }
+
+    // 预加载效果统计：页面进入视口时是否已有最终渲染
+    QSet<int> cachedPages;
+    for (int pageIndex : visibleList) {
+        if (cache->contains(pageIndex, zoom, rotation)) {
+            cachedPages.insert(pageIndex);
+        }
+    }
+    m_prefetchPlanner.recordVisible(visiblePages, cachedPages);
+    m_prefetchPlanner.recordPrefetch(preloadList + speculativeList);
+
+    // 提交异步渲染请求，新一批请求替换尚未开始的旧请求
+    service->schedule(visibleList, PageRenderPriority::Visible, zoom, rotation, true);
+    service->schedule(preloadList, PageRenderPriority::Preload, zoom, rotation);
+    service->schedule(speculativeList, PageRenderPriority::Speculative, zoom, rotation);
+
+    // 渐进式渲染：可见页面先出草稿（草稿优先级最高，排在最终渲染之前）
+    scheduleDrafts(visibleList, zoom, rotation);
+}
+
+void PDFDocumentTab::onPageRendered(int pageIndex, double zoom, int rotation)
+{
+    const PDFDocumentState* state = m_session->state();
+
+    if (!state->isDocumentLoaded() ||
+        qAbs(state->currentZoom() - zoom) >= 0.001 ||
+        state->currentRotation() != rotation) {
+        return;
+    }
+
+    if (state->isContinuousScroll()) {
+        const PageLayoutIndex& layout = state->pageLayout();
+
+        if (pageIndex < 0 || pageIndex >= layout.pageCount()) {
+            return;
+        }
+
+        // 大文档先按估算尺寸布局：实际渲染高度不同时只更新这一页，不重建整个布局
+        PageCacheManager* cache = m_session->pageCache();
+        if (!PDFViewHandler::useTiledRendering(zoom, m_session->paperEffectEnabled())) {
+            // 只读尺寸：不提升访问顺序、不计入命中
+            QSize imageSize = cache->residentPageSize(pageIndex, zoom, rotation);
+            if (imageSize.isValid() && qAbs(imageSize.height() - layout.pageHeight(pageIndex)) > 1) {
+                m_session->updatePageHeight(pageIndex, imageSize.height());
+                return;
+            }
+        }
+
+        // 只重绘该页所在区域（含阴影）
+        int pageY = layout.pageTop(pageIndex) + AppConfig::PAGE_MARGIN;
+        QRect dirty(0, pageY, m_pageWidget->width(),
+                    layout.pageHeight(pageIndex) + AppConfig::SHADOW_OFFSET);
+        m_pageWidget->update(dirty);
+    } else {
+        // 单页/双页模式：只替换到达的这一页（草稿替换占位，最终渲染替换草稿），不重新调度
+        int currentPage = state->currentPage();
+        bool doublePage = state->currentDisplayMode() == PageDisplayMode::DoublePage;
+
+        int slot = -1;
+        if (pageIndex == currentPage) {
+            slot = 0;
+        } else if (doublePage && pageIndex == currentPage + 1) {
+            slot = 1;
+        }
+        if (slot < 0) {
+            return;
+        }
+
+        bool isFinal = false;
+        QImage image = cachedDisplayImage(pageIndex, zoom, rotation, &isFinal);
+        if (!image.isNull()) {
+            m_pageWidget->setDisplayImage(slot, image);
+        }
     }
 }
 
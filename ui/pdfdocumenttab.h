@@ -8,6 +8,7 @@
 #include "ocrengine.h"
 #include "ocrmanager.h"
 #include "navigationpanel.h"
+#include "prefetchplanner.h"
 
 class PDFDocumentSession;
 class PDFPageWidget;
@@ -16,6 +17,7 @@ class QScrollArea;
 class QSplitter;
 class QProgressBar;
 class OCRFloatingWidget;
+class QTimer;
 
 /**
  * @brief PDF文档标签页 - UI协调层
@@ -85,6 +87,16 @@ public:
      */
     NavigationPanel* navigationPanel() const { return m_navigationPanel; }
 
+    /**
+     * @brief 获取文档会话
+     */
+    PDFDocumentSession* session() const { return m_session; }
+
+    /**
+     * @brief 获取连续滚动预加载的统计信息（调试用）
+     */
+    QString getPrefetchStatistics() const { return m_prefetchPlanner.getStatistics(); }
+
     /**
      * @brief 获取搜索组件（可能返回 nullptr）
      */
@@ -139,7 +151,8 @@ private slots:
     void onZoomChanged(double zoom);
     void onDisplayModeChanged(PageDisplayMode mode);
     void onContinuousScrollChanged(bool continuous);
-    void onPagePositionsChanged(const QVector<int>& positions, const QVector<int>& heights);
+    void onPagePositionsChanged();
+    void onPageHeightChanged(int pageIndex, int delta);
     void onTextSelectionChanged(bool hasSelection);
     void onTextPreloadProgress(int current, int total);
     void onTextPreloadCompleted();
@@ -155,6 +168,8 @@ private slots:
 
     void onScrollValueChanged(int value);
 
+    void onPageRendered(int pageIndex, double zoom, int rotation);
+
     void onOCRHoverTriggered(const QImage& image, const QRect& regionRect, const QPoint& lastHoverPos);
     void onOCRCompleted(const OCRResult& result, const QRect& regionRect, const QPoint& lastHoverPos);
     void onOCRFailed(const QString& error);
@@ -172,9 +187,30 @@ private:
 
     /**
      * @brief 渲染单个页面
+     *
+     * 最终渲染在内存中时直接返回；否则返回放大到目标尺寸的替身（草稿未就绪时为占位图），
+     * 草稿和最终渲染都交给后台，到达后由 onPageRendered 只替换这一页。界面线程不调用 MuPDF
      */
     QImage renderPage(int pageIndex);
 
+    /**
+     * @brief 根据缓存生成页面的显示图像（不提交渲染请求）
+     * @param isFinal 输出：是否为最终渲染
+     */
+    QImage cachedDisplayImage(int pageIndex, double zoom, int rotation, bool* isFinal);
+
+    /**
+     * @brief 渐进式渲染第一阶段：为还没有任何缓存的页面准备草稿
+     *
+     * 能用的缩略图直接作为草稿写入缓存，其余页面提交草稿渲染请求
+     */
+    void scheduleDrafts(const QVector<int>& pages, double zoom, int rotation);
+
+    /**
+     * @brief 以缩略图充当草稿（方向或纸质效果不匹配时返回空图像）
+     */
+    QImage thumbnailDraft(int pageIndex, double zoom, int rotation) const;
+
     /**
      * @brief 刷新连续滚动模式的可见页面
      */
@@ -204,6 +240,10 @@ private:
     // 添加标志位：标记是否是用户主动滚动触发的页面变化
     bool m_isUserScrolling;
 
+    // 连续滚动的方向性预加载
+    PrefetchPlanner m_prefetchPlanner;
+    QTimer* m_prefetchSettleTimer;      // 滚动停下后按静止状态重新规划预加载
+
     OCRFloatingWidget* m_ocrFloatingWidget;  // OCR浮层
     QImage m_lastOCRImage;
     QRect m_lastOCRRegion;
@@ -3,6 +3,8 @@
 #include "pdfdocumentstate.h"
 #include "perthreadmupdfrenderer.h"
 #include "pagecachemanager.h"
+#include "pagerenderservice.h"
+#include "pdfviewhandler.h"
 #include "pdfinteractionhandler.h"
 #include "textselector.h"
 #include "linkmanager.h"
@@ -55,6 +57,19 @@ void PDFPageWidget::setDisplayImages(const QImage& primaryImage, const QImage& s
     update();
 }
 
+void PDFPageWidget::setDisplayImage(int slot, const QImage& image)
+{
+    QImage& target = (slot == 0) ? m_currentImage : m_secondImage;
+    bool sizeChanged = target.size() != image.size();
+    target = image;
+
+    if (sizeChanged) {
+        resize(sizeHint());
+    }
+
+    update();
+}
+
 void PDFPageWidget::refreshVisiblePages()
 {
     // 连续滚动模式：通知Tab需要更新可见区域
@@ -90,30 +105,28 @@ int PDFPageWidget::getPageAtPos(const QPoint& pos, int* pageX, int* pageY) const
     const PDFDocumentState* state = m_session->state();
 
     // 连续滚动模式
-    if (state->isContinuousScroll() && !state->pageYPositions().isEmpty()) {
-        const QVector<int>& positions = state->pageYPositions();
-        const QVector<int>& heights = state->pageHeights();
-
-        for (int i = 0; i < positions.size(); ++i) {
-            int top = positions[i] + margin;
-            int bottom = top + heights[i];
-
-            if (pos.y() >= top && pos.y() <= bottom) {
-                double actualZoom = state->currentZoom();
-                QSizeF pageSize = m_renderer->pageSize(i);
-                if (state->currentRotation() == 90 || state->currentRotation() == 270) {
-                    pageSize.transpose();
-                }
-                int pageWidth = qRound(pageSize.width() * actualZoom);
-                int left = (width() - pageWidth) / 2;
-                int right = left + pageWidth;
-
-                if (pos.x() >= left && pos.x() <= right) {
-                    if (pageX) *pageX = left;
-                    if (pageY) *pageY = top;
-                    return i;
-                }
-            }
+    if (state->isContinuousScroll() && !state->pageLayout().isEmpty()) {
+        const PageLayoutIndex& layout = state->pageLayout();
+
+        // 页面之间只有间距，鼠标所在的页面只可能是这一页
+        int i = layout.pageAt(pos.y() - margin);
+        int top = layout.pageTop(i) + margin;
+        int bottom = top + layout.pageHeight(i);
+
+        if (pos.y() < top || pos.y() > bottom) {
+            return -1;
+        }
+
+        int pageWidth = PerThreadMuPDFRenderer::pixelSize(m_renderer->pageSize(i),
+                                                          state->currentZoom(),
+                                                          state->currentRotation()).width();
+        int left = (width() - pageWidth) / 2;
+        int right = left + pageWidth;
+
+        if (pos.x() >= left && pos.x() <= right) {
+            if (pageX) *pageX = left;
+            if (pageY) *pageY = top;
+            return i;
         }
         return -1;
     }
@@ -180,12 +193,11 @@ QString PDFPageWidget::getCacheStatistics() const
     return m_cacheManager->getStatistics();
 }
 
-
 QSize PDFPageWidget::sizeHint() const
 {
     const PDFDocumentState* state = m_session->state();
 
-    if (m_currentImage.isNull() && state->pageYPositions().isEmpty()) {
+    if (m_currentImage.isNull() && state->pageLayout().isEmpty()) {
         QSize viewportSize = getViewportSize();
         if (viewportSize.isValid() && viewportSize.width() > 0 && viewportSize.height() > 0) {
             return viewportSize;
@@ -196,20 +208,16 @@ QSize PDFPageWidget::sizeHint() const
     const int margin = AppConfig::PAGE_MARGIN;
 
     // 连续滚动模式
-    if (state->isContinuousScroll() && !state->pageYPositions().isEmpty()) {
+    if (state->isContinuousScroll() && !state->pageLayout().isEmpty()) {
         int maxWidth = 0;
 
         if (m_renderer && m_renderer->isDocumentLoaded()) {
-            QSizeF pageSize = m_renderer->pageSize(0);
-            if (state->currentRotation() == 90 || state->currentRotation() == 270) {
-                pageSize.transpose();
-            }
-            maxWidth = qRound(pageSize.width() * state->currentZoom());
+            maxWidth = PerThreadMuPDFRenderer::pixelSize(m_renderer->pageSize(0),
+                                                         state->currentZoom(),
+                                                         state->currentRotation()).width();
         }
 
-        const QVector<int>& positions = state->pageYPositions();
-        const QVector<int>& heights = state->pageHeights();
-        int totalHeight = positions.last() + heights.last();
+        int totalHeight = state->pageLayout().totalHeight();
         return QSize(maxWidth + 2 * margin, totalHeight + 2 * margin);
     }
 
@@ -233,7 +241,7 @@ void PDFPageWidget::paintEvent(QPaintEvent* event)
     const PDFDocumentState* state = m_session->state();
 
     // 连续滚动模式
-    if (state->isContinuousScroll() && !state->pageYPositions().isEmpty()) {
+    if (state->isContinuousScroll() && !state->pageLayout().isEmpty()) {
         paintContinuousMode(painter, event->rect());
         return;
     }
@@ -309,53 +317,120 @@ void PDFPageWidget::paintContinuousMode(QPainter& painter, const QRect& visibleR
     double actualZoom = state->currentZoom();
     int rotation = state->currentRotation();
 
-    QList<PageCacheKey> cachedKeys = m_cacheManager->cachedKeys();
+    if (PDFViewHandler::useTiledRendering(actualZoom, m_session->paperEffectEnabled())) {
+        paintContinuousTiles(painter, visibleRect);
+        return;
+    }
 
-    for (const PageCacheKey& key : cachedKeys) {
-        int pageIndex = key.pageIndex;
+    // 只遍历与重绘区域相交的页面，代价与文档页数无关
+    const PageLayoutIndex& layout = state->pageLayout();
+    int firstPage = 0;
+    int lastPage = -1;
+    if (!layout.pagesInRange(visibleRect.top() - margin, visibleRect.bottom() - margin,
+                             &firstPage, &lastPage)) {
+        return;
+    }
 
-        if (qAbs(key.zoom - actualZoom) >= 0.001 || key.rotation != rotation) {
-            continue;
-        }
+    painter.setPen(Qt::white);
+    QFont font = painter.font();
+    font.setPointSize(10);
+    painter.setFont(font);
 
-        if (pageIndex >= state->pageYPositions().size()) {
+    QVector<int> compressedPages;
+
+    for (int i = firstPage; i <= lastPage; ++i) {
+        int pageY = layout.pageTop(i) + margin;
+
+        // 最终渲染只取内存中的，绘制时从不解码
+        QImage pageImage = m_cacheManager->getResidentPage(i, actualZoom, rotation);
+        if (pageImage.isNull() && m_cacheManager->contains(i, actualZoom, rotation)) {
+            compressedPages.append(i);
+        }
+        if (!pageImage.isNull()) {
+            int pageX = (width() - pageImage.width()) / 2;
+            drawPageImage(painter, pageImage, pageX, pageY);
+            drawOverlays(painter, i, pageX, pageY, actualZoom);
             continue;
         }
 
-        QImage pageImage = m_cacheManager->getPage(pageIndex, actualZoom, rotation);
-        if (pageImage.isNull()) {
-            continue;
+        // 最终渲染未就绪时，先缩放显示替身（其他缩放下的渲染或草稿）
+        QImage draft = standInImage(i, actualZoom, rotation);
+        QSize pixelSize = draft.isNull()
+            ? QSize()
+            : m_session->viewHandler()->getPagePixelSize(i, actualZoom, rotation);
+
+        if (!pixelSize.isEmpty()) {
+            QRect targetRect((width() - pixelSize.width()) / 2, pageY,
+                             pixelSize.width(), pixelSize.height());
+            painter.fillRect(targetRect.translated(AppConfig::SHADOW_OFFSET, AppConfig::SHADOW_OFFSET),
+                             QColor(0, 0, 0, 100));
+            painter.save();
+            painter.setRenderHint(QPainter::SmoothPixmapTransform);
+            painter.drawImage(targetRect, draft);
+            painter.restore();
+            drawOverlays(painter, i, targetRect.x(), targetRect.y(), actualZoom);
+        } else {
+            QRect placeholderRect(margin, pageY, width() - 2 * margin, layout.pageHeight(i));
+            drawPagePlaceholder(painter, placeholderRect, i);
         }
+    }
 
-        int pageY = state->pageYPositions()[pageIndex] + margin;
-        int pageX = (width() - pageImage.width()) / 2;
+    // 只在压缩层中的页面交给渲染服务解压（已排队的会被跳过），完成后重绘
+    if (!compressedPages.isEmpty()) {
+        m_session->renderService()->schedule(compressedPages, PageRenderPriority::Visible,
+                                             actualZoom, rotation);
+    }
+}
 
-        int pageBottom = pageY + pageImage.height();
-        if (pageBottom >= visibleRect.top() && pageY <= visibleRect.bottom()) {
-            drawPageImage(painter, pageImage, pageX, pageY);
-            drawOverlays(painter, pageIndex, pageX, pageY, actualZoom);
-        }
+void PDFPageWidget::paintContinuousTiles(QPainter& painter, const QRect& visibleRect)
+{
+    const int margin = AppConfig::PAGE_MARGIN;
+    const int tileSize = AppConfig::TILE_SIZE;
+    const PDFDocumentState* state = m_session->state();
+    PDFViewHandler* viewHandler = m_session->viewHandler();
+    double actualZoom = state->currentZoom();
+    int rotation = state->currentRotation();
+
+    const PageLayoutIndex& layout = state->pageLayout();
+    int firstPage = 0;
+    int lastPage = -1;
+    if (!layout.pagesInRange(visibleRect.top() - margin, visibleRect.bottom() - margin,
+                             &firstPage, &lastPage)) {
+        return;
     }
 
-    // 绘制占位符
-    painter.setPen(Qt::white);
-    QFont font = painter.font();
-    font.setPointSize(10);
-    painter.setFont(font);
+    for (int i = firstPage; i <= lastPage; ++i) {
+        int pageY = layout.pageTop(i) + margin;
+
+        QSize pixelSize = viewHandler->getPagePixelSize(i, actualZoom, rotation);
+        QRect pageRect((width() - pixelSize.width()) / 2, pageY,
+                       pixelSize.width(), pixelSize.height());
 
-    const QVector<int>& positions = state->pageYPositions();
-    const QVector<int>& heights = state->pageHeights();
+        // 阴影和未就绪瓦片的底色
+        painter.fillRect(pageRect.translated(AppConfig::SHADOW_OFFSET, AppConfig::SHADOW_OFFSET),
+                         QColor(0, 0, 0, 100));
+        painter.fillRect(pageRect, QColor(80, 80, 80));
 
-    for (int i = 0; i < positions.size(); ++i) {
-        if (!m_cacheManager->contains(i, actualZoom, rotation)) {
-            int pageY = positions[i] + margin;
-            int pageHeight = heights[i];
+        // 替身垫底，瓦片就绪后逐块覆盖
+        QImage draft = standInImage(i, actualZoom, rotation);
+        if (!draft.isNull()) {
+            painter.save();
+            painter.setRenderHint(QPainter::SmoothPixmapTransform);
+            painter.drawImage(pageRect, draft);
+            painter.restore();
+        }
 
-            if (pageY + pageHeight >= visibleRect.top() && pageY <= visibleRect.bottom()) {
-                QRect placeholderRect(margin, pageY, width() - 2 * margin, pageHeight);
-                drawPagePlaceholder(painter, placeholderRect, i);
+        // 只合成与重绘区域相交的瓦片
+        const QVector<QPoint> tiles = viewHandler->getTilesInRect(visibleRect, pageRect, tileSize);
+        for (const QPoint& tile : tiles) {
+            QImage tileImage = m_cacheManager->getTile(
+                TileCacheKey(i, actualZoom, rotation, tile.x(), tile.y()));
+            if (!tileImage.isNull()) {
+                painter.drawImage(pageRect.topLeft() + tile * tileSize, tileImage);
             }
         }
+
+        drawOverlays(painter, i, pageRect.x(), pageRect.y(), actualZoom);
     }
 }
 
@@ -369,6 +444,19 @@ void PDFPageWidget::drawPageImage(QPainter& painter, const QImage& image, int x,
     painter.drawImage(x, y, image);
 }
 
+QImage PDFPageWidget::standInImage(int pageIndex, double zoom, int rotation)
+{
+    // 其他缩放下的最终渲染放大倍数不超过草稿的分辨率损失时更清晰，优先使用
+    double scale = 1.0;
+    QImage nearest = m_cacheManager->getNearestZoomPage(pageIndex, zoom, rotation, &scale);
+    if (!nearest.isNull() && scale <= 1.0 / AppConfig::DRAFT_ZOOM_RATIO) {
+        return nearest;
+    }
+
+    QImage draft = m_cacheManager->getPageOrDraft(pageIndex, zoom, rotation);
+    return draft.isNull() ? nearest : draft;
+}
+
 void PDFPageWidget::drawPagePlaceholder(QPainter& painter, const QRect& rect, int pageIndex)
 {
     painter.fillRect(rect, QColor(80, 80, 80));
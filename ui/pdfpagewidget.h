@@ -39,6 +39,12 @@ public:
      */
     void setDisplayImages(const QImage& primaryImage, const QImage& secondaryImage = QImage());
 
+    /**
+     * @brief 只替换其中一页的图像（后台渲染到达时使用）
+     * @param slot 0 为主页面，1 为双页模式的第二页
+     */
+    void setDisplayImage(int slot, const QImage& image);
+
     /**
      * @brief 刷新连续滚动模式的可见页面
      */
@@ -150,10 +156,14 @@ private:
     void paintSinglePageMode(QPainter& painter);
     void paintDoublePageMode(QPainter& painter);
     void paintContinuousMode(QPainter& painter, const QRect& visibleRect);
+    void paintContinuousTiles(QPainter& painter, const QRect& visibleRect);
 
     void drawPageImage(QPainter& painter, const QImage& image, int x, int y);
     void drawPagePlaceholder(QPainter& painter, const QRect& rect, int pageIndex);
 
+    // 最终渲染未就绪时的替身：其他缩放下的最终渲染或草稿，调用方缩放绘制
+    QImage standInImage(int pageIndex, double zoom, int rotation);
+
     // 绘制叠加层（高亮、链接等）
     void drawOverlays(QPainter& painter, int pageIndex, int pageX, int pageY, double zoom);
     void drawSearchHighlights(QPainter& painter, int pageIndex, int pageX, int pageY, double zoom);
@@ -8,6 +8,13 @@
 #include <QKeyEvent>
 #include <QStyle>
 
+namespace {
+
+// 停止输入多久后开始搜索（毫秒）
+constexpr int TYPING_DELAY_MS = 250;
+
+} // namespace
+
 SearchWidget::SearchWidget(PDFDocumentSession* session, QWidget* parent)
     : QWidget(parent)
     , m_session(session)
@@ -67,6 +74,20 @@ void SearchWidget::setupUI()
     m_wholeWordsCheck = new QCheckBox(tr("整个单词"), this);
     mainLayout->addWidget(m_wholeWordsCheck);
 
+    m_modeCombo = new QComboBox(this);
+    m_modeCombo->addItem(tr("精确"), int(SearchMode::Exact));
+    m_modeCombo->addItem(tr("正则"), int(SearchMode::Regex));
+    m_modeCombo->addItem(tr("模糊"), int(SearchMode::Fuzzy));
+    m_modeCombo->setToolTip(tr("匹配方式：精确、正则表达式、近似匹配（适用于扫描识别或编码较差的文档）"));
+    mainLayout->addWidget(m_modeCombo);
+
+    m_maxEditsSpin = new QSpinBox(this);
+    m_maxEditsSpin->setRange(1, 3);
+    m_maxEditsSpin->setValue(1);
+    m_maxEditsSpin->setToolTip(tr("模糊匹配允许的最大差异字符数"));
+    m_maxEditsSpin->setEnabled(false);
+    mainLayout->addWidget(m_maxEditsSpin);
+
     mainLayout->addStretch();
 
     m_closeButton = new QToolButton(this);
@@ -85,9 +106,14 @@ void SearchWidget::setupUI()
 
 void SearchWidget::setupConnections()
 {
-    // 搜索输入
+    // 搜索输入：边输入边搜索，回车立即搜索
+    m_typingTimer.setSingleShot(true);
+    m_typingTimer.setInterval(TYPING_DELAY_MS);
+    connect(&m_typingTimer, &QTimer::timeout, this, &SearchWidget::performSearch);
+    connect(m_searchCombo->lineEdit(), &QLineEdit::textEdited,
+            &m_typingTimer, qOverload<>(&QTimer::start));
     connect(m_searchCombo->lineEdit(), &QLineEdit::returnPressed,
-            this, &SearchWidget::performSearch);
+            this, &SearchWidget::onReturnPressed);
 
     // 导航按钮
     connect(m_previousButton, &QPushButton::clicked, this, &SearchWidget::findPrevious);
@@ -96,6 +122,8 @@ void SearchWidget::setupConnections()
     // 选项变化时重新搜索
     connect(m_caseSensitiveCheck, &QCheckBox::toggled, this, &SearchWidget::performSearch);
     connect(m_wholeWordsCheck, &QCheckBox::toggled, this, &SearchWidget::performSearch);
+    connect(m_modeCombo, &QComboBox::currentIndexChanged, this, &SearchWidget::onModeChanged);
+    connect(m_maxEditsSpin, &QSpinBox::valueChanged, this, &SearchWidget::performSearch);
 
     // 关闭按钮
     connect(m_closeButton, &QToolButton::clicked, this, &SearchWidget::closeRequested);
@@ -105,6 +133,8 @@ void SearchWidget::setupConnections()
             this, &SearchWidget::onSearchCompleted);
     connect(m_session, &PDFDocumentSession::searchProgressUpdated,
             this, &SearchWidget::onSearchProgress);
+    connect(m_session, &PDFDocumentSession::searchError,
+            this, &SearchWidget::onSearchError);
     connect(m_session, &PDFDocumentSession::searchCancelled,
             this, [this]() {
                 m_isSearching = false;
@@ -112,8 +142,21 @@ void SearchWidget::setupConnections()
             });
 }
 
+void SearchWidget::onReturnPressed()
+{
+    performSearch();
+
+    // 只记录确认过的查询，输入过程中的中间结果不进入历史
+    QString query = m_searchCombo->currentText().trimmed();
+    if (!query.isEmpty() && m_session->interactionHandler()) {
+        m_session->interactionHandler()->addSearchHistory(query);
+    }
+}
+
 void SearchWidget::performSearch()
 {
+    m_typingTimer.stop();
+
     QString query = m_searchCombo->currentText().trimmed();
 
     if (query.isEmpty()) {
@@ -129,20 +172,20 @@ void SearchWidget::performSearch()
 
 
     if (m_session) {
-        bool caseSensitive = m_caseSensitiveCheck->isChecked();
-        bool wholeWords = m_wholeWordsCheck->isChecked();
+        SearchOptions options;
+        options.caseSensitive = m_caseSensitiveCheck->isChecked();
+        options.wholeWords = m_wholeWordsCheck->isChecked();
+        options.mode = static_cast<SearchMode>(m_modeCombo->currentData().toInt());
+        options.maxEdits = m_maxEditsSpin->value();
 
         int startPage = m_session->state()->currentPage();
 
-        m_session->startSearch(query, caseSensitive, wholeWords, startPage);
-
-        if (m_session->interactionHandler()) {
-            m_session->interactionHandler()->addSearchHistory(query);
-        }
+        m_session->startSearch(query, options, startPage);
     }
 
     m_isSearching = true;
     m_matchLabel->setText(tr("搜索中..."));
+    m_matchLabel->setToolTip(QString());
     updateUI();
 }
 
@@ -216,6 +259,20 @@ void SearchWidget::onSearchProgress(int currentPage, int totalPages, int matchCo
                               .arg(matchCount));
 }
 
+void SearchWidget::onSearchError(const QString& error)
+{
+    m_isSearching = false;
+    updateUI();
+    m_matchLabel->setText(tr("无效的查询"));
+    m_matchLabel->setToolTip(error);
+}
+
+void SearchWidget::onModeChanged()
+{
+    m_maxEditsSpin->setEnabled(m_modeCombo->currentData().toInt() == int(SearchMode::Fuzzy));
+    performSearch();
+}
+
 void SearchWidget::navigateToResult(const SearchResult& result)
 {
     if (!result.isValid()) {
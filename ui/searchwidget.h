@@ -7,7 +7,9 @@
 #include <QCheckBox>
 #include <QLabel>
 #include <QComboBox>
+#include <QSpinBox>
 #include <QToolButton>
+#include <QTimer>
 #include "datastructure.h"
 
 class PDFDocumentSession;
@@ -17,7 +19,7 @@ class PDFDocumentSession;
  *
  * 职责：
  * 1. 提供搜索 UI（输入框、按钮、选项）
- * 2. 与 Session 交互进行搜索
+ * 2. 与 Session 交互进行搜索（边输入边搜索，回车立即搜索并记入历史）
  * 3. 显示搜索进度和结果
  *
  * 注意：不再直接操作 PageWidget，所有导航通过 Session
@@ -43,8 +45,11 @@ signals:
 
 private slots:
     void performSearch();
+    void onReturnPressed();
     void onSearchCompleted(const QString& query, int totalMatches);
     void onSearchProgress(int currentPage, int totalPages, int matchCount);
+    void onSearchError(const QString& error);
+    void onModeChanged();
 
 protected:
     void keyPressEvent(QKeyEvent* event) override;
@@ -64,8 +69,13 @@ private:
     QLabel* m_matchLabel;
     QCheckBox* m_caseSensitiveCheck;
     QCheckBox* m_wholeWordsCheck;
+    QComboBox* m_modeCombo;
+    QSpinBox* m_maxEditsSpin;
     QToolButton* m_closeButton;
 
+    // 边输入边搜索：停止输入一段时间后才开始
+    QTimer m_typingTimer;
+
     bool m_isSearching;
 };
 
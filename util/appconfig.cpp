@@ -24,11 +24,17 @@ AppConfig& AppConfig::instance()
 void AppConfig::loadDefaults()
 {
     // 缓存配置默认值
-    m_maxCacheSize = 10;
+    m_pageCacheHighWatermarkMB = 512;
+    m_pageCacheLowWatermarkMB = 384;
+    m_compressedCacheMB = 256;
+    m_globalCacheBudgetMB = 1536;
+    m_diskCacheEnabled = false;
+    m_diskCacheMB = 2048;
     m_preloadMargin = 500;
 
     // 性能配置默认值
     m_resizeDebounceDelay = 150;
+    m_fastBlitFormat = false;
 
     // UI配置默认值
     m_backgroundColor = QColor(64, 64, 64);
@@ -43,12 +49,21 @@ void AppConfig::load()
 {
     return;
     // 加载缓存配置
-    m_maxCacheSize = m_settings.value("Cache/MaxSize", m_maxCacheSize).toInt();
+    setPageCacheHighWatermarkMB(m_settings.value("Cache/HighWatermarkMB",
+                                                 m_pageCacheHighWatermarkMB).toInt());
+    setPageCacheLowWatermarkMB(m_settings.value("Cache/LowWatermarkMB",
+                                                m_pageCacheLowWatermarkMB).toInt());
+    setCompressedCacheMB(m_settings.value("Cache/CompressedMB", m_compressedCacheMB).toInt());
+    setGlobalCacheBudgetMB(m_settings.value("Cache/GlobalBudgetMB", m_globalCacheBudgetMB).toInt());
+    m_diskCacheEnabled = m_settings.value("Cache/DiskEnabled", m_diskCacheEnabled).toBool();
+    setDiskCacheMB(m_settings.value("Cache/DiskMB", m_diskCacheMB).toInt());
     m_preloadMargin = m_settings.value("Cache/PreloadMargin", m_preloadMargin).toInt();
 
     // 加载性能配置
     m_resizeDebounceDelay = m_settings.value("Performance/ResizeDebounceDelay",
                                              m_resizeDebounceDelay).toInt();
+    m_fastBlitFormat = m_settings.value("Performance/FastBlitFormat",
+                                        m_fastBlitFormat).toBool();
 
     // 加载UI配置
     m_backgroundColor = m_settings.value("UI/BackgroundColor",
@@ -66,11 +81,17 @@ void AppConfig::save()
 {
     return;
     // 保存缓存配置
-    m_settings.setValue("Cache/MaxSize", m_maxCacheSize);
+    m_settings.setValue("Cache/HighWatermarkMB", m_pageCacheHighWatermarkMB);
+    m_settings.setValue("Cache/LowWatermarkMB", m_pageCacheLowWatermarkMB);
+    m_settings.setValue("Cache/CompressedMB", m_compressedCacheMB);
+    m_settings.setValue("Cache/GlobalBudgetMB", m_globalCacheBudgetMB);
+    m_settings.setValue("Cache/DiskEnabled", m_diskCacheEnabled);
+    m_settings.setValue("Cache/DiskMB", m_diskCacheMB);
     m_settings.setValue("Cache/PreloadMargin", m_preloadMargin);
 
     // 保存性能配置
     m_settings.setValue("Performance/ResizeDebounceDelay", m_resizeDebounceDelay);
+    m_settings.setValue("Performance/FastBlitFormat", m_fastBlitFormat);
 
     // 保存UI配置
     m_settings.setValue("UI/BackgroundColor", m_backgroundColor);
@@ -88,12 +109,52 @@ void AppConfig::resetToDefaults()
     m_settings.clear();
     loadDefaults();
     save();
+    emit cacheConfigChanged();
 }
 
-void AppConfig::setMaxCacheSize(int size)
+void AppConfig::setPageCacheHighWatermarkMB(int mb)
 {
-    if (size > 0 && size <= 100) {
-        m_maxCacheSize = size;
+    if (mb >= 32 && mb <= 16384) {
+        m_pageCacheHighWatermarkMB = mb;
+        m_pageCacheLowWatermarkMB = qMin(m_pageCacheLowWatermarkMB, mb);
+    }
+}
+
+void AppConfig::setPageCacheLowWatermarkMB(int mb)
+{
+    if (mb >= 0) {
+        m_pageCacheLowWatermarkMB = qMin(mb, m_pageCacheHighWatermarkMB);
+    }
+}
+
+void AppConfig::setCompressedCacheMB(int mb)
+{
+    if (mb >= 0 && mb <= 8192) {
+        m_compressedCacheMB = mb;
+    }
+}
+
+void AppConfig::setGlobalCacheBudgetMB(int mb)
+{
+    if (mb >= 128 && mb <= 65536 && mb != m_globalCacheBudgetMB) {
+        m_globalCacheBudgetMB = mb;
+        emit cacheConfigChanged();
+    }
+}
+
+void AppConfig::setDiskCacheEnabled(bool enabled)
+{
+    if (enabled != m_diskCacheEnabled) {
+        m_diskCacheEnabled = enabled;
+        emit cacheConfigChanged();
+    }
+}
+
+void AppConfig::setDiskCacheMB(int mb)
+{
+    if (mb >= 64 && mb <= 65536 && mb != m_diskCacheMB) {
+        m_diskCacheMB = mb;
+        emit cacheConfigChanged();
     }
 }
 
@@ -111,6 +172,11 @@ void AppConfig::setResizeDebounceDelay(int delay)
     }
 }
 
+QImage::Format AppConfig::renderImageFormat() const
+{
+    return m_fastBlitFormat ? QImage::Format_RGB32 : QImage::Format_RGB888;
+}
+
 void AppConfig::setBackgroundColor(const QColor& color)
 {
     m_backgroundColor = color;
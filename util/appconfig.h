@@ -1,10 +1,12 @@
 #ifndef APPCONFIG_H
 #define APPCONFIG_H
 
+#include <QObject>
 #include <QSettings>
 #include <QString>
 #include <QColor>
 #include <QSize>
+#include <QImage>
 #include <QCoreApplication>
 
 /**
@@ -18,8 +20,10 @@
  *
  * 使用单例模式，通过 QSettings 持久化配置
  */
-class AppConfig
+class AppConfig : public QObject
 {
+    Q_OBJECT
+
 public:
     /**
      * @brief 获取单例实例
@@ -43,6 +47,30 @@ public:
     /// 默认DPI
     static constexpr int DEFAULT_DPI = 72;
 
+    /// 主视图渲染工作线程数
+    static constexpr int RENDER_WORKER_COUNT = 2;
+
+    /// 推测渲染页数（预加载范围之外，每个方向）
+    static constexpr int SPECULATIVE_RENDER_PAGES = 1;
+
+    /// 瓦片边长（像素）
+    static constexpr int TILE_SIZE = 512;
+
+    /// 达到此缩放比例后连续模式改为按瓦片渲染可见区域
+    static constexpr double TILE_ZOOM_THRESHOLD = 2.0;
+
+    /// 瓦片缓存默认上限（视口变化时按视口大小重新估算）
+    static constexpr int MAX_TILE_CACHE_COUNT = 96;
+
+    /// 渐进式渲染草稿的分辨率（相对目标缩放比例）
+    static constexpr double DRAFT_ZOOM_RATIO = 0.25;
+
+    /// 每个渲染器的显示列表缓存预算（字节）
+    static constexpr qint64 DISPLAY_LIST_CACHE_BYTES = 32LL * 1024 * 1024;
+
+    /// 达到此页数后先按估算尺寸布局，精确页面尺寸由后台扫描补齐
+    static constexpr int GEOMETRY_SCAN_MIN_PAGES = 200;
+
     // ========== 布局配置 ==========
 
     /// 页面边距
@@ -84,9 +112,55 @@ public:
 
     // ========== 缓存配置 ==========
 
-    /// 最大缓存页面数
-    int maxCacheSize() const { return m_maxCacheSize; }
-    void setMaxCacheSize(int size);
+    /**
+     * @brief 页面缓存高水位（MB）
+     *
+     * 页面与瓦片按 QImage::sizeInBytes() 计入，超过高水位后淘汰到低水位，
+     * 避免每次插入都触发淘汰
+     */
+    int pageCacheHighWatermarkMB() const { return m_pageCacheHighWatermarkMB; }
+    void setPageCacheHighWatermarkMB(int mb);
+
+    /// 页面缓存低水位（MB），不高于高水位
+    int pageCacheLowWatermarkMB() const { return m_pageCacheLowWatermarkMB; }
+    void setPageCacheLowWatermarkMB(int mb);
+
+    /// 以字节为单位的高/低水位
+    qint64 pageCacheHighWatermarkBytes() const { return qint64(m_pageCacheHighWatermarkMB) * 1024 * 1024; }
+    qint64 pageCacheLowWatermarkBytes() const { return qint64(m_pageCacheLowWatermarkMB) * 1024 * 1024; }
+
+    /**
+     * @brief 压缩页面缓存预算（MB），0 表示关闭
+     *
+     * 从内存缓存淘汰的页面以 QOI 无损压缩后保留在第二层，再次访问时解压即可，
+     * 不必重新渲染。按压缩后的字节数计入，与页面缓存的高/低水位相互独立
+     */
+    int compressedCacheMB() const { return m_compressedCacheMB; }
+    void setCompressedCacheMB(int mb);
+    qint64 compressedCacheBytes() const { return qint64(m_compressedCacheMB) * 1024 * 1024; }
+
+    /**
+     * @brief 是否启用磁盘渲染缓存
+     *
+     * 最终渲染按文档指纹保存在用户缓存目录，重新打开同一文档时直接读取
+     */
+    bool diskCacheEnabled() const { return m_diskCacheEnabled; }
+    void setDiskCacheEnabled(bool enabled);
+
+    /// 磁盘渲染缓存容量（MB），超过后按 LRU 删除
+    int diskCacheMB() const { return m_diskCacheMB; }
+    void setDiskCacheMB(int mb);
+    qint64 diskCacheBytes() const { return qint64(m_diskCacheMB) * 1024 * 1024; }
+
+    /**
+     * @brief 所有标签页共享的缓存总预算（MB）
+     *
+     * 页面缓存、压缩层、文本缓存和缩略图合计，超出后由 CacheGovernor
+     * 优先从后台标签页释放
+     */
+    int globalCacheBudgetMB() const { return m_globalCacheBudgetMB; }
+    void setGlobalCacheBudgetMB(int mb);
+    qint64 globalCacheBudgetBytes() const { return qint64(m_globalCacheBudgetMB) * 1024 * 1024; }
 
     /// 预加载边距（像素）
     int preloadMargin() const { return m_preloadMargin; }
@@ -98,6 +172,22 @@ public:
     int resizeDebounceDelay() const { return m_resizeDebounceDelay; }
     void setResizeDebounceDelay(int delay);
 
+    /**
+     * @brief 渲染输出是否使用快速绘制格式
+     *
+     * 启用时渲染为 Format_RGB32，光栅引擎绘制时直接内存拷贝；
+     * 关闭时渲染为 Format_RGB888，内存少 25%，但每次绘制都要转换格式。
+     * 默认关闭：页面缓存、压缩层和磁盘缓存的预算都按 RGB888 估算，
+     * 启用后同样的预算能容纳的页面约少四分之一。
+     *
+     * 只在启动时从设置项 Performance/FastBlitFormat 读取，运行中不可修改：
+     * 渲染器只在构造时读取格式，各级缓存中的页面也不会随之转换
+     */
+    bool fastBlitFormat() const { return m_fastBlitFormat; }
+
+    /// 根据 fastBlitFormat 返回渲染输出格式
+    QImage::Format renderImageFormat() const;
+
     // ========== UI配置 ==========
 
     /// 背景颜色
@@ -181,6 +271,12 @@ public:
      */
     void resetToDefaults();
 
+signals:
+    /**
+     * @brief 全局缓存配置（磁盘缓存开关/容量、缓存总预算）发生变化
+     */
+    void cacheConfigChanged();
+
 
 
 private:
@@ -197,11 +293,17 @@ private:
     QSettings m_settings;
 
     // 缓存配置
-    int m_maxCacheSize;
+    int m_pageCacheHighWatermarkMB;
+    int m_pageCacheLowWatermarkMB;
+    int m_compressedCacheMB;
+    int m_globalCacheBudgetMB;
+    bool m_diskCacheEnabled;
+    int m_diskCacheMB;
     int m_preloadMargin;
 
     // 性能配置
     int m_resizeDebounceDelay;
+    bool m_fastBlitFormat;
 
     // UI配置
     QColor m_backgroundColor;
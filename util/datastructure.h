@@ -6,9 +6,11 @@
 #include <QString>
 #include <QVector>
 #include <QImage>
+#include "pagetextdata.h"
 
 struct RenderResult {
     bool success = false;
+    bool cancelled = false;     // 被取消令牌中止（不算失败）
     QImage image;
     QString errorMessage;
 };
@@ -41,41 +43,21 @@ enum class PageDisplayMode {
     DoublePage
 };
 
-// 文本字符及其位置信息
-struct TextChar {
-    QChar character;
-    QRectF bbox;  // 字符的边界框
-};
-
-// 文本行
-struct TextLine {
-    QVector<TextChar> chars;
-    QRectF bbox;  // 行的边界框
-};
-
-// 文本块
-struct TextBlock {
-    QVector<TextLine> lines;
-    QRectF bbox;  // 块的边界框
-};
-
-// 页面的完整文本信息（纯数据，不包含 MuPDF 对象）
-struct PageTextData {
-    int pageIndex;
-    QVector<TextBlock> blocks;
-    QString fullText;  // 完整文本（用于快速搜索）
+// ========== 搜索选项 ==========
 
-    PageTextData() : pageIndex(-1) {}
-    bool isEmpty() const { return blocks.isEmpty(); }
-    bool isValid() const { return pageIndex >= 0; }
+// 匹配方式
+enum class SearchMode {
+    Exact,      // 精确子串
+    Regex,      // 正则表达式
+    Fuzzy       // 近似匹配（编辑距离）
 };
 
-// ========== 搜索选项 ==========
-
 struct SearchOptions {
     bool caseSensitive = false;
     bool wholeWords = false;
     int maxResults = 1000;
+    SearchMode mode = SearchMode::Exact;
+    int maxEdits = 1;       // 模糊匹配允许的最大编辑距离
 };
 
 // ========== 搜索结果 ==========
@@ -0,0 +1,190 @@
+#include "fuzzymatcher.h"
+#include <QVector>
+#include <QtGlobal>
+#include <algorithm>
+
+namespace {
+
+// 位并行算法一个机器字能容纳的模式长度
+constexpr int MAX_BIT_PARALLEL_LENGTH = 64;
+
+} // namespace
+
+FuzzyMatcher::FuzzyMatcher()
+    : m_maxEdits(0)
+{
+    m_asciiPeq.fill(0);
+}
+
+FuzzyMatcher::FuzzyMatcher(const QString& pattern, int maxEdits)
+    : m_pattern(pattern)
+    , m_maxEdits(qBound(0, maxEdits, qMax(0, int(pattern.size()) - 1)))
+{
+    m_asciiPeq.fill(0);
+
+    if (m_pattern.size() > MAX_BIT_PARALLEL_LENGTH) {
+        return;
+    }
+
+    for (int i = 0; i < m_pattern.size(); ++i) {
+        const char16_t ch = m_pattern[i].unicode();
+        const quint64 bit = quint64(1) << i;
+        if (ch < 128) {
+            m_asciiPeq[ch] |= bit;
+        } else {
+            m_otherPeq[ch] |= bit;
+        }
+    }
+}
+
+bool FuzzyMatcher::findNext(QStringView text, qsizetype from,
+                            qsizetype* start, qsizetype* length, int* distance) const
+{
+    if (!isValid() || from < 0 || from >= text.size()) {
+        return false;
+    }
+
+    int score = 0;
+    qsizetype end = (m_pattern.size() <= MAX_BIT_PARALLEL_LENGTH)
+        ? findEndBitParallel(text, from, &score)
+        : findEndDynamic(text, from, &score);
+    if (end < 0) {
+        return false;
+    }
+
+    qsizetype begin = findStart(text, from, end);
+    if (start) {
+        *start = begin;
+    }
+    if (length) {
+        *length = end - begin + 1;
+    }
+    if (distance) {
+        *distance = score;
+    }
+    return true;
+}
+
+qsizetype FuzzyMatcher::findEndBitParallel(QStringView text, qsizetype from, int* distance) const
+{
+    const int patternLength = m_pattern.size();
+    const quint64 highBit = quint64(1) << (patternLength - 1);
+
+    // 垂直差分向量：Pv/Mv 的第 i 位表示第 i 行比上一行 +1/-1
+    quint64 pv = ~quint64(0);
+    quint64 mv = 0;
+    int score = patternLength;
+
+    qsizetype bestEnd = -1;
+    int bestScore = m_maxEdits + 1;
+
+    for (qsizetype j = from; j < text.size(); ++j) {
+        const quint64 eq = peq(text[j].unicode());
+        const quint64 xv = eq | mv;
+        const quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+        quint64 ph = mv | ~(xh | pv);
+        quint64 mh = pv & xh;
+
+        if (ph & highBit) {
+            score++;
+        } else if (mh & highBit) {
+            score--;
+        }
+
+        // 第 0 行恒为 0（匹配可以从任意位置开始），移位时不补 1
+        ph <<= 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        if (score <= m_maxEdits) {
+            if (score < bestScore) {
+                bestScore = score;
+                bestEnd = j;
+            }
+        } else if (bestEnd >= 0) {
+            break;      // 一段连续命中结束
+        }
+    }
+
+    *distance = bestScore;
+    return bestEnd;
+}
+
+qsizetype FuzzyMatcher::findEndDynamic(QStringView text, qsizetype from, int* distance) const
+{
+    const int patternLength = m_pattern.size();
+
+    // column[i]：模式前 i 个字符与以当前字符结尾的文本的最小编辑距离
+    QVector<int> column(patternLength + 1);
+    for (int i = 0; i <= patternLength; ++i) {
+        column[i] = i;
+    }
+
+    qsizetype bestEnd = -1;
+    int bestScore = m_maxEdits + 1;
+
+    for (qsizetype j = from; j < text.size(); ++j) {
+        const QChar ch = text[j];
+        int diagonal = column[0];
+        for (int i = 1; i <= patternLength; ++i) {
+            const int above = column[i];
+            column[i] = std::min({diagonal + (m_pattern[i - 1] != ch ? 1 : 0),
+                                  above + 1,
+                                  column[i - 1] + 1});
+            diagonal = above;
+        }
+
+        const int score = column[patternLength];
+        if (score <= m_maxEdits) {
+            if (score < bestScore) {
+                bestScore = score;
+                bestEnd = j;
+            }
+        } else if (bestEnd >= 0) {
+            break;
+        }
+    }
+
+    *distance = bestScore;
+    return bestEnd;
+}
+
+qsizetype FuzzyMatcher::findStart(QStringView text, qsizetype from, qsizetype end) const
+{
+    const int patternLength = m_pattern.size();
+
+    // 匹配的文本不会超过模式长度 + maxEdits
+    const qsizetype windowBegin = qMax(from, end - (patternLength + m_maxEdits) + 1);
+    const int window = int(end - windowBegin + 1);
+
+    // 从 end 向前，模式也从末尾向前对齐：row[j] 为模式后缀与文本末尾 j 个字符的距离
+    QVector<int> row(window + 1);
+    QVector<int> next(window + 1);
+    for (int j = 0; j <= window; ++j) {
+        row[j] = j;
+    }
+
+    for (int i = 1; i <= patternLength; ++i) {
+        const QChar patternChar = m_pattern[patternLength - i];
+        next[0] = i;
+        for (int j = 1; j <= window; ++j) {
+            next[j] = std::min({row[j - 1] + (patternChar != text[end - j + 1] ? 1 : 0),
+                                row[j] + 1,
+                                next[j - 1] + 1});
+        }
+        row.swap(next);
+    }
+
+    // 距离最小；相同时取长度最接近模式的
+    int bestLength = 0;
+    for (int j = 1; j <= window; ++j) {
+        if (row[j] < row[bestLength] ||
+            (row[j] == row[bestLength] &&
+             qAbs(j - patternLength) < qAbs(bestLength - patternLength))) {
+            bestLength = j;
+        }
+    }
+
+    return end - bestLength + 1;
+}
@@ -0,0 +1,74 @@
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QHash>
+#include <QString>
+#include <QStringView>
+#include <array>
+
+/**
+ * @brief 近似子串匹配（编辑距离：插入、删除、替换各计 1）
+ *
+ * 正向扫描使用 Myers 位并行算法：模式不超过 64 个字符时，每个文本字符
+ * 只需十几条整数运算即可得到以该字符结尾的最小编辑距离；更长的模式
+ * 退化为逐列动态规划（Sellers）。找到结束位置后，在长度不超过
+ * 模式长度 + maxEdits 的窗口内反向动态规划确定起点。
+ *
+ * 构造后只读，可以在多个线程中同时使用。
+ */
+class FuzzyMatcher
+{
+public:
+    FuzzyMatcher();
+
+    /**
+     * @param pattern 模式（调用方负责大小写折叠等规范化）
+     * @param maxEdits 允许的最大编辑距离，不超过模式长度 - 1
+     */
+    FuzzyMatcher(const QString& pattern, int maxEdits);
+
+    bool isValid() const { return !m_pattern.isEmpty(); }
+    int maxEdits() const { return m_maxEdits; }
+
+    /**
+     * @brief 查找从 from 开始的下一个近似匹配
+     *
+     * 连续多个结束位置都满足距离上限时，取其中距离最小、最靠前的一个；
+     * 匹配不会从 from 之前开始。
+     * @param start 输出：匹配起点
+     * @param length 输出：匹配长度
+     * @param distance 输出：编辑距离（可为空）
+     * @return 找不到时返回 false
+     */
+    bool findNext(QStringView text, qsizetype from,
+                  qsizetype* start, qsizetype* length, int* distance = nullptr) const;
+
+private:
+    /**
+     * @brief 字符在模式中出现位置的位掩码
+     */
+    quint64 peq(char16_t ch) const
+    {
+        if (ch < 128) {
+            return m_asciiPeq[ch];
+        }
+        return m_otherPeq.value(ch, 0);
+    }
+
+    qsizetype findEndBitParallel(QStringView text, qsizetype from, int* distance) const;
+    qsizetype findEndDynamic(QStringView text, qsizetype from, int* distance) const;
+
+    /**
+     * @brief 已知结束位置，反向求编辑距离最小的起点
+     */
+    qsizetype findStart(QStringView text, qsizetype from, qsizetype end) const;
+
+private:
+    QString m_pattern;
+    int m_maxEdits;
+
+    std::array<quint64, 128> m_asciiPeq;    ///< ASCII 字符直接查表
+    QHash<char16_t, quint64> m_otherPeq;    ///< 其他字符
+};
+
+#endif // FUZZYMATCHER_H
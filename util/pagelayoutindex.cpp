@@ -0,0 +1,121 @@
+#include "pagelayoutindex.h"
+#include <QtGlobal>
+
+void PageLayoutIndex::reset(const QVector<int>& heights, int gap)
+{
+    m_heights = heights;
+    m_gap = gap;
+
+    const int n = m_heights.size();
+    m_tree.fill(0, n + 1);
+
+    // O(n) 建树：每个节点把自己的和累加到父节点
+    for (int i = 1; i <= n; ++i) {
+        m_tree[i] += m_heights[i - 1] + m_gap;
+        int parent = i + (i & -i);
+        if (parent <= n) {
+            m_tree[parent] += m_tree[i];
+        }
+    }
+
+    m_highBit = 1;
+    while (m_highBit * 2 <= n) {
+        m_highBit *= 2;
+    }
+}
+
+void PageLayoutIndex::clear()
+{
+    m_heights.clear();
+    m_tree.clear();
+    m_gap = 0;
+    m_highBit = 0;
+}
+
+int PageLayoutIndex::pageTop(int pageIndex) const
+{
+    return int(prefixSum(qBound(0, pageIndex, pageCount())));
+}
+
+int PageLayoutIndex::totalHeight() const
+{
+    if (isEmpty()) {
+        return 0;
+    }
+    return int(prefixSum(pageCount()) - m_gap);
+}
+
+bool PageLayoutIndex::setPageHeight(int pageIndex, int height)
+{
+    if (pageIndex < 0 || pageIndex >= pageCount() || m_heights[pageIndex] == height) {
+        return false;
+    }
+
+    const int delta = height - m_heights[pageIndex];
+    m_heights[pageIndex] = height;
+
+    for (int i = pageIndex + 1; i <= pageCount(); i += i & -i) {
+        m_tree[i] += delta;
+    }
+    return true;
+}
+
+int PageLayoutIndex::pageAt(int y) const
+{
+    if (isEmpty()) {
+        return -1;
+    }
+
+    // 完整容纳在 y 之上的页数就是 y 所在（或其上方间距所属）页面的索引
+    return qMin(countFitting(y), pageCount() - 1);
+}
+
+bool PageLayoutIndex::pagesInRange(int top, int bottom, int* first, int* last) const
+{
+    if (isEmpty() || bottom < top) {
+        return false;
+    }
+
+    int firstPage = pageAt(top);
+    // top 落在页面之后的间距里时从下一页开始；
+    // 没有间距时上一页的底边与 top 重合，也算相交
+    if (pageTop(firstPage) + m_heights[firstPage] < top) {
+        firstPage++;
+    } else {
+        while (firstPage > 0 && pageTop(firstPage - 1) + m_heights[firstPage - 1] >= top) {
+            firstPage--;
+        }
+    }
+
+    int lastPage = pageAt(bottom);
+    if (firstPage >= pageCount() || firstPage > lastPage || pageTop(lastPage) > bottom) {
+        return false;
+    }
+
+    if (first) *first = firstPage;
+    if (last) *last = lastPage;
+    return true;
+}
+
+qint64 PageLayoutIndex::prefixSum(int count) const
+{
+    qint64 sum = 0;
+    for (int i = count; i > 0; i -= i & -i) {
+        sum += m_tree[i];
+    }
+    return sum;
+}
+
+int PageLayoutIndex::countFitting(qint64 y) const
+{
+    // 树上二分：自高位向低位确定前缀和不超过 y 的最大页数
+    int count = 0;
+    for (int step = m_highBit; step > 0; step /= 2) {
+        int next = count + step;
+        if (next <= pageCount() && m_tree[next] <= y) {
+            count = next;
+            y -= m_tree[next];
+        }
+    }
+    return count;
+}
@@ -0,0 +1,87 @@
+#ifndef PAGELAYOUTINDEX_H
+#define PAGELAYOUTINDEX_H
+
+#include <QVector>
+
+/**
+ * @brief 连续滚动模式的页面布局索引
+ *
+ * 页面自上而下排列，相邻页面之间有固定间距。用树状数组（Fenwick tree）
+ * 保存每页占用的高度（页高 + 间距）的前缀和：
+ * - 页面顶部位置、按 Y 坐标查找页面、区间内的页面：O(log n)
+ * - 单页高度变化（估算尺寸被实际尺寸替换）：O(log n)，不必重算整个布局
+ *
+ * 滚动、可见页面计算和绘制每帧的代价只与可见页数有关，与文档页数无关。
+ * 坐标均为布局坐标（不含外边距）。
+ */
+class PageLayoutIndex
+{
+public:
+    PageLayoutIndex() = default;
+
+    /**
+     * @brief 按页高重建索引（O(n)）
+     * @param heights 每页高度（像素）
+     * @param gap 页面间距（像素）
+     */
+    void reset(const QVector<int>& heights, int gap);
+
+    void clear();
+
+    int pageCount() const { return m_heights.size(); }
+    bool isEmpty() const { return m_heights.isEmpty(); }
+    int gap() const { return m_gap; }
+
+    /**
+     * @brief 页面顶部的 Y 坐标
+     */
+    int pageTop(int pageIndex) const;
+
+    /**
+     * @brief 页面高度
+     */
+    int pageHeight(int pageIndex) const { return m_heights[pageIndex]; }
+
+    /**
+     * @brief 布局总高度（最后一页底部，不含其后的间距）
+     */
+    int totalHeight() const;
+
+    /**
+     * @brief 更新单页高度
+     * @return 高度是否发生变化
+     */
+    bool setPageHeight(int pageIndex, int height);
+
+    /**
+     * @brief 顶部不低于 y 的最后一页（y 在第一页之上时返回 0，没有页面时返回 -1）
+     */
+    int pageAt(int y) const;
+
+    /**
+     * @brief 与 [top, bottom] 相交的页面区间
+     * @param first 输出：第一页
+     * @param last 输出：最后一页
+     * @return 是否有相交的页面
+     */
+    bool pagesInRange(int top, int bottom, int* first, int* last) const;
+
+private:
+    /**
+     * @brief 前 count 页占用的高度之和（含间距），即第 count 页的顶部
+     */
+    qint64 prefixSum(int count) const;
+
+    /**
+     * @brief 前缀和不超过 y 的最大页数
+     */
+    int countFitting(qint64 y) const;
+
+private:
+    QVector<int> m_heights;     ///< 每页高度
+    QVector<qint64> m_tree;     ///< 树状数组（下标从 1 开始），元素为页高 + 间距
+    int m_gap = 0;
+    int m_highBit = 0;          ///< 不超过页数的最大 2 的幂（用于树上二分）
+};
+
+#endif // PAGELAYOUTINDEX_H
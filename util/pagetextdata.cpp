@@ -0,0 +1,164 @@
+#include "pagetextdata.h"
+#include <QtGlobal>
+#include <algorithm>
+
+namespace {
+
+QChar normalizeChar(QChar ch)
+{
+    return ch.isSpace() ? QChar(u' ') : ch.toCaseFolded();
+}
+
+} // namespace
+
+QRectF PageTextData::charRect(int line, int charIndex) const
+{
+    const TextBox& box = m_lineBoxes[line];
+    const float start = m_charStart[charIndex];
+    const float end = m_charEnd[charIndex];
+
+    if (isVerticalLine(line)) {
+        return QRectF(QPointF(box.x0, start), QPointF(box.x1, end));
+    }
+    return QRectF(QPointF(start, box.y0), QPointF(end, box.y1));
+}
+
+QRectF PageTextData::charRangeRect(int line, int first, int last) const
+{
+    if (first > last) {
+        return QRectF();
+    }
+
+    float start = m_charStart[first];
+    float end = m_charEnd[first];
+    for (int c = first + 1; c <= last; ++c) {
+        start = qMin(start, m_charStart[c]);
+        end = qMax(end, m_charEnd[c]);
+    }
+
+    const TextBox& box = m_lineBoxes[line];
+    if (isVerticalLine(line)) {
+        return QRectF(QPointF(box.x0, start), QPointF(box.x1, end));
+    }
+    return QRectF(QPointF(start, box.y0), QPointF(end, box.y1));
+}
+
+int PageTextData::searchLineAt(int searchPos) const
+{
+    auto it = std::upper_bound(m_lineSearchBegin.begin(), m_lineSearchBegin.end(), searchPos);
+    return qMax(0, int(it - m_lineSearchBegin.begin()) - 1);
+}
+
+QString PageTextData::joinedText() const
+{
+    QString result(m_searchText.size(), u' ');
+    for (int line = 0; line < lineCount(); ++line) {
+        QStringView text = lineText(line);
+        std::copy(text.begin(), text.end(), result.begin() + lineSearchBegin(line));
+    }
+    return result;
+}
+
+bool PageTextData::isCJK(QChar ch)
+{
+    uint u = ch.unicode();
+    return (u >= 0x4E00 && u <= 0x9FFF) ||    // CJK Unified Ideographs
+           (u >= 0x3400 && u <= 0x4DBF) ||    // CJK Extension A
+           (u >= 0xF900 && u <= 0xFAFF) ||    // CJK Compatibility Ideographs
+           (u >= 0x3040 && u <= 0x30FF) ||    // Japanese Hiragana/Katakana
+           (u >= 0xAC00 && u <= 0xD7AF);      // Korean Hangul
+}
+
+QString PageTextData::normalizeForSearch(QStringView text)
+{
+    QString result(text.size(), Qt::Uninitialized);
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        result[i] = normalizeChar(text[i]);
+    }
+    return result;
+}
+
+qint64 PageTextData::memoryUsage() const
+{
+    return qint64(sizeof(PageTextData))
+        + (m_text.capacity() + m_searchText.capacity()) * qint64(sizeof(QChar))
+        + (m_charStart.capacity() + m_charEnd.capacity()) * qint64(sizeof(float))
+        + (m_lineChars.capacity() + m_blockLines.capacity() + m_lineSearchBegin.capacity())
+            * qint64(sizeof(int))
+        + (m_lineBoxes.capacity() + m_blockBoxes.capacity()) * qint64(sizeof(TextBox))
+        + m_lineFlags.capacity() * qint64(sizeof(quint8));
+}
+
+qint64 PageTextData::searchMemoryUsage() const
+{
+    return m_searchText.capacity() * qint64(sizeof(QChar))
+        + m_lineSearchBegin.capacity() * qint64(sizeof(int));
+}
+
+void PageTextData::beginBlock(const QRectF& bbox)
+{
+    m_blockLines.append(lineCount());
+    m_blockBoxes.append(TextBox(bbox));
+}
+
+void PageTextData::beginLine(const QRectF& bbox, bool vertical)
+{
+    m_lineChars.append(charCount());
+    m_lineBoxes.append(TextBox(bbox));
+    m_lineFlags.append(vertical ? VerticalLine : 0);
+}
+
+void PageTextData::appendChar(QChar character, const QRectF& bbox)
+{
+    const bool vertical = !m_lineFlags.isEmpty() && (m_lineFlags.last() & VerticalLine);
+
+    m_text.append(character);
+    if (vertical) {
+        m_charStart.append(float(bbox.top()));
+        m_charEnd.append(float(bbox.bottom()));
+    } else {
+        m_charStart.append(float(bbox.left()));
+        m_charEnd.append(float(bbox.right()));
+    }
+}
+
+void PageTextData::finish()
+{
+    m_text.squeeze();
+    m_charStart.squeeze();
+    m_charEnd.squeeze();
+    m_lineChars.squeeze();
+    m_lineBoxes.squeeze();
+    m_lineFlags.squeeze();
+    m_blockLines.squeeze();
+    m_blockBoxes.squeeze();
+
+    buildSearchText();
+}
+
+void PageTextData::buildSearchText()
+{
+    m_searchText.clear();
+    m_searchText.reserve(charCount() + lineCount());
+    m_lineSearchBegin.resize(lineCount());
+
+    for (int line = 0; line < lineCount(); ++line) {
+        QStringView text = lineText(line);
+
+        // 与上一行之间的分隔
+        if (!m_searchText.isEmpty() && !text.isEmpty()) {
+            QChar previous = m_searchText.back();
+            QChar next = text.front();
+            if (previous != u' ' && !next.isSpace() && !(isCJK(previous) && isCJK(next))) {
+                m_searchText.append(u' ');
+            }
+        }
+
+        m_lineSearchBegin[line] = m_searchText.size();
+        for (QChar ch : text) {
+            m_searchText.append(normalizeChar(ch));
+        }
+    }
+
+    m_searchText.squeeze();
+}
@@ -0,0 +1,287 @@
+#include "qoicodec.h"
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr int HEADER_SIZE = 14;
+constexpr int PADDING_SIZE = 8;
+constexpr uchar PADDING[PADDING_SIZE] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+constexpr uchar OP_INDEX = 0x00;
+constexpr uchar OP_DIFF = 0x40;
+constexpr uchar OP_LUMA = 0x80;
+constexpr uchar OP_RUN = 0xc0;
+constexpr uchar OP_RGB = 0xfe;
+constexpr uchar OP_RGBA = 0xff;
+constexpr uchar OP_MASK = 0xc0;
+
+constexpr int MAX_RUN = 62;
+
+struct Pixel {
+    uchar r = 0;
+    uchar g = 0;
+    uchar b = 0;
+    uchar a = 255;
+
+    bool operator==(const Pixel& other) const {
+        return r == other.r && g == other.g && b == other.b && a == other.a;
+    }
+    bool operator!=(const Pixel& other) const { return !(*this == other); }
+};
+
+inline int indexOf(const Pixel& px)
+{
+    return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+}
+
+inline void writeU32(uchar* out, quint32 value)
+{
+    out[0] = uchar(value >> 24);
+    out[1] = uchar(value >> 16);
+    out[2] = uchar(value >> 8);
+    out[3] = uchar(value);
+}
+
+inline quint32 readU32(const uchar* in)
+{
+    return (quint32(in[0]) << 24) | (quint32(in[1]) << 16) | (quint32(in[2]) << 8) | quint32(in[3]);
+}
+
+inline Pixel readPixel(const uchar* line, int x, bool packed888)
+{
+    Pixel px;
+    if (packed888) {
+        const uchar* p = line + x * 3;
+        px.r = p[0];
+        px.g = p[1];
+        px.b = p[2];
+    } else {
+        QRgb rgb = reinterpret_cast<const QRgb*>(line)[x];
+        px.r = uchar(qRed(rgb));
+        px.g = uchar(qGreen(rgb));
+        px.b = uchar(qBlue(rgb));
+        px.a = uchar(qAlpha(rgb));
+    }
+    return px;
+}
+
+inline void writePixel(uchar* line, int x, const Pixel& px, QImage::Format format)
+{
+    if (format == QImage::Format_RGB888) {
+        uchar* p = line + x * 3;
+        p[0] = px.r;
+        p[1] = px.g;
+        p[2] = px.b;
+    } else {
+        uchar alpha = (format == QImage::Format_RGB32) ? 255 : px.a;
+        reinterpret_cast<QRgb*>(line)[x] = qRgba(px.r, px.g, px.b, alpha);
+    }
+}
+
+bool isDirectFormat(QImage::Format format)
+{
+    return format == QImage::Format_RGB888 ||
+           format == QImage::Format_RGB32 ||
+           format == QImage::Format_ARGB32 ||
+           format == QImage::Format_ARGB32_Premultiplied;
+}
+
+} // namespace
+
+QByteArray QoiCodec::encode(const QImage& image)
+{
+    if (image.isNull()) {
+        return QByteArray();
+    }
+
+    QImage source = isDirectFormat(image.format())
+        ? image
+        : image.convertToFormat(QImage::Format_ARGB32);
+
+    const int width = source.width();
+    const int height = source.height();
+    const bool packed888 = (source.format() == QImage::Format_RGB888);
+    const int channels = (packed888 || source.format() == QImage::Format_RGB32) ? 3 : 4;
+
+    // 最坏情况：每个像素一个 OP_RGBA
+    const qint64 maxSize = HEADER_SIZE + qint64(width) * height * (channels + 1) + PADDING_SIZE;
+    QByteArray encoded(maxSize, Qt::Uninitialized);
+    uchar* out = reinterpret_cast<uchar*>(encoded.data());
+    qint64 pos = 0;
+
+    memcpy(out, "qoif", 4);
+    writeU32(out + 4, quint32(width));
+    writeU32(out + 8, quint32(height));
+    out[12] = uchar(channels);
+    out[13] = 0;    // sRGB
+    pos = HEADER_SIZE;
+
+    Pixel index[64] = {};
+    for (Pixel& px : index) {
+        px.a = 0;
+    }
+    Pixel prev;
+    int run = 0;
+
+    for (int y = 0; y < height; ++y) {
+        const uchar* line = source.constScanLine(y);
+
+        for (int x = 0; x < width; ++x) {
+            Pixel px = readPixel(line, x, packed888);
+
+            if (px == prev) {
+                if (++run == MAX_RUN) {
+                    out[pos++] = OP_RUN | uchar(run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0) {
+                out[pos++] = OP_RUN | uchar(run - 1);
+                run = 0;
+            }
+
+            int hash = indexOf(px);
+            if (index[hash] == px) {
+                out[pos++] = OP_INDEX | uchar(hash);
+            } else {
+                index[hash] = px;
+
+                if (px.a == prev.a) {
+                    // 分量差按 8 位回绕计算
+                    int vr = int8_t(px.r - prev.r);
+                    int vg = int8_t(px.g - prev.g);
+                    int vb = int8_t(px.b - prev.b);
+                    int vgr = vr - vg;
+                    int vgb = vb - vg;
+
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                        out[pos++] = OP_DIFF | uchar((vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                    } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+                        out[pos++] = OP_LUMA | uchar(vg + 32);
+                        out[pos++] = uchar((vgr + 8) << 4 | (vgb + 8));
+                    } else {
+                        out[pos++] = OP_RGB;
+                        out[pos++] = px.r;
+                        out[pos++] = px.g;
+                        out[pos++] = px.b;
+                    }
+                } else {
+                    out[pos++] = OP_RGBA;
+                    out[pos++] = px.r;
+                    out[pos++] = px.g;
+                    out[pos++] = px.b;
+                    out[pos++] = px.a;
+                }
+            }
+
+            prev = px;
+        }
+    }
+
+    if (run > 0) {
+        out[pos++] = OP_RUN | uchar(run - 1);
+    }
+
+    memcpy(out + pos, PADDING, PADDING_SIZE);
+    pos += PADDING_SIZE;
+
+    encoded.resize(pos);
+    encoded.squeeze();
+    return encoded;
+}
+
+QImage QoiCodec::decode(const QByteArray& data, QImage::Format format)
+{
+    if (data.size() < HEADER_SIZE + PADDING_SIZE) {
+        return QImage();
+    }
+
+    const uchar* in = reinterpret_cast<const uchar*>(data.constData());
+    if (memcmp(in, "qoif", 4) != 0) {
+        return QImage();
+    }
+
+    const quint32 width = readU32(in + 4);
+    const quint32 height = readU32(in + 8);
+    const int channels = in[12];
+    if (width == 0 || height == 0 || width > 65535 || height > 65535 ||
+        (channels != 3 && channels != 4)) {
+        return QImage();
+    }
+
+    if (format == QImage::Format_Invalid) {
+        format = (channels == 3) ? QImage::Format_RGB32 : QImage::Format_ARGB32;
+    }
+    QImage::Format decodeFormat = isDirectFormat(format) ? format : QImage::Format_ARGB32;
+
+    QImage image(int(width), int(height), decodeFormat);
+    if (image.isNull()) {
+        return QImage();
+    }
+
+    const qint64 chunksEnd = data.size() - PADDING_SIZE;
+    qint64 pos = HEADER_SIZE;
+
+    Pixel index[64] = {};
+    for (Pixel& px : index) {
+        px.a = 0;
+    }
+    Pixel px;
+    int run = 0;
+
+    for (quint32 y = 0; y < height; ++y) {
+        uchar* line = image.scanLine(int(y));
+
+        for (quint32 x = 0; x < width; ++x) {
+            if (run > 0) {
+                run--;
+            } else {
+                if (pos >= chunksEnd) {
+                    return QImage();
+                }
+
+                uchar b1 = in[pos++];
+
+                if (b1 == OP_RGB) {
+                    if (pos + 3 > chunksEnd) return QImage();
+                    px.r = in[pos++];
+                    px.g = in[pos++];
+                    px.b = in[pos++];
+                } else if (b1 == OP_RGBA) {
+                    if (pos + 4 > chunksEnd) return QImage();
+                    px.r = in[pos++];
+                    px.g = in[pos++];
+                    px.b = in[pos++];
+                    px.a = in[pos++];
+                } else if ((b1 & OP_MASK) == OP_INDEX) {
+                    px = index[b1];
+                } else if ((b1 & OP_MASK) == OP_DIFF) {
+                    px.r = uchar(px.r + ((b1 >> 4) & 0x03) - 2);
+                    px.g = uchar(px.g + ((b1 >> 2) & 0x03) - 2);
+                    px.b = uchar(px.b + (b1 & 0x03) - 2);
+                } else if ((b1 & OP_MASK) == OP_LUMA) {
+                    if (pos + 1 > chunksEnd) return QImage();
+                    uchar b2 = in[pos++];
+                    int vg = (b1 & 0x3f) - 32;
+                    px.r = uchar(px.r + vg - 8 + ((b2 >> 4) & 0x0f));
+                    px.g = uchar(px.g + vg);
+                    px.b = uchar(px.b + vg - 8 + (b2 & 0x0f));
+                } else {
+                    run = b1 & 0x3f;
+                }
+
+                index[indexOf(px)] = px;
+            }
+
+            writePixel(line, int(x), px, decodeFormat);
+        }
+    }
+
+    if (decodeFormat != format) {
+        image.convertTo(format);
+    }
+    return image;
+}
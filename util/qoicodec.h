@@ -0,0 +1,37 @@
+#ifndef QOICODEC_H
+#define QOICODEC_H
+
+#include <QByteArray>
+#include <QImage>
+
+/**
+ * @brief QOI（Quite OK Image）无损编解码
+ *
+ * 单遍扫描、无熵编码，编解码速度接近 memcpy 的量级，适合在内存中暂存渲染结果。
+ * 文字页面大面积同色，游程和索引操作占主导，通常可压缩到原始大小的 1/10 ~ 1/20。
+ *
+ * 输出遵循 QOI 规范（头部 + 数据块 + 结束标记），像素按 QImage 内存中的值
+ * 原样编码：预乘格式保存预乘后的分量，解码回同一格式时逐位一致。
+ */
+class QoiCodec
+{
+public:
+    /**
+     * @brief 编码图像
+     *
+     * Format_RGB888 / RGB32 按 3 通道、ARGB32 / ARGB32_Premultiplied 按 4 通道编码，
+     * 其他格式先转换为 ARGB32
+     * @return 编码后的数据，图像为空时返回空
+     */
+    static QByteArray encode(const QImage& image);
+
+    /**
+     * @brief 解码图像
+     * @param data encode() 的输出
+     * @param format 输出格式（通常为编码前的格式），Format_Invalid 时按通道数选择
+     * @return 图像，数据损坏时返回空QImage
+     */
+    static QImage decode(const QByteArray& data, QImage::Format format = QImage::Format_Invalid);
+};
+
+#endif // QOICODEC_H
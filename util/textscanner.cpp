@@ -0,0 +1,178 @@
+#include "textscanner.h"
+#include <QtGlobal>
+#include <QtAlgorithms>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MUQT_TEXTSCAN_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(MUQT_TEXTSCAN_SSE2) && (defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__))
+#define MUQT_TEXTSCAN_AVX2 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#define MUQT_TARGET_AVX2
+#else
+#define MUQT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+bool equalAt(const char16_t* text, const char16_t* pattern, qsizetype length)
+{
+    return std::memcmp(text, pattern, size_t(length) * sizeof(char16_t)) == 0;
+}
+
+qsizetype indexOfScalar(const char16_t* text, qsizetype textLength,
+                        const char16_t* pattern, qsizetype patternLength, qsizetype from)
+{
+    const char16_t first = pattern[0];
+    const qsizetype end = textLength - patternLength + 1;
+
+    for (qsizetype i = from; i < end; ++i) {
+        if (text[i] == first && equalAt(text + i, pattern, patternLength)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef MUQT_TEXTSCAN_SSE2
+
+qsizetype indexOfSse2(const char16_t* text, qsizetype textLength,
+                      const char16_t* pattern, qsizetype patternLength, qsizetype from)
+{
+    const __m128i first = _mm_set1_epi16(short(pattern[0]));
+    const __m128i last = _mm_set1_epi16(short(pattern[patternLength - 1]));
+    const qsizetype end = textLength - patternLength + 1;     // 候选起点的上界（不含）
+
+    qsizetype i = from;
+    for (; i + 8 <= end; i += 8) {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + patternLength - 1));
+        __m128i hit = _mm_and_si128(_mm_cmpeq_epi16(head, first), _mm_cmpeq_epi16(tail, last));
+
+        // 每个 16 位通道占掩码的两位
+        uint mask = uint(_mm_movemask_epi8(hit));
+        while (mask) {
+            const uint bit = qCountTrailingZeroBits(mask);
+            const qsizetype pos = i + bit / 2;
+            if (equalAt(text + pos, pattern, patternLength)) {
+                return pos;
+            }
+            mask &= ~(3u << bit);
+        }
+    }
+
+    return indexOfScalar(text, textLength, pattern, patternLength, i);
+}
+
+#endif // MUQT_TEXTSCAN_SSE2
+
+#ifdef MUQT_TEXTSCAN_AVX2
+
+MUQT_TARGET_AVX2
+qsizetype indexOfAvx2(const char16_t* text, qsizetype textLength,
+                      const char16_t* pattern, qsizetype patternLength, qsizetype from)
+{
+    const __m256i first = _mm256_set1_epi16(short(pattern[0]));
+    const __m256i last = _mm256_set1_epi16(short(pattern[patternLength - 1]));
+    const qsizetype end = textLength - patternLength + 1;
+
+    qsizetype i = from;
+    for (; i + 16 <= end; i += 16) {
+        __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + patternLength - 1));
+        __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi16(head, first), _mm256_cmpeq_epi16(tail, last));
+
+        uint mask = uint(_mm256_movemask_epi8(hit));
+        while (mask) {
+            const uint bit = qCountTrailingZeroBits(mask);
+            const qsizetype pos = i + bit / 2;
+            if (equalAt(text + pos, pattern, patternLength)) {
+                return pos;
+            }
+            mask &= ~(3u << bit);
+        }
+    }
+
+    // 尾部不足 16 个位置，交给 SSE2 / 标量
+    return indexOfSse2(text, textLength, pattern, patternLength, i);
+}
+
+bool cpuSupportsAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+
+    // 需要 CPU 支持 AVX，且操作系统保存 YMM 寄存器
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool hasAvx2()
+{
+    static const bool supported = cpuSupportsAvx2();
+    return supported;
+}
+
+#endif // MUQT_TEXTSCAN_AVX2
+
+} // namespace
+
+qsizetype TextScanner::indexOf(QStringView text, QStringView pattern, qsizetype from)
+{
+    const qsizetype textLength = text.size();
+    const qsizetype patternLength = pattern.size();
+
+    if (patternLength == 0 || from < 0 || patternLength > textLength - from) {
+        return -1;
+    }
+
+    const char16_t* textData = text.utf16();
+    const char16_t* patternData = pattern.utf16();
+
+#if defined(MUQT_TEXTSCAN_AVX2)
+    if (hasAvx2()) {
+        return indexOfAvx2(textData, textLength, patternData, patternLength, from);
+    }
+#endif
+#if defined(MUQT_TEXTSCAN_SSE2)
+    return indexOfSse2(textData, textLength, patternData, patternLength, from);
+#else
+    return indexOfScalar(textData, textLength, patternData, patternLength, from);
+#endif
+}
+
+QString TextScanner::instructionSet()
+{
+#if defined(MUQT_TEXTSCAN_AVX2)
+    if (hasAvx2()) {
+        return QStringLiteral("AVX2");
+    }
+#endif
+#if defined(MUQT_TEXTSCAN_SSE2)
+    return QStringLiteral("SSE2");
+#else
+    return QStringLiteral("scalar");
+#endif
+}
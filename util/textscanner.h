@@ -0,0 +1,32 @@
+#ifndef TEXTSCANNER_H
+#define TEXTSCANNER_H
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * @brief UTF-16 子串查找内核（逐字节精确比较，不做大小写转换）
+ *
+ * 每次比较一组候选位置：同时比较模式的首字符和末字符，两者都相等的位置
+ * 才逐字符验证，绝大多数位置一条向量指令即可排除。
+ * x86 上优先使用 AVX2（运行时检测，一次 16 个位置），其次 SSE2（8 个位置），
+ * 其他平台以及不足一组的尾部使用标量实现，结果完全一致。
+ *
+ * 大小写不敏感查找由调用方先把文本和模式折叠成同一形式（见 PageTextData::searchText()）。
+ */
+class TextScanner
+{
+public:
+    /**
+     * @brief 查找 pattern 在 text 中从 from 开始的第一次出现
+     * @return 位置，找不到（或 pattern 为空）时返回 -1
+     */
+    static qsizetype indexOf(QStringView text, QStringView pattern, qsizetype from = 0);
+
+    /**
+     * @brief 当前使用的指令集（"AVX2"、"SSE2" 或 "scalar"）
+     */
+    static QString instructionSet();
+};
+
+#endif // TEXTSCANNER_H